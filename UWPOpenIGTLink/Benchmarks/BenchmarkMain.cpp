@@ -0,0 +1,188 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+/*
+  Console benchmark of the library, prints the append rate and query latency of a buffer that spills to disk
+  and the throughput of the CRC64 used for the OpenIGTLink checksums.
+  Build Release, deploy the package, then run UWPOpenIGTLinkBenchmark.exe from a command prompt (the package registers the alias).
+*/
+
+#include "pch.h"
+#include "Crc64.h"
+
+// IGTL includes
+#include <igtl_util.h>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace UWPOpenIGTLink;
+using namespace Windows::Storage;
+
+namespace
+{
+  static const uint16 FRAME_WIDTH = 640;
+  static const uint16 FRAME_HEIGHT = 480;
+  static const uint32 NUMBER_OF_FRAMES = 1000;                              // ~300 MB of frames
+  static const uint32 BUFFER_SIZE = 64;
+  static const uint64 SEGMENT_SIZE_BYTES = 64 * 1024 * 1024;
+  static const float FRAME_PERIOD_SEC = 1.f / 30.f;
+  static const uint32 NUMBER_OF_QUERIES = 2000;
+  static const uint64 CRC_DATA_SIZE_BYTES = 64 * 1024 * 1024;
+  static const int CLOSEST_TIME = 2;                                        // DATA_ITEM_TEMPORAL_INTERPOLATION
+
+  typedef std::chrono::steady_clock Clock;
+
+  //----------------------------------------------------------------------------
+  double ElapsedSec(Clock::time_point start)
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  //----------------------------------------------------------------------------
+  // Query random times in [startTime, endTime] and print the mean and 99th percentile latency
+  void BenchmarkQueries(Buffer^ buffer, const std::string& name, float startTime, float endTime)
+  {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(startTime, endTime);
+    std::vector<double> latencies;
+    latencies.reserve(NUMBER_OF_QUERIES);
+    uint32 numberOfMisses(0);
+
+    for (uint32 i = 0; i < NUMBER_OF_QUERIES; ++i)
+    {
+      const float time = distribution(generator);
+      auto start = Clock::now();
+      auto item = buffer->GetStreamBufferItemFromTime(time, CLOSEST_TIME);
+      latencies.push_back(ElapsedSec(start));
+      if (item == nullptr)
+      {
+        numberOfMisses++;
+      }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    double sum(0.0);
+    for (auto latency : latencies)
+    {
+      sum += latency;
+    }
+
+    std::cout << name << " query: mean " << 1e6 * sum / latencies.size() << " us, p99 "
+              << 1e6 * latencies[latencies.size() * 99 / 100] << " us";
+    if (numberOfMisses > 0)
+    {
+      std::cout << " (" << numberOfMisses << " queries returned no item)";
+    }
+    std::cout << std::endl;
+  }
+
+  //----------------------------------------------------------------------------
+  void BenchmarkSpillToDisk()
+  {
+    auto buffer = ref new Buffer();
+    buffer->SetBufferSize(BUFFER_SIZE);
+    buffer->SetFrameSize(FRAME_WIDTH, FRAME_HEIGHT, 1);
+    buffer->SetPixelType(IGTL_SCALAR_UINT8);
+    buffer->SetNumberOfScalarComponents(1);
+    if (!buffer->EnableSpillToDisk(ApplicationData::Current->TemporaryFolder->Path, SEGMENT_SIZE_BYTES))
+    {
+      std::cerr << "Unable to enable spilling to disk." << std::endl;
+      return;
+    }
+
+    auto frameSize = ref new Platform::Array<uint16>(3);
+    frameSize[0] = FRAME_WIDTH;
+    frameSize[1] = FRAME_HEIGHT;
+    frameSize[2] = 1;
+    auto image = ref new Image();
+    image->AllocateScalars(frameSize, 1, IGTL_SCALAR_UINT8);
+
+    auto start = Clock::now();
+    for (uint32 i = 0; i < NUMBER_OF_FRAMES; ++i)
+    {
+      const float timestamp = i * FRAME_PERIOD_SEC;
+      if (!buffer->AddItem(image, buffer->GetImageOrientation(), buffer->GetImageType(), i, nullptr, nullptr, nullptr, timestamp, timestamp))
+      {
+        std::cerr << "Unable to add frame " << i << "." << std::endl;
+        return;
+      }
+    }
+    const double appendSec = ElapsedSec(start);
+    const double frameMegabytes = FRAME_WIDTH * FRAME_HEIGHT / (1024.0 * 1024.0);
+
+    std::cout << "Spill append: " << NUMBER_OF_FRAMES / appendSec << " frames/s, "
+              << NUMBER_OF_FRAMES * frameMegabytes / appendSec << " MB/s ("
+              << buffer->GetNumberOfSpilledItems() << " items spilled)" << std::endl;
+
+    // The buffer holds the latest BUFFER_SIZE frames, older ones are read back from the segments
+    const float oldestBufferedTime = (NUMBER_OF_FRAMES - BUFFER_SIZE + 1) * FRAME_PERIOD_SEC;
+    BenchmarkQueries(buffer, "Spilled", 0.f, oldestBufferedTime - FRAME_PERIOD_SEC);
+    BenchmarkQueries(buffer, "Buffered", oldestBufferedTime, (NUMBER_OF_FRAMES - 1) * FRAME_PERIOD_SEC);
+
+    buffer->Clear();
+  }
+
+  //----------------------------------------------------------------------------
+  void BenchmarkCrc64()
+  {
+    std::vector<byte> data(CRC_DATA_SIZE_BYTES);
+    std::mt19937 generator(42);
+    for (auto& value : data)
+    {
+      value = static_cast<byte>(generator());
+    }
+    const double megabytes = CRC_DATA_SIZE_BYTES / (1024.0 * 1024.0);
+
+    auto start = Clock::now();
+    const uint64 crc = Crc64(data.data(), data.size());
+    const double crcSec = ElapsedSec(start);
+
+    start = Clock::now();
+    const uint64 igtlCrc = crc64(data.data(), data.size(), 0ULL);
+    const double igtlCrcSec = ElapsedSec(start);
+
+    std::cout << "CRC64 (" << (Crc64IsAccelerated() ? "PCLMULQDQ" : "slicing-by-8") << "): " << megabytes / crcSec << " MB/s, "
+              << "igtl crc64: " << megabytes / igtlCrcSec << " MB/s" << (crc == igtlCrc ? "" : " (results differ!)") << std::endl;
+  }
+}
+
+//----------------------------------------------------------------------------
+[Platform::MTAThread]
+int main(Platform::Array<Platform::String^>^ args)
+{
+  std::cout << std::fixed << std::setprecision(1);
+
+  BenchmarkSpillToDisk();
+  BenchmarkCrc64();
+
+  return 0;
+}
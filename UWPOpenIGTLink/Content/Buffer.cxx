@@ -27,16 +27,55 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "Buffer.h"
 
+// System includes
+#include <malloc.h>
+
+// STL includes
+#include <algorithm>
+
 namespace
 {
   static const float NEGLIGIBLE_TIME_DIFFERENCE = 0.00001f; // in seconds, used for comparing between exact timestamps
   static const float ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG = 10.f; // if the interpolated orientation differs from both the interpolated orientation by more than this threshold then display a warning
+  static const uint64 FRAME_SLAB_ALIGNMENT = 4096; // page aligned slab
+  static const uint64 FRAME_SLOT_ALIGNMENT = 64; // every frame starts on its own cache line
 }
 
 using namespace Platform::Collections;
 using namespace Windows::Foundation::Collections;
 using namespace Windows::Foundation::Numerics;
 
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Rotation vector (axis * angle in radians) of a rotation
+  float3 ToRotationVector(const quaternion& rotation)
+  {
+    // q and -q are the same orientation, use the one with the smaller angle
+    const float sign = (rotation.w < 0.f) ? -1.f : 1.f;
+    const float3 axis(sign * rotation.x, sign * rotation.y, sign * rotation.z);
+    const float sinHalfAngle = length(axis);
+    if (sinHalfAngle < 1e-6f)
+    {
+      return 2.f * axis;
+    }
+    return axis * (2.f * atan2(sinHalfAngle, sign * rotation.w) / sinHalfAngle);
+  }
+
+  //----------------------------------------------------------------------------
+  // Rotation of a rotation vector (axis * angle in radians)
+  quaternion FromRotationVector(const float3& rotationVector)
+  {
+    const float angle = length(rotationVector);
+    if (angle < 1e-6f)
+    {
+      return normalize(quaternion(0.5f * rotationVector.x, 0.5f * rotationVector.y, 0.5f * rotationVector.z, 1.f));
+    }
+    return make_quaternion_from_axis_angle(rotationVector / angle, angle);
+  }
+
+}
+
 namespace UWPOpenIGTLink
 {
   //----------------------------------------------------------------------------
@@ -54,17 +93,66 @@ namespace UWPOpenIGTLink
   bool Buffer::AllocateMemoryForFrames()
   {
     std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
-    bool result = true;
 
-    for (uint32 i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
+    // Every add stores the image of the caller, so no frame storage is allocated here
+    for (BufferItemList::size_type i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
     {
-      if (this->StreamBuffer->GetBufferItemFromBufferIndex(i)->GetFrame()->AllocateFrame(this->GetFrameSize(), this->GetPixelType(), this->GetNumberOfScalarComponents()) != true)
+      // Items that already hold a received frame of the current format keep it
+      VideoFrame^ frame = this->StreamBuffer->GetBufferItemFromBufferIndex(i)->GetFrame();
+      if (frame->HasImage() && frame->GetImageDataInternal() != nullptr &&
+          frame->GetImage()->GetFrameSize() == this->FrameSize &&
+          frame->GetScalarPixelType() == this->PixelType &&
+          frame->GetNumberOfScalarComponents() == this->NumberOfScalarComponents)
       {
-        OutputDebugStringA((std::string("Failed to allocate memory for frame ") + std::to_string(i)).c_str());
-        result = false;
+        continue;
       }
+
+      // A new image without storage, the old one may still be shared with readers
+      Image^ image = ref new Image();
+      image->SetImageData(nullptr, this->GetNumberOfScalarComponents(), this->PixelType, this->FrameSize);
+      frame->ShallowCopy(image, this->ImageOrientation, this->ImageType);
     }
-    return result;
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool Buffer::FillBlank()
+  {
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+
+    const BufferItemList::size_type bufferSize = this->StreamBuffer->GetBufferSize();
+    const uint64 frameSizeBytes = static_cast<uint64>(this->GetNumberOfBytesPerPixel()) * this->FrameSize[0] * this->FrameSize[1] * this->FrameSize[2];
+    const uint64 strideBytes = (frameSizeBytes + FRAME_SLOT_ALIGNMENT - 1) / FRAME_SLOT_ALIGNMENT * FRAME_SLOT_ALIGNMENT;
+    const uint64 requiredBytes = strideBytes * bufferSize;
+    if (requiredBytes == 0)
+    {
+      OutputDebugStringA("Unable to fill frames to blank, frame format is not set.");
+      return false;
+    }
+
+    // Blank into new storage, the current frames may be shared with readers, pinned items or copies
+    byte* slab = static_cast<byte*>(_aligned_malloc(static_cast<size_t>(requiredBytes), static_cast<size_t>(FRAME_SLAB_ALIGNMENT)));
+    if (slab == nullptr)
+    {
+      OutputDebugStringA((std::string("Failed to allocate memory for ") + std::to_string(bufferSize) + " frames (" + std::to_string(requiredBytes) + " bytes)").c_str());
+      return false;
+    }
+    memset(slab, 0, static_cast<size_t>(requiredBytes));
+    std::shared_ptr<byte> slabData(slab, [](byte * p)
+    {
+      _aligned_free(p);
+    });
+
+    for (BufferItemList::size_type i = 0; i < bufferSize; ++i)
+    {
+      // Alias into the slab, the slab is freed with the last blank frame
+      Image^ image = ref new Image();
+      image->SetImageData(std::shared_ptr<byte>(slabData, slab + i * strideBytes), this->GetNumberOfScalarComponents(), this->PixelType, this->FrameSize);
+      this->StreamBuffer->GetBufferItemFromBufferIndex(i)->GetFrame()->ShallowCopy(image, this->ImageOrientation, this->ImageType);
+    }
+
+    return true;
   }
 
   //----------------------------------------------------------------------------
@@ -178,13 +266,13 @@ namespace UWPOpenIGTLink
       return false;
     }
 
-    if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
+    if (IsUndefinedTimestamp(unfilteredTimestamp))
     {
       Calendar->SetToNow();
       unfilteredTimestamp = 0.001f * Calendar->GetDateTime().UniversalTime;
     }
 
-    if (filteredTimestamp == UNDEFINED_TIMESTAMP)
+    if (IsUndefinedTimestamp(filteredTimestamp))
     {
       bool filteredTimestampProbablyValid = true;
       if (this->StreamBuffer->CreateFilteredTimeStampForItem(frameNumber, unfilteredTimestamp, &filteredTimestamp, &filteredTimestampProbablyValid) != true)
@@ -200,6 +288,7 @@ namespace UWPOpenIGTLink
       }
     }
 
+    // Checked before a slot is prepared, a rejected frame leaves the buffer untouched
     auto frameSize = image->GetFrameSize();
     if (!this->CheckFrameFormat(frameSize, image->ScalarType, imageType, image->NumberOfScalarComponents))
     {
@@ -222,16 +311,7 @@ namespace UWPOpenIGTLink
     if (newObjectInBuffer == nullptr)
     {
       OutputDebugStringA("Buffer: Failed to get pointer to video buffer object from the video buffer for the new frame!");
-      return false;
-    }
-
-    const auto& bufferItemFrameSize = newObjectInBuffer->GetFrame()->GetDimensions();
-
-    if (frameSize[0] != bufferItemFrameSize[0] || frameSize[1] != bufferItemFrameSize[1] || frameSize[2] != bufferItemFrameSize[2])
-    {
-      std::stringstream ss;
-      ss << "Input frame size is different from buffer frame size (input: " << frameSize[0] << "x" << frameSize[1] << "x" << frameSize[2] << ",   buffer: " << bufferItemFrameSize[0] << "x" << bufferItemFrameSize[1] << "x" << bufferItemFrameSize[2] << ")!";
-      OutputDebugStringA(ss.str().c_str());
+      this->StreamBuffer->AbortNewItem(bufferIndex);
       return false;
     }
 
@@ -245,16 +325,14 @@ namespace UWPOpenIGTLink
     newObjectInBuffer->GetFrame()->SetImageType(imageType);
 
     // Add custom fields
-    for (auto field : frameFields)
+    if (newObjectInBuffer->SetCustomFrameFieldsInternal(frameFields))
     {
-      newObjectInBuffer->SetCustomFrameField(field->Key, field->Value);
-      std::wstring name(field->Key->Data());
-      if (name.find(L"Transform") != std::string::npos)
-      {
-        newObjectInBuffer->SetValidTransformData(true);
-      }
+      newObjectInBuffer->SetValidTransformData(true);
     }
 
+    this->StreamBuffer->CommitNewItem(bufferIndex);
+    this->SpillItem(newObjectInBuffer);
+
     return true;
   }
 
@@ -284,12 +362,12 @@ namespace UWPOpenIGTLink
       return true;
     }
 
-    if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
+    if (IsUndefinedTimestamp(unfilteredTimestamp))
     {
       Calendar->SetToNow();
       unfilteredTimestamp = 0.001f * Calendar->GetDateTime().UniversalTime;
     }
-    if (filteredTimestamp == UNDEFINED_TIMESTAMP)
+    if (IsUndefinedTimestamp(filteredTimestamp))
     {
       bool filteredTimestampProbablyValid = true;
       if (this->StreamBuffer->CreateFilteredTimeStampForItem(frameNumber, unfilteredTimestamp, &filteredTimestamp, &filteredTimestampProbablyValid) != true)
@@ -321,6 +399,7 @@ namespace UWPOpenIGTLink
     if (newObjectInBuffer == nullptr)
     {
       OutputDebugStringA("Buffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
+      this->StreamBuffer->AbortNewItem(bufferIndex);
       return false;
     }
 
@@ -330,28 +409,26 @@ namespace UWPOpenIGTLink
     newObjectInBuffer->SetUid(itemUid);
 
     // Add custom fields
-    for (auto field : frameFields)
+    if (newObjectInBuffer->SetCustomFrameFieldsInternal(frameFields))
     {
-      newObjectInBuffer->SetCustomFrameField(field->Key, field->Value);
-      std::wstring name(field->Key->Data());
-      if (name.find(L"Transform") != std::string::npos)
-      {
-        newObjectInBuffer->SetValidTransformData(true);
-      }
+      newObjectInBuffer->SetValidTransformData(true);
     }
 
+    this->StreamBuffer->CommitNewItem(bufferIndex);
+    this->SpillItem(newObjectInBuffer);
+
     return true;
   }
 
   //----------------------------------------------------------------------------
   bool Buffer::AddTimeStampedItem(float4x4 matrix, int toolStatus, uint32 frameNumber, float unfilteredTimestamp, FrameFieldsABI^ customFields, float filteredTimestamp)
   {
-    if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
+    if (IsUndefinedTimestamp(unfilteredTimestamp))
     {
       Calendar->SetToNow();
       unfilteredTimestamp = 0.001f * Calendar->GetDateTime().UniversalTime;
     }
-    if (filteredTimestamp == UNDEFINED_TIMESTAMP)
+    if (IsUndefinedTimestamp(filteredTimestamp))
     {
       bool filteredTimestampProbablyValid = true;
       if (this->StreamBuffer->CreateFilteredTimeStampForItem(frameNumber, unfilteredTimestamp, &filteredTimestamp, &filteredTimestampProbablyValid) != true)
@@ -383,123 +460,57 @@ namespace UWPOpenIGTLink
     if (newObjectInBuffer == nullptr)
     {
       OutputDebugStringA("Buffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
+      this->StreamBuffer->AbortNewItem(bufferIndex);
       return false;
     }
 
     bool itemStatus = newObjectInBuffer->SetMatrix(matrix);
-    newObjectInBuffer->SetStatus(itemStatus);
+    newObjectInBuffer->SetStatus(toolStatus);
     newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
     newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
     newObjectInBuffer->SetIndex(frameNumber);
     newObjectInBuffer->SetUid(itemUid);
 
     // Add custom fields
-    for (auto field : customFields)
+    if (newObjectInBuffer->SetCustomFrameFieldsInternal(customFields))
     {
-      newObjectInBuffer->SetCustomFrameField(field->Key, field->Value);
-      std::wstring name(field->Key->Data());
-      if (name.find(L"Transform") != std::string::npos)
-      {
-        newObjectInBuffer->SetValidTransformData(true);
-      }
+      newObjectInBuffer->SetValidTransformData(true);
     }
 
+    this->StreamBuffer->CommitNewItem(bufferIndex);
+    this->SpillItem(newObjectInBuffer);
+
     return itemStatus;
   }
 
   //----------------------------------------------------------------------------
   int Buffer::GetLatestTimeStamp(float* latestTimestamp)
   {
-    try
-    {
-      *latestTimestamp = this->StreamBuffer->GetLatestTimeStamp();
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableAnymoreException&)
-    {
-      return ITEM_NOT_AVAILABLE_ANYMORE;
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableYetException&)
-    {
-      return ITEM_NOT_AVAILABLE_YET;
-    }
-
-    return ITEM_OK;
+    return this->StreamBuffer->GetLatestTimeStampInternal(*latestTimestamp);
   }
 
   //----------------------------------------------------------------------------
   int Buffer::GetOldestTimeStamp(float* oldestTimestamp)
   {
-    try
-    {
-      *oldestTimestamp = this->StreamBuffer->GetOldestTimeStamp();
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableAnymoreException&)
-    {
-      return ITEM_NOT_AVAILABLE_ANYMORE;
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableYetException&)
-    {
-      return ITEM_NOT_AVAILABLE_YET;
-    }
-
-    return ITEM_OK;
+    return this->StreamBuffer->GetOldestTimeStampInternal(*oldestTimestamp);
   }
 
   //----------------------------------------------------------------------------
   int Buffer::GetTimeStamp(BufferItemUidType uid, float* timestamp)
   {
-    try
-    {
-      *timestamp = this->StreamBuffer->GetTimeStamp(uid);
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableAnymoreException&)
-    {
-      return ITEM_NOT_AVAILABLE_ANYMORE;
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableYetException&)
-    {
-      return ITEM_NOT_AVAILABLE_YET;
-    }
-
-    return ITEM_OK;
+    return this->StreamBuffer->GetTimeStampInternal(uid, *timestamp);
   }
 
   //----------------------------------------------------------------------------
   int Buffer::GetIndex(BufferItemUidType uid, BufferItemList::size_type* index)
   {
-    try
-    {
-      *index = this->StreamBuffer->GetIndex(uid);
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableAnymoreException&)
-    {
-      return ITEM_NOT_AVAILABLE_ANYMORE;
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableYetException&)
-    {
-      return ITEM_NOT_AVAILABLE_YET;
-    }
-
-    return ITEM_OK;
+    return this->StreamBuffer->GetIndexInternal(uid, *index);
   }
 
   //----------------------------------------------------------------------------
   int Buffer::GetBufferIndexFromTime(float time, BufferItemList::size_type* bufferIndex)
   {
-    try
-    {
-      *bufferIndex = this->StreamBuffer->GetBufferIndexFromTime(time);
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableAnymoreException&)
-    {
-      return ITEM_NOT_AVAILABLE_ANYMORE;
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableYetException&)
-    {
-      return ITEM_NOT_AVAILABLE_YET;
-    }
-
-    return ITEM_OK;
+    return this->StreamBuffer->GetBufferIndexFromTimeInternal(time, *bufferIndex);
   }
 
   //----------------------------------------------------------------------------
@@ -563,7 +574,68 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   void Buffer::Clear()
   {
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
     this->StreamBuffer->Clear();
+    if (this->SpillStore != nullptr)
+    {
+      // Timestamps may restart after clearing, so the recording starts over
+      if (!this->SpillStore->Clear())
+      {
+        OutputDebugStringA("Buffer: Unable to restart the spilled recording, spilling to disk is disabled.");
+        this->SpillStore = nullptr;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void Buffer::SpillItem(StreamBufferItem^ item)
+  {
+    if (this->SpillStore == nullptr)
+    {
+      return;
+    }
+
+    // A recording with gaps is not a recording, stop spilling so IsSpillToDiskEnabled reports it
+    if (!this->SpillStore->Append(item))
+    {
+      OutputDebugStringA("Buffer: Unable to spill item to disk, spilling to disk is disabled.");
+      this->SpillStore = nullptr;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool Buffer::EnableSpillToDisk(Platform::String^ directory, uint64 segmentSizeBytes)
+  {
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    auto spillStore = std::make_unique<FrameSpillStore>();
+    if (directory == nullptr || !spillStore->Open(directory->Data(), segmentSizeBytes))
+    {
+      OutputDebugStringA("Buffer: Unable to enable spilling to disk.");
+      return false;
+    }
+    this->SpillStore = std::move(spillStore);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void Buffer::DisableSpillToDisk()
+  {
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    this->SpillStore = nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  bool Buffer::IsSpillToDiskEnabled()
+  {
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    return this->SpillStore != nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Buffer::GetNumberOfSpilledItems()
+  {
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    return this->SpillStore == nullptr ? 0 : this->SpillStore->GetNumberOfItems();
   }
 
   //----------------------------------------------------------------------------
@@ -680,20 +752,7 @@ namespace UWPOpenIGTLink
 
     // outItemA is the item that is the closest to the requested time, get its UID and time
     BufferItemUidType itemAuid(0);
-    ItemStatus status;
-    try
-    {
-      itemAuid = this->StreamBuffer->GetItemUidFromTime(time);
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableAnymoreException&)
-    {
-      status = ITEM_NOT_AVAILABLE_ANYMORE;
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableYetException&)
-    {
-      status = ITEM_NOT_AVAILABLE_YET;
-    }
-
+    ItemStatus status = this->StreamBuffer->GetItemUidFromTimeInternal(time, itemAuid);
     if (status != ITEM_OK)
     {
       switch (status)
@@ -718,11 +777,7 @@ namespace UWPOpenIGTLink
       return nullptr;
     }
 
-    try
-    {
-      itemA = this->GetStreamBufferItem(itemAuid);
-    }
-    catch (const std::exception&)
+    if (this->StreamBuffer->GetBufferItemFromUidInternal(itemAuid, itemA) != ITEM_OK)
     {
       OutputDebugStringA((std::string("Buffer: Failed to get data buffer item with id: ") + std::to_string(itemAuid)).c_str());
       return nullptr;
@@ -739,11 +794,7 @@ namespace UWPOpenIGTLink
     }
 
     float itemAtime(0);
-    try
-    {
-      itemAtime = this->StreamBuffer->GetTimeStamp(itemAuid);
-    }
-    catch (const std::exception&)
+    if (this->StreamBuffer->GetTimeStampInternal(itemAuid, itemAtime) != ITEM_OK)
     {
       std::stringstream ss;
       ss << "Buffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemAuid << ")";
@@ -793,15 +844,7 @@ namespace UWPOpenIGTLink
 
     // Get item B details
     float itemBtime(0);
-    try
-    {
-      itemBtime = this->StreamBuffer->GetTimeStamp(itemBuid);
-    }
-    catch (const std::exception&)
-    {
-      status = ITEM_UNKNOWN_ERROR;
-    }
-
+    status = this->StreamBuffer->GetTimeStampInternal(itemBuid, itemBtime);
     if (status != ITEM_OK)
     {
       std::stringstream ss;
@@ -820,15 +863,7 @@ namespace UWPOpenIGTLink
     }
 
     // Get the item
-    try
-    {
-      itemB = this->GetStreamBufferItem(itemBuid);
-    }
-    catch (const std::exception&)
-    {
-      status = ITEM_UNKNOWN_ERROR;
-    }
-
+    status = this->StreamBuffer->GetBufferItemFromUidInternal(itemBuid, itemB);
     if (status != ITEM_OK)
     {
       std::stringstream ss;
@@ -853,6 +888,16 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   StreamBufferItem^ Buffer::GetStreamBufferItemFromTime(float time, int interpolation)
   {
+    {
+      // Items older than the buffer are only available from the spill store
+      std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+      float oldestTimestamp(0.f);
+      if (this->SpillStore != nullptr && this->StreamBuffer->GetOldestTimeStampInternal(oldestTimestamp) == ITEM_OK && time < oldestTimestamp)
+      {
+        return GetSpilledStreamBufferItemFromTime(time, (DATA_ITEM_TEMPORAL_INTERPOLATION)interpolation);
+      }
+    }
+
     switch ((DATA_ITEM_TEMPORAL_INTERPOLATION)interpolation)
     {
       case EXACT_TIME:
@@ -861,6 +906,8 @@ namespace UWPOpenIGTLink
         return GetInterpolatedStreamBufferItemFromTime(time);
       case CLOSEST_TIME:
         return GetStreamBufferItemFromClosestTime(time);
+      case EXTRAPOLATED:
+        return GetExtrapolatedStreamBufferItemFromTime(time, nullptr);
       default:
         std::stringstream ss;
         ss << "Unknown interpolation type: " << interpolation << ". Defaulting to exact time request.";
@@ -872,220 +919,536 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   bool Buffer::ModifyBufferItemFrameField(BufferItemUidType uid, Platform::String^ key, Platform::String^ value)
   {
-    try
-    {
-      StreamBufferItem^ item = this->StreamBuffer->GetBufferItemFromUid(uid);
-      item->SetCustomFrameField(key, value);
-    }
-    catch (const std::exception&)
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    StreamBufferItem^ item;
+    if (this->StreamBuffer->GetBufferItemFromUidInternal(uid, item) != ITEM_OK)
     {
       std::stringstream ss;
-      ss << "Buffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ")";
+      ss << "Buffer: Failed to get data buffer item with uid: " << uid;
       OutputDebugStringA(ss.str().c_str());
       return false;
     }
 
+    item->SetCustomFrameField(key, value);
     return true;
   }
 
   //----------------------------------------------------------------------------
-  StreamBufferItem^ Buffer::GetStreamBufferItemFromExactTime(float time)
+  StreamBufferItem^ Buffer::PinStreamBufferItem(BufferItemUidType uid)
   {
-    try
+    StreamBufferItem^ item = nullptr;
+    if (this->StreamBuffer->PinItemInternal(uid, item) != ITEM_OK)
     {
-      std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
-      StreamBufferItem^ item = GetStreamBufferItemFromClosestTime(time);
+      std::stringstream ss;
+      ss << "Buffer: Failed to pin data buffer item with uid: " << uid;
+      OutputDebugStringA(ss.str().c_str());
+      return nullptr;
+    }
+    return item;
+  }
 
-      // If the time difference is not negligible then return with failure
-      float itemTime = item->GetFilteredTimestamp(this->StreamBuffer->GetLocalTimeOffsetSec());
-      if (fabs(itemTime - time) > NEGLIGIBLE_TIME_DIFFERENCE)
-      {
-        std::stringstream ss;
-        ss << "Buffer: Cannot find an item exactly at the requested time (requested time: " << std::fixed << time << ", item time: " << itemTime << ")";
-        OutputDebugStringA(ss.str().c_str());
-        return nullptr;
-      }
+  //----------------------------------------------------------------------------
+  StreamBufferItem^ Buffer::PinStreamBufferItemFromTime(float time)
+  {
+    StreamBufferItem^ item = nullptr;
+    if (this->StreamBuffer->PinItemFromTimeInternal(time, item) != ITEM_OK)
+    {
+      std::stringstream ss;
+      ss << "Buffer: Failed to pin data buffer item (time: " << std::fixed << time << ")";
+      OutputDebugStringA(ss.str().c_str());
+      return nullptr;
+    }
+    return item;
+  }
 
-      return item;
+  //----------------------------------------------------------------------------
+  void Buffer::UnpinStreamBufferItem(StreamBufferItem^ item)
+  {
+    if (item != nullptr)
+    {
+      item->UnpinInternal();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  StreamBufferItem^ Buffer::GetStreamBufferItemFromExactTime(float time)
+  {
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    StreamBufferItem^ item = GetStreamBufferItemFromClosestTime(time);
+    if (item == nullptr)
+    {
+      return nullptr;
     }
-    catch (const std::exception&)
+
+    // If the time difference is not negligible then return with failure
+    float itemTime = item->GetFilteredTimestamp(this->StreamBuffer->GetLocalTimeOffsetSec());
+    if (fabs(itemTime - time) > NEGLIGIBLE_TIME_DIFFERENCE)
     {
       std::stringstream ss;
-      ss << "Buffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ")";
+      ss << "Buffer: Cannot find an item exactly at the requested time (requested time: " << std::fixed << time << ", item time: " << itemTime << ")";
       OutputDebugStringA(ss.str().c_str());
       return nullptr;
     }
+
+    return item;
   }
 
   //----------------------------------------------------------------------------
   StreamBufferItem^ Buffer::GetStreamBufferItemFromClosestTime(float time)
   {
-    try
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    BufferItemUidType uid(0);
+    StreamBufferItem^ item;
+    if (this->StreamBuffer->GetItemUidFromTimeInternal(time, uid) != ITEM_OK || this->StreamBuffer->GetBufferItemFromUidInternal(uid, item) != ITEM_OK)
     {
-      std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
-      BufferItemUidType uid = this->StreamBuffer->GetItemUidFromTime(time);
-      return this->GetStreamBufferItem(uid);
+      std::stringstream ss;
+      ss << "Buffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ")";
+      OutputDebugStringA(ss.str().c_str());
+      return nullptr;
     }
-    catch (const std::exception&)
+    return item;
+  }
+
+  //----------------------------------------------------------------------------
+  StreamBufferItem^ Buffer::GetSpilledStreamBufferItemFromTime(float time, DATA_ITEM_TEMPORAL_INTERPOLATION interpolation)
+  {
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    const float localTime = time - this->StreamBuffer->GetLocalTimeOffsetSec();   // the spill store is indexed in local time
+    uint64 itemAindex(0);
+    StreamBufferItem^ item = nullptr;
+    if (!this->SpillStore->FindClosestItem(localTime, itemAindex) || (item = this->SpillStore->GetItem(itemAindex)) == nullptr)
     {
       std::stringstream ss;
-      ss << "Buffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ")";
+      ss << "Buffer: Failed to get spilled data buffer item (time: " << std::fixed << time << ")";
       OutputDebugStringA(ss.str().c_str());
       return nullptr;
     }
+
+    const SpilledItemRecord& itemA = this->SpillStore->GetRecord(itemAindex);
+    if (fabs(itemA.FilteredTimestamp - localTime) < NEGLIGIBLE_TIME_DIFFERENCE || interpolation == CLOSEST_TIME)
+    {
+      return item;
+    }
+    if (interpolation != INTERPOLATED && interpolation != EXTRAPOLATED)
+    {
+      std::stringstream ss;
+      ss << "Buffer: Cannot find a spilled item exactly at the requested time (requested time: " << std::fixed << time << ", item time: " << itemA.FilteredTimestamp + this->StreamBuffer->GetLocalTimeOffsetSec() << ")";
+      OutputDebugStringA(ss.str().c_str());
+      return nullptr;
+    }
+
+    // Same rules as GetPrevNextBufferItemFromTime: both neighbors must be valid and close enough to the requested time
+    item->SetFilteredTimestamp(localTime);
+    const bool itemBisOlder = localTime < itemA.FilteredTimestamp;
+    if ((itemBisOlder && itemAindex == 0) || (!itemBisOlder && itemAindex + 1 >= this->SpillStore->GetNumberOfItems()))
+    {
+      item->SetUnfilteredTimestamp(localTime);
+      item->SetStatus(TOOL_MISSING);
+      return item;
+    }
+    const SpilledItemRecord& itemB = this->SpillStore->GetRecord(itemBisOlder ? itemAindex - 1 : itemAindex + 1);
+    if (itemA.Status != TOOL_OK || itemB.Status != TOOL_OK
+        || fabs(itemA.FilteredTimestamp - localTime) > this->GetMaxAllowedTimeDifference()
+        || fabs(itemB.FilteredTimestamp - localTime) > this->GetMaxAllowedTimeDifference())
+    {
+      item->SetUnfilteredTimestamp(localTime);
+      item->SetStatus(TOOL_MISSING);
+      return item;
+    }
+
+    float itemAweight = fabs(itemB.FilteredTimestamp - localTime) / fabs(itemA.FilteredTimestamp - itemB.FilteredTimestamp);
+    float itemBweight = 1 - itemAweight;
+    float3 interpolatedScale;
+    quaternion interpolatedRotation;
+    float3 interpolatedTranslation;
+    auto interpolatedMatrix = InterpolateDecomposedMatrix(itemA.Scale, itemA.Rotation, itemA.Translation,
+                              itemB.Scale, itemB.Rotation, itemB.Translation, itemBweight,
+                              interpolatedScale, interpolatedRotation, interpolatedTranslation);
+    item->SetMatrixInternal(interpolatedMatrix, interpolatedRotation, interpolatedTranslation, interpolatedScale);
+    item->SetUnfilteredTimestamp(itemA.UnfilteredTimestamp * itemAweight + itemB.UnfilteredTimestamp * itemBweight);
+    return item;
   }
 
   //----------------------------------------------------------------------------
   // Interpolate the matrix for the given timestamp from the two nearest
   // transforms in the buffer.
-  // The rotation is interpolated with SLERP interpolation, and the
-  // position is interpolated with linear interpolation.
+  // The rotation is interpolated with NLERP/SLERP interpolation, and the
+  // position is interpolated with linear interpolation, using the rotation and
+  // translation precomputed when the items were added.
   // The flags correspond to the closest element.
   StreamBufferItem^ Buffer::GetInterpolatedStreamBufferItemFromTime(float time)
   {
-    StreamBufferItem^ bufferItem;
-    StreamBufferItem^ itemA;
-    StreamBufferItem^ itemB;
+    // Items A and B must not be overwritten while they are read
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    const float localTimeOffsetSec = this->StreamBuffer->GetLocalTimeOffsetSec();
+    StreamBufferItem^ bufferItem = ref new StreamBufferItem();
 
     auto vec = GetPrevNextBufferItemFromTime(time);
-    if (vec != nullptr)
+    if (vec == nullptr)
     {
-      itemA = vec->GetAt(0);
-      itemB = vec->GetAt(1);
-
       // cannot get two neighbors, so cannot do interpolation
       // it may be normal (e.g., when tracker out of view), so don't return with an error
-      try
-      {
-        bufferItem = GetStreamBufferItemFromClosestTime(time);
-        // Update the timestamp to match the requested time
-        bufferItem->SetFilteredTimestamp(time);
-        bufferItem->SetUnfilteredTimestamp(time);
-        bufferItem->SetStatus(TOOL_MISSING);   // if we return at any point due to an error then it means that the interpolation is not successful, so the item is missing
-        return bufferItem;
-      }
-      catch (const std::exception&)
+      StreamBufferItem^ closestItem = GetStreamBufferItemFromClosestTime(time);
+      if (closestItem == nullptr)
       {
-        std::stringstream ss;
-        ss << "Buffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ")";
-        OutputDebugStringA(ss.str().c_str());
         return nullptr;
       }
+      bufferItem->ShallowCopyInternal(closestItem, false);
+      // Update the timestamp to match the requested time
+      bufferItem->SetFilteredTimestamp(time - localTimeOffsetSec);
+      bufferItem->SetUnfilteredTimestamp(time - localTimeOffsetSec);
+      bufferItem->SetStatus(TOOL_MISSING);   // if we return at any point due to an error then it means that the interpolation is not successful, so the item is missing
+      return bufferItem;
     }
 
+    StreamBufferItem^ itemA = vec->GetAt(0);
+    StreamBufferItem^ itemB = vec->GetAt(1);
+
+    // The result shares the frame of itemA, adding items replaces the frame of a slot instead of writing its pixels
     if (itemA->GetUid() == itemB->GetUid())
     {
       // exact match, no need for interpolation
-      bufferItem->DeepCopy(itemA);
+      bufferItem->ShallowCopyInternal(itemA, false);
       return bufferItem;
     }
 
     //============== Get item weights ==================
 
-    float itemAtime(0);
-    try
+    float itemAtime = itemA->GetFilteredTimestamp(localTimeOffsetSec);
+    float itemBtime = itemB->GetFilteredTimestamp(localTimeOffsetSec);
+
+    if (fabs(itemAtime - itemBtime) < NEGLIGIBLE_TIME_DIFFERENCE)
     {
-      itemAtime = this->StreamBuffer->GetTimeStamp(itemA->GetUid());
+      // exact time match, no need for interpolation
+      bufferItem->ShallowCopyInternal(itemA, false);
+      bufferItem->SetFilteredTimestamp(time - localTimeOffsetSec);
+      bufferItem->SetUnfilteredTimestamp(time - localTimeOffsetSec);
+      return bufferItem;
     }
-    catch (const std::exception&)
+
+    float itemAweight = fabs(itemBtime - time) / fabs(itemAtime - itemBtime);
+    float itemBweight = 1 - itemAweight;
+
+    //============== Interpolate the precomputed components ==================
+
+    quaternion aRotation = itemA->GetRotation();
+    quaternion bRotation = itemB->GetRotation();
+    float3 interpolatedScale;
+    quaternion interpolatedRotation;
+    float3 interpolatedTranslation;
+    auto interpolatedMatrix = InterpolateDecomposedMatrix(itemA->GetScale(), aRotation, itemA->GetTranslation(),
+                              itemB->GetScale(), bRotation, itemB->GetTranslation(), itemBweight,
+                              interpolatedScale, interpolatedRotation, interpolatedTranslation);
+
+    //============== Interpolate time ==================
+
+    float itemAunfilteredTimestamp = itemA->GetUnfilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
+    float itemBunfilteredTimestamp = itemB->GetUnfilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
+    float interpolatedUnfilteredTimestamp = itemAunfilteredTimestamp * itemAweight + itemBunfilteredTimestamp * itemBweight;
+
+    //============== Write interpolated results into the bufferItem ==================
+
+    bufferItem->ShallowCopyInternal(itemA, false);
+    bufferItem->SetMatrixInternal(interpolatedMatrix, interpolatedRotation, interpolatedTranslation, interpolatedScale);
+    bufferItem->SetFilteredTimestamp(time - localTimeOffsetSec);   // global = local + offset => local = global - offset
+    bufferItem->SetUnfilteredTimestamp(interpolatedUnfilteredTimestamp);
+
+    float angleDiffA = GetRotationAngleDeg(interpolatedRotation, aRotation);
+    float angleDiffB = GetRotationAngleDeg(interpolatedRotation, bRotation);
+    if (angleDiffA > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG && angleDiffB > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG)
     {
-      std::stringstream ss;
-      ss << "Buffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemA->GetUid() << ")";
-      OutputDebugStringA(ss.str().c_str());
-      return nullptr;
+      InterpolatedAngleExceededThreshold(this, angleDiffA, angleDiffB, ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG);
     }
 
-    float itemBtime(0);
-    try
+    return bufferItem;
+  }
+
+  //----------------------------------------------------------------------------
+  // Constant velocity model fitted to the last valid items. Translations and rotations are taken relative to the
+  // latest item (rotations as rotation vectors), so both velocities are least squares line fits through the origin.
+  StreamBufferItem^ Buffer::GetExtrapolatedStreamBufferItemFromTime(float time, float* outConfidence)
+  {
+    if (outConfidence != nullptr)
     {
-      itemBtime = this->StreamBuffer->GetTimeStamp(itemB->GetUid());
+      *outConfidence = 0.f;
     }
-    catch (const std::exception&)
+
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+    const float localTimeOffsetSec = this->StreamBuffer->GetLocalTimeOffsetSec();
+
+    float latestTime(0.f);
+    if (this->StreamBuffer->GetLatestTimeStampInternal(latestTime) != ITEM_OK)
     {
-      std::stringstream ss;
-      ss << "Buffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemB->GetUid() << ")";
-      OutputDebugStringA(ss.str().c_str());
+      OutputDebugStringA("Buffer: Cannot extrapolate, the buffer is empty.");
       return nullptr;
     }
 
-    if (fabs(itemAtime - itemBtime) < NEGLIGIBLE_TIME_DIFFERENCE)
+    if (time <= latestTime + NEGLIGIBLE_TIME_DIFFERENCE)
     {
-      // exact time match, no need for interpolation
-      bufferItem->DeepCopy(itemA);
-      bufferItem->SetFilteredTimestamp(time);
-      bufferItem->SetUnfilteredTimestamp(time);
-      return bufferItem;
+      // No prediction needed
+      StreamBufferItem^ item = GetInterpolatedStreamBufferItemFromTime(time);
+      if (outConfidence != nullptr && item != nullptr && item->GetStatus() == TOOL_OK)
+      {
+        *outConfidence = 1.f;
+      }
+      return item;
     }
 
-    float itemAweight = fabs(itemBtime - time) / fabs(itemAtime - itemBtime);
-    float itemBweight = 1 - itemAweight;
-
-    //============== Get transform matrices ==================
-    float4x4 itemAmatrix;
-    try
+    const float predictionTime = time - latestTime;
+    if (predictionTime > this->PredictionHorizonSec)
     {
-      itemAmatrix = itemA->GetMatrix();
+      std::stringstream ss;
+      ss << "Buffer: Cannot extrapolate beyond the prediction horizon (requested time: " << std::fixed << time << ", latest item time: " << latestTime << ", horizon: " << this->PredictionHorizonSec << ")";
+      OutputDebugStringA(ss.str().c_str());
+      return nullptr;
     }
-    catch (const std::exception&)
+
+    const BufferItemUidType latestUid = this->StreamBuffer->GetLatestItemUidInBuffer();
+    const BufferItemUidType oldestUid = this->StreamBuffer->GetOldestItemUidInBuffer();
+    StreamBufferItem^ latestItem;
+    if (this->StreamBuffer->GetBufferItemFromUidInternal(latestUid, latestItem) != ITEM_OK || latestItem->GetStatus() != TOOL_OK || !latestItem->HasValidTransformData())
     {
       std::stringstream ss;
-      ss << "Failed to get item A matrix";
+      ss << "Buffer: Cannot extrapolate, the latest item (uid: " << latestUid << ") has no valid transform.";
       OutputDebugStringA(ss.str().c_str());
       return nullptr;
     }
 
-    float4x4 itemBmatrix;
-    try
+    // The fit uses the consecutive valid items before the latest one, an invalid item (e.g. tool out of view) ends the history
+    const float3 latestTranslation = latestItem->GetTranslation();
+    const quaternion latestRotation = latestItem->GetRotation();
+    const quaternion latestRotationInverse = inverse(latestRotation);
+    const BufferItemUidType maximumHistory = (std::max)(this->NumberOfItemsForPrediction, 2u) - 1;
+    BufferItemUidType firstUid = latestUid;
+    float sumTT(0.f);
+    float3 sumTX(float3::zero());
+    float3 sumTR(float3::zero());
+    for (BufferItemUidType uid = latestUid; uid > oldestUid && latestUid - uid < maximumHistory; --uid)
     {
-      itemBmatrix = itemB->GetMatrix();
+      StreamBufferItem^ item;
+      if (this->StreamBuffer->GetBufferItemFromUidInternal(uid - 1, item) != ITEM_OK || item->GetStatus() != TOOL_OK || !item->HasValidTransformData())
+      {
+        break;
+      }
+      const float t = item->GetFilteredTimestamp(localTimeOffsetSec) - latestTime;
+      sumTT += t * t;
+      sumTX += t * (item->GetTranslation() - latestTranslation);
+      sumTR += t * ToRotationVector(item->GetRotation() * latestRotationInverse);
+      firstUid = uid - 1;
     }
-    catch (const std::exception&)
+
+    if (firstUid == latestUid || sumTT <= 0.f)
     {
       std::stringstream ss;
-      ss << "Failed to get item B matrix";
+      ss << "Buffer: Cannot extrapolate, there is no valid item before the latest item (uid: " << latestUid << ").";
       OutputDebugStringA(ss.str().c_str());
       return nullptr;
     }
 
-    float3 aScale;
-    float3 aTranslation;
-    quaternion aRotation;
-    decompose(itemAmatrix, &aScale, &aRotation, &aTranslation);
+    const float3 linearVelocity = sumTX / sumTT;
+    const float3 angularVelocity = sumTR / sumTT;
 
-    float3 bScale;
-    float3 bTranslation;
-    quaternion bRotation;
-    decompose(itemBmatrix, &bScale, &bRotation, &bTranslation);
+    if (outConfidence != nullptr)
+    {
+      // Coefficient of determination of both fits: 1 for constant velocity motion (or no motion)
+      float residualTranslation(0.f), totalTranslation(0.f), residualRotation(0.f), totalRotation(0.f);
+      for (BufferItemUidType uid = firstUid; uid < latestUid; ++uid)
+      {
+        StreamBufferItem^ item;
+        this->StreamBuffer->GetBufferItemFromUidInternal(uid, item);
+        const float t = item->GetFilteredTimestamp(localTimeOffsetSec) - latestTime;
+        const float3 x = item->GetTranslation() - latestTranslation;
+        const float3 r = ToRotationVector(item->GetRotation() * latestRotationInverse);
+        residualTranslation += length_squared(x - t * linearVelocity);
+        totalTranslation += length_squared(x);
+        residualRotation += length_squared(r - t * angularVelocity);
+        totalRotation += length_squared(r);
+      }
+      const float translationFit = (totalTranslation > 0.f) ? 1.f - residualTranslation / totalTranslation : 1.f;
+      const float rotationFit = (totalRotation > 0.f) ? 1.f - residualRotation / totalRotation : 1.f;
+      const float fit = (std::max)(0.f, (std::min)(translationFit, rotationFit));
+      *outConfidence = fit * (1.f - predictionTime / this->PredictionHorizonSec);
+    }
+
+    const float3 predictedTranslation = latestTranslation + predictionTime * linearVelocity;
+    const quaternion predictedRotation = normalize(FromRotationVector(predictionTime * angularVelocity) * latestRotation);
+    const float3 scale = latestItem->GetScale();
+    const float4x4 predictedMatrix = ComposeMatrix(scale, predictedRotation, predictedTranslation);
+
+    StreamBufferItem^ bufferItem = ref new StreamBufferItem();
+    bufferItem->DeepCopyInternal(latestItem, false);
+    bufferItem->SetMatrixInternal(predictedMatrix, predictedRotation, predictedTranslation, scale);
+    bufferItem->SetFilteredTimestamp(time - localTimeOffsetSec);   // global = local + offset => local = global - offset
+    bufferItem->SetUnfilteredTimestamp(time - localTimeOffsetSec);
+    return bufferItem;
+  }
 
-    //============== Interpolate rotation ==================
-    auto translation = transpose(make_float4x4_translation(itemAweight * aTranslation + itemBweight * bTranslation));
-    auto scale = transpose(make_float4x4_scale(itemAweight * aScale + itemBweight * bScale));
-    auto rotation = transpose(make_float4x4_from_quaternion(slerp(aRotation, bRotation, itemBweight)));
+  //----------------------------------------------------------------------------
+  void Buffer::SetPredictionHorizonSec(float predictionHorizonSec)
+  {
+    this->PredictionHorizonSec = predictionHorizonSec;
+  }
 
-    // TODO : verify correctness
-    auto interpolatedMatrix = rotation * translation * scale;
+  //----------------------------------------------------------------------------
+  float Buffer::GetPredictionHorizonSec()
+  {
+    return this->PredictionHorizonSec;
+  }
 
-    //============== Interpolate time ==================
+  //----------------------------------------------------------------------------
+  void Buffer::SetNumberOfItemsForPrediction(uint32 numberOfItems)
+  {
+    this->NumberOfItemsForPrediction = (std::max)(numberOfItems, 2u);
+  }
 
-    float itemAunfilteredTimestamp = itemA->GetUnfilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
-    float itemBunfilteredTimestamp = itemB->GetUnfilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
-    float interpolatedUnfilteredTimestamp = itemAunfilteredTimestamp * itemAweight + itemBunfilteredTimestamp * itemBweight;
+  //----------------------------------------------------------------------------
+  uint32 Buffer::GetNumberOfItemsForPrediction()
+  {
+    return this->NumberOfItemsForPrediction;
+  }
 
-    //============== Write interpolated results into the bufferItem ==================
+  //----------------------------------------------------------------------------
+  uint32 Buffer::GetInterpolatedMatrices(const Platform::Array<float>^ times, Platform::WriteOnlyArray<float4x4>^ outMatrices, Platform::WriteOnlyArray<int>^ outToolStatus)
+  {
+    if (times == nullptr || outMatrices == nullptr || outToolStatus == nullptr || outMatrices->Length != times->Length || outToolStatus->Length != times->Length)
+    {
+      OutputDebugStringA("Buffer: Cannot interpolate matrices, the output arrays must have the same length as the requested times.");
+      return 0;
+    }
+    if (times->Length == 0)
+    {
+      return 0;
+    }
 
-    bufferItem->DeepCopy(itemA);
-    bufferItem->SetMatrix(interpolatedMatrix);
-    bufferItem->SetFilteredTimestamp(time - this->StreamBuffer->GetLocalTimeOffsetSec());   // global = local + offset => local = global - offset
-    bufferItem->SetUnfilteredTimestamp(interpolatedUnfilteredTimestamp);
+    return InterpolateMatrices(times->Data, 0.f, 0.f, times->Length, outMatrices->Data, outToolStatus->Data);
+  }
 
-    float angleDiffA = GetOrientationDifference(interpolatedMatrix, itemAmatrix);
-    float angleDiffB = GetOrientationDifference(interpolatedMatrix, itemBmatrix);
-    if (fabs(angleDiffA) > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG && fabs(angleDiffB) > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG)
+  //----------------------------------------------------------------------------
+  uint32 Buffer::ResampleMatrices(float startTime, float period, Platform::WriteOnlyArray<float4x4>^ outMatrices, Platform::WriteOnlyArray<int>^ outToolStatus)
+  {
+    if (outMatrices == nullptr || outToolStatus == nullptr || outMatrices->Length != outToolStatus->Length)
     {
-      InterpolatedAngleExceededThreshold(this, angleDiffA, angleDiffB, ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG);
+      OutputDebugStringA("Buffer: Cannot resample matrices, the output arrays must have the same length.");
+      return 0;
+    }
+    if (period < 0.f)
+    {
+      OutputDebugStringA("Buffer: Cannot resample matrices, the sampling period must not be negative.");
+      return 0;
+    }
+    if (outMatrices->Length == 0)
+    {
+      return 0;
     }
 
-    return bufferItem;
+    return InterpolateMatrices(nullptr, startTime, period, outMatrices->Length, outMatrices->Data, outToolStatus->Data);
+  }
+
+  //----------------------------------------------------------------------------
+  // Same acceptance rules as GetPrevNextBufferItemFromTime/GetInterpolatedStreamBufferItemFromTime, but the
+  // item pair around the query time is found by advancing a cursor instead of searching.
+  uint32 Buffer::InterpolateMatrices(const float* times, float startTime, float period, uint32 count, float4x4* outMatrices, int* outToolStatus)
+  {
+    for (uint32 i = 0; i < count; ++i)
+    {
+      outMatrices[i] = float4x4::identity();
+      outToolStatus[i] = TOOL_MISSING;
+    }
+
+    std::lock_guard<std::recursive_mutex> guard(this->BufferMutex);
+
+    if (this->StreamBuffer->GetNumberOfItems() == 0)
+    {
+      OutputDebugStringA("Buffer: Cannot interpolate matrices, the buffer is empty.");
+      return 0;
+    }
+
+    const float localTimeOffsetSec = this->StreamBuffer->GetLocalTimeOffsetSec();
+    const BufferItemUidType oldestUid = this->StreamBuffer->GetOldestItemUidInBuffer();
+    const BufferItemUidType latestUid = this->StreamBuffer->GetLatestItemUidInBuffer();
+
+    // itemA is the last item not later than the query time (or the oldest item), itemB is the item after it
+    BufferItemUidType itemAuid(oldestUid);
+    StreamBufferItem^ itemA;
+    StreamBufferItem^ itemB;
+    float itemAtime(0.f);
+    float itemBtime(0.f);
+    float3 interpolatedScale, interpolatedTranslation;
+    quaternion interpolatedRotation;
+
+    uint32 numberOfValidItems(0);
+    for (uint32 i = 0; i < count; ++i)
+    {
+      const float time = (times != nullptr) ? times[i] : startTime + i * period;
+
+      if (i == 0 || (times != nullptr && time < times[i - 1]))
+      {
+        // Start from the oldest item, also when the query times are not in ascending order (still correct, only slower)
+        itemAuid = oldestUid;
+        itemA = this->StreamBuffer->GetBufferItemFromUid(itemAuid);
+        itemB = (itemAuid < latestUid) ? this->StreamBuffer->GetBufferItemFromUid(itemAuid + 1) : nullptr;
+        itemAtime = itemA->GetFilteredTimestamp(localTimeOffsetSec);
+        itemBtime = (itemB != nullptr) ? itemB->GetFilteredTimestamp(localTimeOffsetSec) : 0.f;
+      }
+
+      while (itemB != nullptr && itemBtime <= time)
+      {
+        ++itemAuid;
+        itemA = itemB;
+        itemAtime = itemBtime;
+        itemB = (itemAuid < latestUid) ? this->StreamBuffer->GetBufferItemFromUid(itemAuid + 1) : nullptr;
+        itemBtime = (itemB != nullptr) ? itemB->GetFilteredTimestamp(localTimeOffsetSec) : 0.f;
+      }
+
+      if (time < itemAtime - NEGLIGIBLE_TIME_DIFFERENCE || (itemB == nullptr && time > itemAtime + NEGLIGIBLE_TIME_DIFFERENCE))
+      {
+        // Outside of the time range of the buffer
+        continue;
+      }
+
+      // The closest item must be valid
+      const bool itemBisClosest = (itemB != nullptr && itemBtime - time < time - itemAtime);
+      StreamBufferItem^ closestItem = itemBisClosest ? itemB : itemA;
+      const float closestTime = itemBisClosest ? itemBtime : itemAtime;
+      if (closestItem->GetStatus() != TOOL_OK)
+      {
+        continue;
+      }
+
+      // If the time difference is negligible then don't interpolate, just use the closest item
+      if (fabs(closestTime - time) < NEGLIGIBLE_TIME_DIFFERENCE)
+      {
+        outMatrices[i] = closestItem->GetMatrix();
+        outToolStatus[i] = TOOL_OK;
+        ++numberOfValidItems;
+        continue;
+      }
+
+      // Both neighbors must be valid and close enough for interpolation
+      if (itemB == nullptr || itemA->GetStatus() != TOOL_OK || itemB->GetStatus() != TOOL_OK ||
+          fabs(itemAtime - time) > this->GetMaxAllowedTimeDifference() || fabs(itemBtime - time) > this->GetMaxAllowedTimeDifference())
+      {
+        continue;
+      }
+
+      const float itemBweight = (time - itemAtime) / (itemBtime - itemAtime);
+      const quaternion aRotation = itemA->GetRotation();
+      const quaternion bRotation = itemB->GetRotation();
+      outMatrices[i] = InterpolateDecomposedMatrix(itemA->GetScale(), aRotation, itemA->GetTranslation(),
+                       itemB->GetScale(), bRotation, itemB->GetTranslation(), itemBweight,
+                       interpolatedScale, interpolatedRotation, interpolatedTranslation);
+      outToolStatus[i] = TOOL_OK;
+      ++numberOfValidItems;
+
+      float angleDiffA = GetRotationAngleDeg(interpolatedRotation, aRotation);
+      float angleDiffB = GetRotationAngleDeg(interpolatedRotation, bRotation);
+      if (angleDiffA > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG && angleDiffB > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG)
+      {
+        InterpolatedAngleExceededThreshold(this, angleDiffA, angleDiffB, ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG);
+      }
+    }
+
+    return numberOfValidItems;
   }
 
   //-----------------------------------------------------------------------------
@@ -1121,19 +1484,7 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   int Buffer::GetItemUidFromTime(float time, BufferItemUidType* outUid)
   {
-    try
-    {
-      *outUid = this->StreamBuffer->GetItemUidFromTime(time);
-      return ITEM_OK;
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableAnymoreException&)
-    {
-      return ITEM_NOT_AVAILABLE_ANYMORE;
-    }
-    catch (const UWPOpenIGTLink::ItemNotAvailableYetException&)
-    {
-      return ITEM_NOT_AVAILABLE_YET;
-    }
+    return this->StreamBuffer->GetItemUidFromTimeInternal(time, *outUid);
   }
 
   //----------------------------------------------------------------------------
@@ -1148,6 +1499,24 @@ namespace UWPOpenIGTLink
     return this->StreamBuffer->GetFrameRate(ideal, outFramePeriodStdevSec);
   }
 
+  //----------------------------------------------------------------------------
+  uint64 Buffer::GetNumberOfDroppedFrames()
+  {
+    return this->StreamBuffer->GetNumberOfDroppedFrames();
+  }
+
+  //----------------------------------------------------------------------------
+  float Buffer::GetMinimumFramePeriodSec()
+  {
+    return this->StreamBuffer->GetMinimumFramePeriodSec();
+  }
+
+  //----------------------------------------------------------------------------
+  float Buffer::GetMaximumFramePeriodSec()
+  {
+    return this->StreamBuffer->GetMaximumFramePeriodSec();
+  }
+
   //----------------------------------------------------------------------------
   void Buffer::SetMaxAllowedTimeDifference(float maxAllowedTimeDifference)
   {
@@ -27,6 +27,7 @@ OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 // Local includes
+#include "FrameSpillStore.h"
 #include "IGTCommon.h"
 #include "Image.h"
 #include "StreamBufferItem.h"
@@ -118,6 +119,69 @@ namespace UWPOpenIGTLink
     StreamBufferItem^ GetStreamBufferItemFromTime(float time, int interpolation);
     bool ModifyBufferItemFrameField(BufferItemUidType uid, Platform::String^ key, Platform::String^ value);
 
+    /*!
+    Pin the item with the specified uid, or the item closest to the specified time, without copying it.
+    The returned item does not change until it is passed to UnpinStreamBufferItem, even if the buffer wraps around
+    (the writer then gives its slot a new item), so it can be read without holding any lock. It must not be modified.
+    Returns nullptr if there is no such item in the buffer.
+    */
+    StreamBufferItem^ PinStreamBufferItem(BufferItemUidType uid);
+    StreamBufferItem^ PinStreamBufferItemFromTime(float time);
+    /*! Release an item returned by PinStreamBufferItem or PinStreamBufferItemFromTime */
+    void UnpinStreamBufferItem(StreamBufferItem^ item);
+
+    /*!
+    Interpolate the matrix for each of the requested times (in ascending order) in a single pass over the buffer.
+    Results are written to the caller provided arrays, which must have the same length as times.
+    Elements that cannot be interpolated (see GetStreamBufferItemFromTime with INTERPOLATED) get TOOL_MISSING status.
+    \return the number of elements with TOOL_OK status
+    */
+    uint32 GetInterpolatedMatrices(const Platform::Array<float>^ times,
+                                   Platform::WriteOnlyArray<Windows::Foundation::Numerics::float4x4>^ outMatrices,
+                                   Platform::WriteOnlyArray<int>^ outToolStatus);
+
+    /*!
+    Resample the matrices at a fixed rate: element i is interpolated at startTime + i * period.
+    The number of samples is the length of outMatrices, outToolStatus must have the same length.
+    \return the number of elements with TOOL_OK status
+    */
+    uint32 ResampleMatrices(float startTime,
+                            float period,
+                            Platform::WriteOnlyArray<Windows::Foundation::Numerics::float4x4>^ outMatrices,
+                            Platform::WriteOnlyArray<int>^ outToolStatus);
+
+    /*!
+    Get the item at the specified time, predicted beyond the latest item (latency compensation for rendering).
+    Constant linear and angular velocities are fitted to the last valid items (see SetNumberOfItemsForPrediction)
+    and the latest pose is extrapolated up to the prediction horizon. Within the buffer the interpolated item is returned.
+    If outConfidence is not null it is set between 0 (no prediction) and 1 (sample in the buffer). The confidence decreases
+    linearly to 0 at the horizon, and with how much the recent motion deviates from constant velocity.
+    */
+    StreamBufferItem^ GetExtrapolatedStreamBufferItemFromTime(float time, float* outConfidence);
+
+    /*! Set the maximum time in seconds the pose may be extrapolated beyond the latest item */
+    void SetPredictionHorizonSec(float predictionHorizonSec);
+    /*! Get the maximum time in seconds the pose may be extrapolated beyond the latest item */
+    float GetPredictionHorizonSec();
+
+    /*! Set the number of latest items the velocities are fitted to for extrapolation (at least 2) */
+    void SetNumberOfItemsForPrediction(uint32 numberOfItems);
+    /*! Get the number of latest items the velocities are fitted to for extrapolation */
+    uint32 GetNumberOfItemsForPrediction();
+
+    /*!
+    Spill every added item to memory mapped segment files of segmentSizeBytes in directory (must exist and be writable, e.g. the application local folder).
+    Items that are no longer in the buffer remain available through GetStreamBufferItemFromTime for the whole recording,
+    while only the buffer and the most recently read segments stay in memory. Custom frame fields are not spilled.
+    */
+    bool EnableSpillToDisk(Platform::String^ directory, uint64 segmentSizeBytes);
+    /*! Stop spilling, items that are no longer in the buffer cannot be retrieved anymore. The segment files are left on disk. */
+    void DisableSpillToDisk();
+    /*! Returns true if added items are spilled to disk, false once an item or a Clear could not be spilled */
+    bool IsSpillToDiskEnabled();
+    /*! Get the number of items spilled to disk since spilling was enabled */
+    uint64 GetNumberOfSpilledItems();
+
     /*! Get latest timestamp in the buffer */
     int GetLatestTimeStamp(float* outLatestTimestamp);
 
@@ -167,6 +231,13 @@ namespace UWPOpenIGTLink
     */
     float GetFrameRate(bool ideal, float* outFramePeriodStdevSec);
 
+    /*! Get the number of frames dropped by the data source between the items in the buffer, based on the frame number gaps */
+    uint64 GetNumberOfDroppedFrames();
+    /*! Get the shortest frame period between the items in the buffer (in seconds) */
+    float GetMinimumFramePeriodSec();
+    /*! Get the longest frame period between the items in the buffer (in seconds) */
+    float GetMaximumFramePeriodSec();
+
     /*! Set maximum allowed time difference in seconds between the desired and the closest valid timestamp */
     void SetMaxAllowedTimeDifference(float maxAllowedTimeDifference);
     /*! Get maximum allowed time difference in seconds between the desired and the closest valid timestamp */
@@ -209,6 +280,12 @@ namespace UWPOpenIGTLink
     /*! Get the image type (B-mode, RF, ...) */
     int GetImageType();
 
+    /*!
+    Point the frames of all items to blank frames carved from one newly allocated, zeroed block.
+    Frames that are already handed out are never written; they keep the storage they hold.
+    */
+    bool FillBlank();
+
     /*! Set the image orientation (MF, MN, ...). Does not reorder the pixels. */
     bool SetImageOrientation(int imageOrientation);
     /*! Get the image orientation (MF, MN, ...) */
@@ -227,9 +304,16 @@ namespace UWPOpenIGTLink
     void SetDescriptiveName(Platform::String^ descriptiveName);
 
   protected private:
-    /*! Update video buffer by setting the frame format for each frame  */
+    /*!
+    Update video buffer by setting the frame format for each frame
+    Does not allocate frame storage: every add stores the image of the caller. Items holding a frame of
+    another format get a new image without storage.
+    */
     bool AllocateMemoryForFrames();
 
+    /*! Append a committed item to the spill store. On failure the store is dropped, spilling to disk is then disabled. */
+    void SpillItem(StreamBufferItem^ item);
+
     /*!
     Compares frame format with new frame imaging parameters.
     \return true if current buffer frame format matches the method arguments, otherwise false
@@ -252,6 +336,15 @@ namespace UWPOpenIGTLink
     /*! Get tracker buffer item from the closest timestamp */
     StreamBufferItem^ GetStreamBufferItemFromClosestTime(float time);
 
+    /*!
+    Merge the ascending query times with the buffer items and interpolate a matrix for each of them.
+    Query time i is times[i] if times is not null, startTime + i * period otherwise.
+    */
+    uint32 InterpolateMatrices(const float* times, float startTime, float period, uint32 count, Windows::Foundation::Numerics::float4x4* outMatrices, int* outToolStatus);
+
+    /*! Get an item older than the buffer from the spill store, following the same rules as the in-memory lookups */
+    StreamBufferItem^ GetSpilledStreamBufferItemFromTime(float time, DATA_ITEM_TEMPORAL_INTERPOLATION interpolation);
+
   protected private:
     std::array<uint16, 3> FrameSize = { 0, 0, 1 };
     IGTL_SCALAR_TYPE PixelType = IGTL_SCALARTYPE_UINT8;
@@ -259,10 +352,15 @@ namespace UWPOpenIGTLink
     US_IMAGE_TYPE ImageType = US_IMG_BRIGHTNESS;
     US_IMAGE_ORIENTATION ImageOrientation = US_IMG_ORIENT_MF;
     float MaxAllowedTimeDifference = 0.5;
+    float PredictionHorizonSec = 0.1f;
+    uint32 NumberOfItemsForPrediction = 5;
     std::wstring DescriptiveName;
     Windows::Globalization::Calendar^ Calendar = ref new Windows::Globalization::Calendar();
 
     std::recursive_mutex BufferMutex;
     TimestampedCircularBuffer^ StreamBuffer = ref new TimestampedCircularBuffer();
+
+    // All added items when spilling to disk is enabled, nullptr otherwise
+    std::unique_ptr<FrameSpillStore> SpillStore;
   };
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "pch.h"
+#include "ByteSwap.h"
+
+// STL includes
+#include <cstdlib>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define UWPOPENIGTLINK_BYTESWAP_SIMD
+  // Intrinsic includes
+  #include <intrin.h>
+  #include <immintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    //----------------------------------------------------------------------------
+    template<typename ScalarType, ScalarType(*Swap)(ScalarType)>
+    void SwapScalar(byte* destination, const byte* source, uint64 count)
+    {
+      for (uint64 i = 0; i < count; ++i)
+      {
+        ScalarType value;
+        memcpy(&value, source + i * sizeof(ScalarType), sizeof(ScalarType));
+        value = Swap(value);
+        memcpy(destination + i * sizeof(ScalarType), &value, sizeof(ScalarType));
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    uint16 Swap16(uint16 value)
+    {
+      return _byteswap_ushort(value);
+    }
+
+    //----------------------------------------------------------------------------
+    uint32 Swap32(uint32 value)
+    {
+      return static_cast<uint32>(_byteswap_ulong(value));
+    }
+
+    //----------------------------------------------------------------------------
+    uint64 Swap64(uint64 value)
+    {
+      return _byteswap_uint64(value);
+    }
+
+    //----------------------------------------------------------------------------
+    void SwapScalarTail(byte* destination, const byte* source, uint64 count, uint32 scalarSize)
+    {
+      switch (scalarSize)
+      {
+      case 2:
+        SwapScalar<uint16, &Swap16>(destination, source, count);
+        break;
+      case 4:
+        SwapScalar<uint32, &Swap32>(destination, source, count);
+        break;
+      case 8:
+        SwapScalar<uint64, &Swap64>(destination, source, count);
+        break;
+      }
+    }
+
+#ifdef UWPOPENIGTLINK_BYTESWAP_SIMD
+    //----------------------------------------------------------------------------
+    /// Byte shuffle control that reverses each scalarSize wide group of bytes in a 16 byte lane
+    __m128i GetShuffleMask128(uint32 scalarSize)
+    {
+      switch (scalarSize)
+      {
+      case 2:
+        return _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+      case 4:
+        return _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+      default:
+        return _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    void CopyAndSwapSSSE3(byte* destination, const byte* source, uint64 numberOfScalars, uint32 scalarSize)
+    {
+      const __m128i mask = GetShuffleMask128(scalarSize);
+      const uint64 numberOfBytes = numberOfScalars * scalarSize;
+      uint64 offset = 0;
+      for (; offset + 16 <= numberOfBytes; offset += 16)
+      {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset), _mm_shuffle_epi8(value, mask));
+      }
+      SwapScalarTail(destination + offset, source + offset, (numberOfBytes - offset) / scalarSize, scalarSize);
+    }
+
+    //----------------------------------------------------------------------------
+    void CopyAndSwapAVX2(byte* destination, const byte* source, uint64 numberOfScalars, uint32 scalarSize)
+    {
+      // vpshufb shuffles within each 128 bit lane, so the same mask is used for both lanes
+      const __m128i mask128 = GetShuffleMask128(scalarSize);
+      const __m256i mask = _mm256_broadcastsi128_si256(mask128);
+      const uint64 numberOfBytes = numberOfScalars * scalarSize;
+      uint64 offset = 0;
+      for (; offset + 64 <= numberOfBytes; offset += 64)
+      {
+        __m256i value0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + offset));
+        __m256i value1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + offset + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + offset), _mm256_shuffle_epi8(value0, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + offset + 32), _mm256_shuffle_epi8(value1, mask));
+      }
+      for (; offset + 16 <= numberOfBytes; offset += 16)
+      {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset), _mm_shuffle_epi8(value, mask128));
+      }
+      SwapScalarTail(destination + offset, source + offset, (numberOfBytes - offset) / scalarSize, scalarSize);
+    }
+
+    //----------------------------------------------------------------------------
+    bool ProcessorSupportsSSSE3()
+    {
+      int cpuInfo[4] = { 0, 0, 0, 0 };
+      __cpuid(cpuInfo, 1);
+      return (cpuInfo[2] & (1 << 9)) != 0;
+    }
+
+    //----------------------------------------------------------------------------
+    bool ProcessorSupportsAVX2()
+    {
+      int cpuInfo[4] = { 0, 0, 0, 0 };
+      __cpuid(cpuInfo, 0);
+      if (cpuInfo[0] < 7)
+      {
+        return false;
+      }
+
+      // AVX and OSXSAVE, and the OS must save the YMM registers
+      __cpuid(cpuInfo, 1);
+      const bool hasAVX = (cpuInfo[2] & (1 << 28)) != 0;
+      const bool hasOSXSAVE = (cpuInfo[2] & (1 << 27)) != 0;
+      if (!hasAVX || !hasOSXSAVE || (_xgetbv(0) & 0x6) != 0x6)
+      {
+        return false;
+      }
+
+      __cpuidex(cpuInfo, 7, 0);
+      return (cpuInfo[1] & (1 << 5)) != 0;
+    }
+#endif
+
+    //----------------------------------------------------------------------------
+    void CopyAndSwapScalarLoop(byte* destination, const byte* source, uint64 numberOfScalars, uint32 scalarSize)
+    {
+      SwapScalarTail(destination, source, numberOfScalars, scalarSize);
+    }
+
+    typedef void(*CopyAndSwapFunction)(byte*, const byte*, uint64, uint32);
+
+    //----------------------------------------------------------------------------
+    CopyAndSwapFunction SelectImplementation()
+    {
+#ifdef UWPOPENIGTLINK_BYTESWAP_SIMD
+      if (ProcessorSupportsAVX2())
+      {
+        return &CopyAndSwapAVX2;
+      }
+      if (ProcessorSupportsSSSE3())
+      {
+        return &CopyAndSwapSSSE3;
+      }
+#endif
+      return &CopyAndSwapScalarLoop;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void CopyAndSwapScalars(void* destination, const void* source, uint64 numberOfScalars, uint32 scalarSize)
+  {
+    if (destination == nullptr || source == nullptr || numberOfScalars == 0)
+    {
+      return;
+    }
+
+    if (scalarSize != 2 && scalarSize != 4 && scalarSize != 8)
+    {
+      if (destination != source)
+      {
+        memcpy(destination, source, static_cast<size_t>(numberOfScalars * scalarSize));
+      }
+      return;
+    }
+
+    static const CopyAndSwapFunction implementation = SelectImplementation();
+    implementation(static_cast<byte*>(destination), static_cast<const byte*>(source), numberOfScalars, scalarSize);
+  }
+
+  //----------------------------------------------------------------------------
+  void SwapScalarsInPlace(void* data, uint64 numberOfScalars, uint32 scalarSize)
+  {
+    CopyAndSwapScalars(data, data, numberOfScalars, scalarSize);
+  }
+}
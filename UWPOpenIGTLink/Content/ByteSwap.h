@@ -0,0 +1,41 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    Copy numberOfScalars scalars of scalarSize bytes (2, 4 or 8) from source to destination, reversing the byte order of each scalar.
+    source and destination may be the same buffer for an in-place conversion, other overlaps are not supported.
+    The implementation is selected at runtime: AVX2 or SSSE3 byte shuffles on x86/x64 processors that support them,
+    a scalar loop otherwise. Other scalar sizes are copied unchanged.
+  */
+  void CopyAndSwapScalars(void* destination, const void* source, uint64 numberOfScalars, uint32 scalarSize);
+
+  /// Convert a buffer of scalars in place, see CopyAndSwapScalars
+  void SwapScalarsInPlace(void* data, uint64 numberOfScalars, uint32 scalarSize);
+}
@@ -0,0 +1,240 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#include "pch.h"
+#include "ClockOffsetEstimator.h"
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+  static const uint32 MINIMUM_SAMPLES_FOR_SPIKE_REJECTION = 4;
+  static const double SPIKE_DELAY_FACTOR = 3.0;             // round trips slower than this many times the median delay are spikes
+  static const double SPIKE_DELAY_MARGIN_SEC = 0.001;       // ... plus this margin, so a fast local link does not reject everything
+  static const uint32 MINIMUM_SAMPLES_FOR_DRIFT = 8;
+  static const double MINIMUM_DRIFT_SPAN_SEC = 30.0;        // drift is not estimated from a shorter time span
+  static const double OUTLIER_SIGMA = 3.0;
+}
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  ClockOffsetEstimator::ClockOffsetEstimator(uint32 windowSize)
+    : m_windowSize((std::max)(windowSize, MINIMUM_SAMPLES_FOR_SPIKE_REJECTION))
+    , m_consecutiveRejections(0)
+    , m_numberOfRejectedSamples(0)
+    , m_hasEstimate(false)
+    , m_referenceTime(0.0)
+    , m_offset(0.0)
+    , m_drift(0.0)
+    , m_uncertainty(0.0)
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  bool ClockOffsetEstimator::AddSample(double localSendTime, double remoteTime, double localReceiveTime)
+  {
+    RoundTrip roundTrip;
+    roundTrip.Delay = localReceiveTime - localSendTime;
+    roundTrip.LocalTime = 0.5 * (localSendTime + localReceiveTime);
+    roundTrip.Offset = remoteTime - roundTrip.LocalTime;
+    if (roundTrip.Delay < 0.0)
+    {
+      m_numberOfRejectedSamples++;
+      return false;
+    }
+
+    if (m_roundTrips.size() >= MINIMUM_SAMPLES_FOR_SPIKE_REJECTION && roundTrip.Delay > SPIKE_DELAY_FACTOR * GetMedianDelay() + SPIKE_DELAY_MARGIN_SEC)
+    {
+      m_consecutiveRejections++;
+      m_numberOfRejectedSamples++;
+      if (m_consecutiveRejections < m_windowSize / 4)
+      {
+        return false;
+      }
+      // The delay has persistently increased (e.g. the route changed), start over with the new delays
+      m_roundTrips.clear();
+    }
+    m_consecutiveRejections = 0;
+
+    m_roundTrips.push_back(roundTrip);
+    if (m_roundTrips.size() > m_windowSize)
+    {
+      m_roundTrips.pop_front();
+    }
+    UpdateEstimate();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void ClockOffsetEstimator::Clear()
+  {
+    m_roundTrips.clear();
+    m_consecutiveRejections = 0;
+    m_numberOfRejectedSamples = 0;
+    m_hasEstimate = false;
+    m_referenceTime = 0.0;
+    m_offset = 0.0;
+    m_drift = 0.0;
+    m_uncertainty = 0.0;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ClockOffsetEstimator::HasEstimate() const
+  {
+    return m_hasEstimate;
+  }
+
+  //----------------------------------------------------------------------------
+  double ClockOffsetEstimator::GetOffsetSec(double localTime) const
+  {
+    return m_offset + m_drift * (localTime - m_referenceTime);
+  }
+
+  //----------------------------------------------------------------------------
+  double ClockOffsetEstimator::GetDriftPpm() const
+  {
+    return m_drift * 1e6;
+  }
+
+  //----------------------------------------------------------------------------
+  double ClockOffsetEstimator::GetUncertaintySec() const
+  {
+    return m_uncertainty;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 ClockOffsetEstimator::GetNumberOfSamples() const
+  {
+    return static_cast<uint32>(m_roundTrips.size());
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 ClockOffsetEstimator::GetNumberOfRejectedSamples() const
+  {
+    return m_numberOfRejectedSamples;
+  }
+
+  //----------------------------------------------------------------------------
+  double ClockOffsetEstimator::GetMedianDelay() const
+  {
+    std::vector<double> delays;
+    delays.reserve(m_roundTrips.size());
+    for (auto& roundTrip : m_roundTrips)
+    {
+      delays.push_back(roundTrip.Delay);
+    }
+    auto median = delays.begin() + delays.size() / 2;
+    std::nth_element(delays.begin(), median, delays.end());
+    return *median;
+  }
+
+  //----------------------------------------------------------------------------
+  void ClockOffsetEstimator::UpdateEstimate()
+  {
+    // Faster half of the round trips, their offsets are the least affected by asymmetric delays
+    const double medianDelay = GetMedianDelay();
+    std::vector<RoundTrip> selected;
+    for (auto& roundTrip : m_roundTrips)
+    {
+      if (roundTrip.Delay <= medianDelay)
+      {
+        selected.push_back(roundTrip);
+      }
+    }
+
+    // Offsets are large (e.g. seconds since the epoch against seconds since boot), fit relative to the first one
+    const double baseOffset = selected.front().Offset;
+    double residualStdev(0.0);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      double meanTime(0.0);
+      double meanOffset(0.0);
+      for (auto& roundTrip : selected)
+      {
+        meanTime += roundTrip.LocalTime;
+        meanOffset += roundTrip.Offset - baseOffset;
+      }
+      meanTime /= selected.size();
+      meanOffset /= selected.size();
+
+      double drift(0.0);
+      const double span = selected.back().LocalTime - selected.front().LocalTime;
+      if (selected.size() >= MINIMUM_SAMPLES_FOR_DRIFT && span >= MINIMUM_DRIFT_SPAN_SEC)
+      {
+        double sumTimeOffset(0.0);
+        double sumTimeTime(0.0);
+        for (auto& roundTrip : selected)
+        {
+          sumTimeOffset += (roundTrip.LocalTime - meanTime) * (roundTrip.Offset - baseOffset - meanOffset);
+          sumTimeTime += (roundTrip.LocalTime - meanTime) * (roundTrip.LocalTime - meanTime);
+        }
+        drift = sumTimeOffset / sumTimeTime;
+      }
+
+      double sumOfSquares(0.0);
+      for (auto& roundTrip : selected)
+      {
+        double residual = roundTrip.Offset - baseOffset - meanOffset - drift * (roundTrip.LocalTime - meanTime);
+        sumOfSquares += residual * residual;
+      }
+      residualStdev = std::sqrt(sumOfSquares / selected.size());
+
+      m_referenceTime = meanTime;
+      m_offset = baseOffset + meanOffset;
+      m_drift = drift;
+
+      // Drop the outliers of the line and fit again
+      if (pass == 0 && residualStdev > 0.0)
+      {
+        auto outlier = [this, residualStdev](const RoundTrip & roundTrip)
+        {
+          return std::abs(roundTrip.Offset - GetOffsetSec(roundTrip.LocalTime)) > OUTLIER_SIGMA * residualStdev;
+        };
+        selected.erase(std::remove_if(selected.begin(), selected.end(), outlier), selected.end());
+        if (selected.empty())
+        {
+          break;
+        }
+      }
+      else
+      {
+        break;
+      }
+    }
+
+    double minimumDelay = m_roundTrips.front().Delay;
+    for (auto& roundTrip : m_roundTrips)
+    {
+      minimumDelay = (std::min)(minimumDelay, roundTrip.Delay);
+    }
+    m_uncertainty = 0.5 * minimumDelay + residualStdev;
+    m_hasEstimate = true;
+  }
+}
@@ -0,0 +1,88 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+// STL includes
+#include <deque>
+
+namespace UWPOpenIGTLink
+{
+  /*
+  Estimates the offset and drift of a remote clock against the local clock from request/reply round trips (NTP style).
+  Each round trip gives the local send and receive times and the remote time the reply was stamped with:
+    offset = remote time - (send time + receive time) / 2,   round trip delay = receive time - send time
+  The asymmetry of the two directions makes the offset of a round trip uncertain by up to half its delay, so only
+  the round trips with the lowest delays (the faster half of the recent ones) are used. A line is fitted to their offsets
+  (offset and drift, once they span MINIMUM_DRIFT_SPAN_SEC) and the ones more than three standard deviations off the line are dropped.
+  Round trips much slower than usual (network spikes) are rejected up front, unless they persist (a route change).
+  The uncertainty is half the lowest round trip delay plus the standard deviation of the fit.
+  Not thread safe.
+  */
+  class ClockOffsetEstimator
+  {
+  public:
+    explicit ClockOffsetEstimator(uint32 windowSize = 64);
+
+    /// Add a round trip (all times in seconds), returns false if it is rejected
+    bool AddSample(double localSendTime, double remoteTime, double localReceiveTime);
+    void Clear();
+
+    /// Returns true once a round trip has been accepted
+    bool HasEstimate() const;
+    /// Remote time - local time at the local time
+    double GetOffsetSec(double localTime) const;
+    /// Rate of the remote clock relative to the local one, in parts per million
+    double GetDriftPpm() const;
+    double GetUncertaintySec() const;
+    uint32 GetNumberOfSamples() const;
+    uint64 GetNumberOfRejectedSamples() const;
+
+  protected:
+    struct RoundTrip
+    {
+      double    LocalTime;    // midpoint of the round trip
+      double    Offset;
+      double    Delay;
+    };
+
+    double GetMedianDelay() const;
+    void UpdateEstimate();
+
+  protected:
+    uint32                  m_windowSize;
+    std::deque<RoundTrip>   m_roundTrips;
+    uint32                  m_consecutiveRejections;
+    uint64                  m_numberOfRejectedSamples;
+
+    // Fitted line: offset = m_offset + m_drift * (local time - m_referenceTime)
+    bool                    m_hasEstimate;
+    double                  m_referenceTime;
+    double                  m_offset;
+    double                  m_drift;
+    double                  m_uncertainty;
+  };
+}
@@ -0,0 +1,410 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#include "pch.h"
+#include "CompactPoseHistory.h"
+
+// STL includes
+#include <algorithm>
+
+using namespace Windows::Foundation::Numerics;
+
+namespace
+{
+  static const float NEGLIGIBLE_TIME_DIFFERENCE = 0.00001f; // in seconds, used for comparing between exact timestamps
+  static const size_t MAXIMUM_SAMPLES_PER_BLOCK = 256;
+  static const double TIME_QUANTUM_SEC = 0.00001;
+  static const float SCALE_TOLERANCE = 0.0001f;
+  static const float SMALLEST_THREE_RANGE = 0.70710678f;   // the three smallest components are within +-1/sqrt(2)
+  static const uint32 SMALLEST_THREE_MAXIMUM = 1023;      // 10 bits
+
+  //----------------------------------------------------------------------------
+  uint32 EncodeRotation(const quaternion& rotation)
+  {
+    const quaternion q = normalize(rotation);
+    float components[4] = { q.x, q.y, q.z, q.w };
+    uint32 largest(0);
+    for (uint32 i = 1; i < 4; ++i)
+    {
+      if (fabs(components[i]) > fabs(components[largest]))
+      {
+        largest = i;
+      }
+    }
+    // q and -q are the same orientation, make the omitted component positive
+    const float sign = (components[largest] < 0.f) ? -1.f : 1.f;
+
+    uint32 packed = largest << 30;
+    uint32 shift(20);
+    for (uint32 i = 0; i < 4; ++i)
+    {
+      if (i == largest)
+      {
+        continue;
+      }
+      const float normalized = (sign * components[i] / SMALLEST_THREE_RANGE) * 0.5f + 0.5f;
+      const uint32 quantized = static_cast<uint32>((std::min)((std::max)(normalized, 0.f), 1.f) * SMALLEST_THREE_MAXIMUM + 0.5f);
+      packed |= quantized << shift;
+      shift -= 10;
+    }
+    return packed;
+  }
+
+  //----------------------------------------------------------------------------
+  quaternion DecodeRotation(uint32 packed)
+  {
+    const uint32 largest = packed >> 30;
+    float components[4];
+    float sumOfSquares(0.f);
+    uint32 shift(20);
+    for (uint32 i = 0; i < 4; ++i)
+    {
+      if (i == largest)
+      {
+        continue;
+      }
+      const uint32 quantized = (packed >> shift) & SMALLEST_THREE_MAXIMUM;
+      components[i] = (static_cast<float>(quantized) / SMALLEST_THREE_MAXIMUM * 2.f - 1.f) * SMALLEST_THREE_RANGE;
+      sumOfSquares += components[i] * components[i];
+      shift -= 10;
+    }
+    components[largest] = sqrt((std::max)(0.f, 1.f - sumOfSquares));
+    return normalize(quaternion(components[0], components[1], components[2], components[3]));
+  }
+}
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  CompactPoseHistory::CompactPoseHistory(float translationResolution)
+    : m_translationResolution(translationResolution)
+    , m_numberOfSamples(0)
+    , m_nextDecodedBlock(0)
+  {
+    m_decodedBlockValid[0] = false;
+    m_decodedBlockValid[1] = false;
+  }
+
+  //----------------------------------------------------------------------------
+  bool CompactPoseHistory::AddSample(float timestamp, BufferItemUidType uid, const ToolPose& pose, int toolStatus)
+  {
+    if (!m_blocks.empty() && timestamp <= m_blocks.back().LastTimestamp)
+    {
+      return false;
+    }
+
+    // Continue the current block if the sample follows its last one and fits its time base, translation range and scale
+    if (!m_blocks.empty() && m_blocks.back().Samples.size() < MAXIMUM_SAMPLES_PER_BLOCK && uid == m_blocks.back().FirstUid + m_blocks.back().Samples.size())
+    {
+      PackedPoseBlock& block = m_blocks.back();
+      const double timeDelta = (static_cast<double>(timestamp) - block.LastTimestamp) / TIME_QUANTUM_SEC;
+      PackedPoseSample sample;
+      if (timeDelta < 65535.0 && EncodeTranslation(block, pose.Translation, sample.Translation) &&
+          fabs(pose.Scale.x - block.Scale.x) < SCALE_TOLERANCE && fabs(pose.Scale.y - block.Scale.y) < SCALE_TOLERANCE && fabs(pose.Scale.z - block.Scale.z) < SCALE_TOLERANCE)
+      {
+        // At least one quantum, so the reconstructed timestamps keep increasing
+        sample.TimeDelta = static_cast<uint16>((std::max)(1.0, floor(timeDelta + 0.5)));
+        sample.Rotation = EncodeRotation(pose.Rotation);
+        sample.Status = static_cast<uint8>(toolStatus);
+        block.Samples.push_back(sample);
+        block.LastTimestamp += sample.TimeDelta * TIME_QUANTUM_SEC;
+        ++m_numberOfSamples;
+        if (m_decodedBlockValid[0] && m_decodedBlocks[0].BlockIndex == m_blocks.size() - 1)
+        {
+          m_decodedBlockValid[0] = false;
+        }
+        if (m_decodedBlockValid[1] && m_decodedBlocks[1].BlockIndex == m_blocks.size() - 1)
+        {
+          m_decodedBlockValid[1] = false;
+        }
+        return true;
+      }
+    }
+
+    if (!StartBlock(timestamp, uid, pose))
+    {
+      return false;
+    }
+    PackedPoseBlock& block = m_blocks.back();
+    PackedPoseSample sample;
+    EncodeTranslation(block, pose.Translation, sample.Translation);
+    sample.TimeDelta = 0;
+    sample.Rotation = EncodeRotation(pose.Rotation);
+    sample.Status = static_cast<uint8>(toolStatus);
+    block.Samples.push_back(sample);
+    ++m_numberOfSamples;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool CompactPoseHistory::StartBlock(double timestamp, BufferItemUidType uid, const ToolPose& pose)
+  {
+    if (m_translationResolution <= 0.f)
+    {
+      return false;
+    }
+
+    PackedPoseBlock block;
+    block.FirstTimestamp = timestamp;
+    block.LastTimestamp = timestamp;
+    block.FirstUid = uid;
+    block.Origin = pose.Translation;
+    block.Scale = pose.Scale;
+    block.TranslationResolution = m_translationResolution;
+    block.Samples.reserve(MAXIMUM_SAMPLES_PER_BLOCK);
+
+    m_blocks.push_back(std::move(block));
+    m_blockFirstTimestamps.push_back(static_cast<float>(timestamp));
+    m_blockFirstSamples.push_back(m_numberOfSamples);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool CompactPoseHistory::EncodeTranslation(const PackedPoseBlock& block, const float3& translation, int16 outTranslation[3]) const
+  {
+    const float3 steps = (translation - block.Origin) / block.TranslationResolution;
+    const float values[3] = { steps.x, steps.y, steps.z };
+    for (int i = 0; i < 3; ++i)
+    {
+      const float rounded = floor(values[i] + 0.5f);
+      if (rounded < -32767.f || rounded > 32767.f)
+      {
+        return false;
+      }
+      outTranslation[i] = static_cast<int16>(rounded);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void CompactPoseHistory::Clear()
+  {
+    m_blocks.clear();
+    m_blockFirstTimestamps.clear();
+    m_blockFirstSamples.clear();
+    m_numberOfSamples = 0;
+    m_decodedBlockValid[0] = false;
+    m_decodedBlockValid[1] = false;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 CompactPoseHistory::GetNumberOfSamples() const
+  {
+    return m_numberOfSamples;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 CompactPoseHistory::GetMemoryUsageBytes() const
+  {
+    uint64 bytes = m_blocks.capacity() * sizeof(PackedPoseBlock) + m_blockFirstTimestamps.capacity() * sizeof(float) + m_blockFirstSamples.capacity() * sizeof(uint64);
+    for (const auto& block : m_blocks)
+    {
+      bytes += block.Samples.capacity() * sizeof(PackedPoseSample);
+    }
+    return bytes;
+  }
+
+  //----------------------------------------------------------------------------
+  float CompactPoseHistory::GetTranslationResolution() const
+  {
+    return m_translationResolution;
+  }
+
+  //----------------------------------------------------------------------------
+  bool CompactPoseHistory::GetOldestTimeStamp(float& outTimestamp) const
+  {
+    if (m_blocks.empty())
+    {
+      return false;
+    }
+    outTimestamp = m_blockFirstTimestamps.front();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  const CompactPoseHistory::DecodedPoseBlock& CompactPoseHistory::DecodeBlock(size_t blockIndex)
+  {
+    for (uint32 i = 0; i < 2; ++i)
+    {
+      if (m_decodedBlockValid[i] && m_decodedBlocks[i].BlockIndex == blockIndex)
+      {
+        return m_decodedBlocks[i];
+      }
+    }
+
+    // Replace the block that was decoded first, the storage of the decoded arrays is reused
+    DecodedPoseBlock& decoded = m_decodedBlocks[m_nextDecodedBlock];
+    m_decodedBlockValid[m_nextDecodedBlock] = true;
+    m_nextDecodedBlock = 1 - m_nextDecodedBlock;
+
+    const PackedPoseBlock& block = m_blocks[blockIndex];
+    const size_t count = block.Samples.size();
+    decoded.BlockIndex = blockIndex;
+    decoded.Timestamps.resize(count);
+    decoded.Poses.resize(count);
+    decoded.Status.resize(count);
+
+    double timestamp = block.FirstTimestamp;
+    for (size_t i = 0; i < count; ++i)
+    {
+      const PackedPoseSample& sample = block.Samples[i];
+      timestamp += sample.TimeDelta * TIME_QUANTUM_SEC;
+      decoded.Timestamps[i] = static_cast<float>(timestamp);
+      decoded.Poses[i].Rotation = DecodeRotation(sample.Rotation);
+      decoded.Poses[i].Translation = block.Origin + float3(sample.Translation[0], sample.Translation[1], sample.Translation[2]) * block.TranslationResolution;
+      decoded.Poses[i].Scale = block.Scale;
+      decoded.Status[i] = sample.Status;
+    }
+    return decoded;
+  }
+
+  //----------------------------------------------------------------------------
+  void CompactPoseHistory::GetSample(uint64 sampleNumber, float& outTimestamp, ToolPose& outPose, uint8& outStatus)
+  {
+    // Last block whose first sample is not after the requested one
+    const size_t blockIndex = (std::upper_bound(m_blockFirstSamples.begin(), m_blockFirstSamples.end(), sampleNumber) - m_blockFirstSamples.begin()) - 1;
+    const DecodedPoseBlock& decoded = DecodeBlock(blockIndex);
+    const size_t i = static_cast<size_t>(sampleNumber - m_blockFirstSamples[blockIndex]);
+    outTimestamp = decoded.Timestamps[i];
+    outPose = decoded.Poses[i];
+    outStatus = decoded.Status[i];
+  }
+
+  //----------------------------------------------------------------------------
+  BufferItemUidType CompactPoseHistory::GetSampleUid(uint64 sampleNumber) const
+  {
+    const size_t blockIndex = (std::upper_bound(m_blockFirstSamples.begin(), m_blockFirstSamples.end(), sampleNumber) - m_blockFirstSamples.begin()) - 1;
+    return m_blocks[blockIndex].FirstUid + (sampleNumber - m_blockFirstSamples[blockIndex]);
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus CompactPoseHistory::FindClosestSample(float localTime, uint64& outSampleNumber)
+  {
+    if (m_numberOfSamples == 0)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    if (localTime < m_blockFirstTimestamps.front() - NEGLIGIBLE_TIME_DIFFERENCE)
+    {
+      return ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    if (localTime > m_blocks.back().LastTimestamp + NEGLIGIBLE_TIME_DIFFERENCE)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+
+    // Block containing the time, then the first sample of the block later than the time
+    const size_t blockIndex = (std::max)(static_cast<ptrdiff_t>(0),
+                                         (std::upper_bound(m_blockFirstTimestamps.begin(), m_blockFirstTimestamps.end(), localTime) - m_blockFirstTimestamps.begin()) - 1);
+    const DecodedPoseBlock& decoded = DecodeBlock(blockIndex);
+    const size_t later = std::upper_bound(decoded.Timestamps.begin(), decoded.Timestamps.end(), localTime) - decoded.Timestamps.begin();
+    const uint64 firstSample = m_blockFirstSamples[blockIndex];
+    if (later == 0)
+    {
+      outSampleNumber = firstSample;
+      return ITEM_OK;
+    }
+
+    const float earlierTime = decoded.Timestamps[later - 1];
+    float laterTime(0.f);
+    if (later < decoded.Timestamps.size())
+    {
+      laterTime = decoded.Timestamps[later];
+    }
+    else if (blockIndex + 1 < m_blocks.size())
+    {
+      laterTime = m_blockFirstTimestamps[blockIndex + 1];
+    }
+    else
+    {
+      outSampleNumber = firstSample + later - 1;
+      return ITEM_OK;
+    }
+    outSampleNumber = (laterTime - localTime < localTime - earlierTime) ? firstSample + later : firstSample + later - 1;
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus CompactPoseHistory::EvaluatePose(float localTime, DATA_ITEM_TEMPORAL_INTERPOLATION interpolation, float maxAllowedTimeDifference, PoseBufferSample& outSample)
+  {
+    uint64 sampleA(0);
+    ItemStatus status = FindClosestSample(localTime, sampleA);
+    if (status != ITEM_OK)
+    {
+      return status;
+    }
+
+    float timeA(0.f);
+    ToolPose poseA;
+    uint8 statusA(0);
+    GetSample(sampleA, timeA, poseA, statusA);
+    outSample.Uid = GetSampleUid(sampleA);
+    outSample.Index = 0;
+    outSample.FilteredTimestamp = timeA;
+    outSample.UnfilteredTimestamp = timeA;
+    outSample.Pose = poseA;
+    outSample.Status = static_cast<TOOL_STATUS>(statusA);
+    outSample.Matrix = ComposeMatrix(poseA.Scale, poseA.Rotation, poseA.Translation);
+
+    if (fabs(timeA - localTime) < NEGLIGIBLE_TIME_DIFFERENCE || interpolation == CLOSEST_TIME)
+    {
+      return ITEM_OK;
+    }
+    if (interpolation != INTERPOLATED && interpolation != EXTRAPOLATED)
+    {
+      // No sample exactly at the requested time
+      return ITEM_UNKNOWN_ERROR;
+    }
+
+    // If the interpolation is not possible the closest pose is returned with TOOL_MISSING status
+    outSample.FilteredTimestamp = localTime;
+    outSample.UnfilteredTimestamp = localTime;
+    outSample.Status = TOOL_MISSING;
+
+    const bool sampleBisOlder = localTime < timeA;
+    if (statusA != TOOL_OK || fabs(timeA - localTime) > maxAllowedTimeDifference ||
+        (sampleBisOlder && sampleA == 0) || (!sampleBisOlder && sampleA + 1 >= m_numberOfSamples))
+    {
+      return ITEM_OK;
+    }
+
+    float timeB(0.f);
+    ToolPose poseB;
+    uint8 statusB(0);
+    GetSample(sampleBisOlder ? sampleA - 1 : sampleA + 1, timeB, poseB, statusB);
+    if (statusB != TOOL_OK || fabs(timeB - localTime) > maxAllowedTimeDifference)
+    {
+      return ITEM_OK;
+    }
+
+    const float sampleBweight = (localTime - timeA) / (timeB - timeA);
+    outSample.Matrix = InterpolateDecomposedMatrix(poseA.Scale, poseA.Rotation, poseA.Translation, poseB.Scale, poseB.Rotation, poseB.Translation, sampleBweight,
+                       outSample.Pose.Scale, outSample.Pose.Rotation, outSample.Pose.Translation);
+    outSample.UnfilteredTimestamp = localTime;
+    outSample.Status = TOOL_OK;
+    return ITEM_OK;
+  }
+}
@@ -0,0 +1,129 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+#include "TimestampedCircularBuffer.h"
+
+// STL includes
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+#pragma pack(push, 1)
+  /// Quantised pose sample, 13 bytes
+  struct PackedPoseSample
+  {
+    uint32  Rotation;         // smallest three: index of the omitted (largest) component in the top 2 bits, 3 x 10 bit components
+    int16   Translation[3];   // fixed point, relative to the block origin
+    uint16  TimeDelta;        // time since the previous sample of the block, in TIME_QUANTUM_SEC units
+    uint8   Status;
+  };
+#pragma pack(pop)
+
+  /// Samples sharing a time base, translation origin and scale
+  struct PackedPoseBlock
+  {
+    double                                    FirstTimestamp = 0.0;
+    double                                    LastTimestamp = 0.0;   // reconstructed, the next sample is delta coded against it
+    BufferItemUidType                         FirstUid = 0;          // the samples of a block have consecutive uids
+    Windows::Foundation::Numerics::float3     Origin;
+    Windows::Foundation::Numerics::float3     Scale;
+    float                                     TranslationResolution = 0.f;
+    std::vector<PackedPoseSample>             Samples;
+  };
+
+  /*
+  Append-only quantised pose history for long recordings (hours of tracker data), used by PoseBuffer.
+  Samples are grouped in blocks of up to 256 samples and decoded a block at a time on query.
+  Encoding and worst case error of a reconstructed sample:
+    - rotation: smallest three quaternion with 10 bits per component, below 0.3 degrees
+    - translation: 16 bit fixed point relative to the block origin, at most half of the translation resolution per axis
+      (a sample that does not fit the range of the block starts a new block)
+    - timestamp: 16 bit delta to the previous sample in 10 microsecond steps (a gap of more than 0.65 seconds starts a new block).
+      For samples at least 10 microseconds apart the reconstruction is within 5 microseconds of the input and the error does not
+      accumulate (closer samples are pushed one step later). Timestamps enter and leave as float local time, so the result is
+      also rounded to the float spacing (up to 2^-23 of the local time, 244 microseconds after one hour): above 128 seconds the
+      input timestamp is returned exactly, and the timing precision is that of the float local time, not the 10 microsecond step.
+    - scale: one per block (rigid tools), a sample with a different scale starts a new block
+  The uid is stored once per block, a sample that does not follow the previous one (e.g. after a rejected sample) starts a new block.
+  The frame index is not stored. Memory use is about 13.3 bytes per sample.
+  Not thread safe, the owning PoseBuffer serializes the calls.
+  */
+  class CompactPoseHistory
+  {
+  public:
+    explicit CompactPoseHistory(float translationResolution);
+
+    /// Append a sample with the uid of its buffer item, the timestamp (local time) must be later than the latest one
+    bool AddSample(float timestamp, BufferItemUidType uid, const ToolPose& pose, int toolStatus);
+    void Clear();
+
+    uint64 GetNumberOfSamples() const;
+    uint64 GetMemoryUsageBytes() const;
+    float GetTranslationResolution() const;
+    /// Local timestamp of the oldest sample, returns false if there are no samples
+    bool GetOldestTimeStamp(float& outTimestamp) const;
+
+    /*!
+      Evaluate the pose at the local time with the rules of PoseBuffer (and Buffer) temporal queries.
+      The uid of the result is the one the sample was added with, the index is not stored and set to 0.
+    */
+    ItemStatus EvaluatePose(float localTime, DATA_ITEM_TEMPORAL_INTERPOLATION interpolation, float maxAllowedTimeDifference, PoseBufferSample& outSample);
+
+  protected:
+    struct DecodedPoseBlock
+    {
+      size_t                  BlockIndex = 0;
+      std::vector<float>      Timestamps;
+      std::vector<ToolPose>   Poses;
+      std::vector<uint8>      Status;
+    };
+
+    bool StartBlock(double timestamp, BufferItemUidType uid, const ToolPose& pose);
+    bool EncodeTranslation(const PackedPoseBlock& block, const Windows::Foundation::Numerics::float3& translation, int16 outTranslation[3]) const;
+    /// Decode a block, the two most recently decoded blocks are cached
+    const DecodedPoseBlock& DecodeBlock(size_t blockIndex);
+    /// Decode one sample by its sample number
+    void GetSample(uint64 sampleNumber, float& outTimestamp, ToolPose& outPose, uint8& outStatus);
+    /// Uid of a sample by its sample number
+    BufferItemUidType GetSampleUid(uint64 sampleNumber) const;
+    /// Sample number of the sample closest to the local time
+    ItemStatus FindClosestSample(float localTime, uint64& outSampleNumber);
+
+  protected:
+    float                           m_translationResolution;
+    std::vector<PackedPoseBlock>    m_blocks;
+    std::vector<float>              m_blockFirstTimestamps;   // for the search, one per block
+    std::vector<uint64>             m_blockFirstSamples;      // sample number of the first sample of each block
+    uint64                          m_numberOfSamples;
+    DecodedPoseBlock                m_decodedBlocks[2];
+    bool                            m_decodedBlockValid[2];
+    uint32                          m_nextDecodedBlock;
+  };
+}
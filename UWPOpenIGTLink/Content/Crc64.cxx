@@ -0,0 +1,253 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "pch.h"
+#include "Crc64.h"
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define UWPOPENIGTLINK_CRC64_CLMUL
+  // Intrinsic includes
+  #include <intrin.h>
+  #include <emmintrin.h>
+  #include <tmmintrin.h>
+  #include <wmmintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    /// ECMA-182 polynomial, the x^64 term is implicit
+    static const uint64 CRC64_POLYNOMIAL = 0x42F0E1EBA9EA3693ULL;
+
+    //----------------------------------------------------------------------------
+    /// Compute x^n mod P, used to derive the folding constants
+    uint64 XPowModPolynomial(uint32 n)
+    {
+      uint64 result = 1;
+      for (uint32 i = 0; i < n; ++i)
+      {
+        result = (result & 0x8000000000000000ULL) ? ((result << 1) ^ CRC64_POLYNOMIAL) : (result << 1);
+      }
+      return result;
+    }
+
+    //----------------------------------------------------------------------------
+    inline uint64 LoadBigEndian64(const byte* data)
+    {
+      return (static_cast<uint64>(data[0]) << 56) | (static_cast<uint64>(data[1]) << 48) |
+             (static_cast<uint64>(data[2]) << 40) | (static_cast<uint64>(data[3]) << 32) |
+             (static_cast<uint64>(data[4]) << 24) | (static_cast<uint64>(data[5]) << 16) |
+             (static_cast<uint64>(data[6]) << 8) | static_cast<uint64>(data[7]);
+    }
+
+    //----------------------------------------------------------------------------
+    struct Crc64Tables
+    {
+      Crc64Tables()
+      {
+        for (uint32 i = 0; i < 256; ++i)
+        {
+          uint64 crc = static_cast<uint64>(i) << 56;
+          for (int bit = 0; bit < 8; ++bit)
+          {
+            crc = (crc & 0x8000000000000000ULL) ? ((crc << 1) ^ CRC64_POLYNOMIAL) : (crc << 1);
+          }
+          Slice[0][i] = crc;
+        }
+        // Slice[k][i] is the contribution of byte i followed by k zero bytes
+        for (uint32 i = 0; i < 256; ++i)
+        {
+          for (int k = 1; k < 8; ++k)
+          {
+            uint64 previous = Slice[k - 1][i];
+            Slice[k][i] = (previous << 8) ^ Slice[0][previous >> 56];
+          }
+        }
+
+        // Folding constants for the carry-less multiplication kernel (128 and 512 bit strides)
+        Fold128High = XPowModPolynomial(128 + 64);
+        Fold128Low = XPowModPolynomial(128);
+        Fold512High = XPowModPolynomial(512 + 64);
+        Fold512Low = XPowModPolynomial(512);
+      }
+
+      uint64 Slice[8][256];
+      uint64 Fold128High;
+      uint64 Fold128Low;
+      uint64 Fold512High;
+      uint64 Fold512Low;
+    };
+
+    //----------------------------------------------------------------------------
+    const Crc64Tables& GetTables()
+    {
+      static const Crc64Tables tables;
+      return tables;
+    }
+
+    //----------------------------------------------------------------------------
+    uint64 Crc64SliceBy8(const byte* data, uint64 length, uint64 crc)
+    {
+      const Crc64Tables& tables = GetTables();
+      const auto& slice = tables.Slice;
+
+      while (length >= 8)
+      {
+        uint64 value = crc ^ LoadBigEndian64(data);
+        crc = slice[7][value >> 56] ^ slice[6][(value >> 48) & 0xFF] ^
+              slice[5][(value >> 40) & 0xFF] ^ slice[4][(value >> 32) & 0xFF] ^
+              slice[3][(value >> 24) & 0xFF] ^ slice[2][(value >> 16) & 0xFF] ^
+              slice[1][(value >> 8) & 0xFF] ^ slice[0][value & 0xFF];
+        data += 8;
+        length -= 8;
+      }
+
+      while (length > 0)
+      {
+        crc = slice[0][(crc >> 56) ^ *data] ^ (crc << 8);
+        ++data;
+        --length;
+      }
+
+      return crc;
+    }
+
+#ifdef UWPOPENIGTLINK_CRC64_CLMUL
+    //----------------------------------------------------------------------------
+    /// Load 16 bytes so that the first byte of the stream is the most significant byte of the register
+    inline __m128i LoadBigEndian128(const byte* data, const __m128i& byteReverseMask)
+    {
+      return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), byteReverseMask);
+    }
+
+    //----------------------------------------------------------------------------
+    /// Multiply the high and low halves of the accumulator by x^(stride+64) and x^stride (mod P) and add them together
+    inline __m128i Fold(const __m128i& accumulator, const __m128i& constants)
+    {
+      return _mm_xor_si128(_mm_clmulepi64_si128(accumulator, constants, 0x11), _mm_clmulepi64_si128(accumulator, constants, 0x00));
+    }
+
+    //----------------------------------------------------------------------------
+    uint64 Crc64CarrylessMultiply(const byte* data, uint64 length, uint64 crc)
+    {
+      if (length < 64)
+      {
+        return Crc64SliceBy8(data, length, crc);
+      }
+
+      const Crc64Tables& tables = GetTables();
+      const __m128i byteReverseMask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+      const __m128i fold512 = _mm_set_epi64x(static_cast<int64>(tables.Fold512High), static_cast<int64>(tables.Fold512Low));
+      const __m128i fold128 = _mm_set_epi64x(static_cast<int64>(tables.Fold128High), static_cast<int64>(tables.Fold128Low));
+
+      // Four independent 128 bit accumulators, the running crc is added to the most significant bits of the first one
+      __m128i accumulator0 = _mm_xor_si128(LoadBigEndian128(data, byteReverseMask), _mm_set_epi64x(static_cast<int64>(crc), 0));
+      __m128i accumulator1 = LoadBigEndian128(data + 16, byteReverseMask);
+      __m128i accumulator2 = LoadBigEndian128(data + 32, byteReverseMask);
+      __m128i accumulator3 = LoadBigEndian128(data + 48, byteReverseMask);
+      data += 64;
+      length -= 64;
+
+      while (length >= 64)
+      {
+        accumulator0 = _mm_xor_si128(Fold(accumulator0, fold512), LoadBigEndian128(data, byteReverseMask));
+        accumulator1 = _mm_xor_si128(Fold(accumulator1, fold512), LoadBigEndian128(data + 16, byteReverseMask));
+        accumulator2 = _mm_xor_si128(Fold(accumulator2, fold512), LoadBigEndian128(data + 32, byteReverseMask));
+        accumulator3 = _mm_xor_si128(Fold(accumulator3, fold512), LoadBigEndian128(data + 48, byteReverseMask));
+        data += 64;
+        length -= 64;
+      }
+
+      // Combine the accumulators into one
+      __m128i accumulator = _mm_xor_si128(Fold(accumulator0, fold128), accumulator1);
+      accumulator = _mm_xor_si128(Fold(accumulator, fold128), accumulator2);
+      accumulator = _mm_xor_si128(Fold(accumulator, fold128), accumulator3);
+
+      while (length >= 16)
+      {
+        accumulator = _mm_xor_si128(Fold(accumulator, fold128), LoadBigEndian128(data, byteReverseMask));
+        data += 16;
+        length -= 16;
+      }
+
+      // The remaining 128 bits are reduced by running them through the table implementation, which also handles the tail
+      byte folded[16];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(folded), _mm_shuffle_epi8(accumulator, byteReverseMask));
+      crc = Crc64SliceBy8(folded, 16, 0);
+      return Crc64SliceBy8(data, length, crc);
+    }
+
+    //----------------------------------------------------------------------------
+    bool ProcessorSupportsCarrylessMultiply()
+    {
+      int cpuInfo[4] = { 0, 0, 0, 0 };
+      __cpuid(cpuInfo, 1);
+      const bool hasSSSE3 = (cpuInfo[2] & (1 << 9)) != 0;
+      const bool hasPCLMULQDQ = (cpuInfo[2] & (1 << 1)) != 0;
+      return hasSSSE3 && hasPCLMULQDQ;
+    }
+#endif
+
+    typedef uint64(*Crc64Function)(const byte*, uint64, uint64);
+
+    //----------------------------------------------------------------------------
+    Crc64Function SelectImplementation()
+    {
+#ifdef UWPOPENIGTLINK_CRC64_CLMUL
+      if (ProcessorSupportsCarrylessMultiply())
+      {
+        return &Crc64CarrylessMultiply;
+      }
+#endif
+      return &Crc64SliceBy8;
+    }
+
+    //----------------------------------------------------------------------------
+    Crc64Function GetImplementation()
+    {
+      static const Crc64Function implementation = SelectImplementation();
+      return implementation;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Crc64(const byte* data, uint64 length, uint64 crc)
+  {
+    if (data == nullptr || length == 0)
+    {
+      return crc;
+    }
+    return GetImplementation()(data, length, crc);
+  }
+
+  //----------------------------------------------------------------------------
+  bool Crc64IsAccelerated()
+  {
+    return GetImplementation() != &Crc64SliceBy8;
+  }
+}
@@ -0,0 +1,44 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    CRC64 (ECMA-182 polynomial, MSB first, zero initial value) as used by the OpenIGTLink header and body checksum.
+    The result is identical to crc64() in igtl_util.h but the implementation is selected at runtime:
+    a carry-less multiplication (PCLMULQDQ) folding kernel on x86/x64 processors that support it,
+    otherwise a slicing-by-8 table implementation that processes 8 bytes per step.
+    \param data pointer to the data to checksum
+    \param length number of bytes to process
+    \param crc initial value, pass a previous result to continue a checksum over multiple buffers
+  */
+  uint64 Crc64(const byte* data, uint64 length, uint64 crc = 0);
+
+  /// Return true if the PCLMULQDQ accelerated implementation has been selected on this processor
+  bool Crc64IsAccelerated();
+}
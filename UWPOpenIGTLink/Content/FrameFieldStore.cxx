@@ -0,0 +1,289 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#include "pch.h"
+#include "FrameFieldStore.h"
+
+// STL includes
+#include <algorithm>
+
+namespace
+{
+  //-------------------------------------------------------
+  size_t HashFieldName(const wchar_t* fieldName, uint32 length)
+  {
+    // FNV-1a
+    size_t hash = static_cast<size_t>(14695981039346656037ULL);
+    for (uint32 i = 0; i < length; ++i)
+    {
+      hash ^= static_cast<size_t>(fieldName[i]);
+      hash *= static_cast<size_t>(1099511628211ULL);
+    }
+    return hash;
+  }
+}
+
+namespace UWPOpenIGTLink
+{
+  //-------------------------------------------------------
+  FrameFieldNameTable& FrameFieldNameTable::Instance()
+  {
+    static FrameFieldNameTable table;
+    return table;
+  }
+
+  //-------------------------------------------------------
+  FrameFieldNameTable::FrameFieldNameTable()
+  {
+  }
+
+  //-------------------------------------------------------
+  FrameFieldId FrameFieldNameTable::Intern(const wchar_t* fieldName, uint32 length)
+  {
+    if (fieldName == nullptr || length == 0)
+    {
+      return INVALID_FRAME_FIELD_ID;
+    }
+
+    const size_t hash = HashFieldName(fieldName, length);
+    std::lock_guard<std::mutex> guard(m_mutex);
+    FrameFieldId id = FindInternal(hash, fieldName, length);
+    if (id != INVALID_FRAME_FIELD_ID)
+    {
+      return id;
+    }
+
+    m_fieldNames.push_back(std::wstring(fieldName, length));
+    m_isTransformField.push_back(m_fieldNames.back().find(L"Transform") != std::wstring::npos);
+    id = static_cast<FrameFieldId>(m_fieldNames.size());
+    m_fieldIds.insert(std::make_pair(hash, id));
+    return id;
+  }
+
+  //-------------------------------------------------------
+  FrameFieldId FrameFieldNameTable::Find(const wchar_t* fieldName, uint32 length) const
+  {
+    if (fieldName == nullptr || length == 0)
+    {
+      return INVALID_FRAME_FIELD_ID;
+    }
+
+    const size_t hash = HashFieldName(fieldName, length);
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return FindInternal(hash, fieldName, length);
+  }
+
+  //-------------------------------------------------------
+  FrameFieldId FrameFieldNameTable::FindInternal(size_t hash, const wchar_t* fieldName, uint32 length) const
+  {
+    // the caller must have locked the table
+    auto range = m_fieldIds.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+      const std::wstring& name = m_fieldNames[iter->second - 1];
+      if (name.size() == length && std::equal(name.begin(), name.end(), fieldName))
+      {
+        return iter->second;
+      }
+    }
+    return INVALID_FRAME_FIELD_ID;
+  }
+
+  //-------------------------------------------------------
+  const std::wstring& FrameFieldNameTable::GetName(FrameFieldId id) const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (id == INVALID_FRAME_FIELD_ID || id > m_fieldNames.size())
+    {
+      return m_emptyName;
+    }
+    return m_fieldNames[id - 1];
+  }
+
+  //-------------------------------------------------------
+  bool FrameFieldNameTable::IsTransformField(FrameFieldId id) const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (id == INVALID_FRAME_FIELD_ID || id > m_isTransformField.size())
+    {
+      return false;
+    }
+    return m_isTransformField[id - 1];
+  }
+
+  //-------------------------------------------------------
+  void FrameFieldStore::Set(FrameFieldId id, const wchar_t* value, uint32 length)
+  {
+    if (id == INVALID_FRAME_FIELD_ID)
+    {
+      return;
+    }
+    if (value == nullptr)
+    {
+      length = 0;
+    }
+
+    auto entry = FindEntry(id);
+    if (entry != m_entries.end() && length <= entry->Capacity)
+    {
+      // Overwrite in place
+      std::copy(value, value + length, m_values.begin() + entry->Offset);
+      m_values[entry->Offset + length] = L'\0';
+      entry->Length = length;
+      return;
+    }
+
+    if (entry != m_entries.end())
+    {
+      // The old value does not fit, it becomes unused
+      m_unusedCharacters += entry->Capacity + 1;
+      entry->Offset = static_cast<uint32>(m_values.size());
+      entry->Length = length;
+      entry->Capacity = length;
+    }
+    else
+    {
+      m_entries.push_back(FieldEntry{ id, static_cast<uint32>(m_values.size()), length, length });
+    }
+    m_values.insert(m_values.end(), value, value + length);
+    m_values.push_back(L'\0');
+
+    if (m_unusedCharacters > m_values.size() / 2)
+    {
+      Compact();
+    }
+  }
+
+  //-------------------------------------------------------
+  bool FrameFieldStore::Get(FrameFieldId id, const wchar_t*& outValue, uint32& outLength) const
+  {
+    auto entry = FindEntry(id);
+    if (entry == m_entries.end())
+    {
+      return false;
+    }
+    outValue = m_values.data() + entry->Offset;
+    outLength = entry->Length;
+    return true;
+  }
+
+  //-------------------------------------------------------
+  bool FrameFieldStore::Erase(FrameFieldId id)
+  {
+    auto entry = FindEntry(id);
+    if (entry == m_entries.end())
+    {
+      return false;
+    }
+    m_unusedCharacters += entry->Capacity + 1;
+    m_entries.erase(entry);
+    if (m_entries.empty())
+    {
+      Clear();
+    }
+    return true;
+  }
+
+  //-------------------------------------------------------
+  void FrameFieldStore::Clear()
+  {
+    m_entries.clear();
+    m_values.clear();
+    m_unusedCharacters = 0;
+  }
+
+  //-------------------------------------------------------
+  bool FrameFieldStore::Empty() const
+  {
+    return m_entries.empty();
+  }
+
+  //-------------------------------------------------------
+  uint32 FrameFieldStore::GetNumberOfFields() const
+  {
+    return static_cast<uint32>(m_entries.size());
+  }
+
+  //-------------------------------------------------------
+  void FrameFieldStore::GetField(uint32 position, FrameFieldId& outId, const wchar_t*& outValue, uint32& outLength) const
+  {
+    const FieldEntry& entry = m_entries[position];
+    outId = entry.Id;
+    outValue = m_values.data() + entry.Offset;
+    outLength = entry.Length;
+  }
+
+  //-------------------------------------------------------
+  FrameFields FrameFieldStore::ToFrameFields() const
+  {
+    FrameFields fields;
+    for (const auto& entry : m_entries)
+    {
+      fields[FrameFieldNameTable::Instance().GetName(entry.Id)] = std::wstring(m_values.data() + entry.Offset, entry.Length);
+    }
+    return fields;
+  }
+
+  //-------------------------------------------------------
+  std::vector<FrameFieldStore::FieldEntry>::iterator FrameFieldStore::FindEntry(FrameFieldId id)
+  {
+    return std::find_if(m_entries.begin(), m_entries.end(), [id](const FieldEntry & entry)
+    {
+      return entry.Id == id;
+    });
+  }
+
+  //-------------------------------------------------------
+  std::vector<FrameFieldStore::FieldEntry>::const_iterator FrameFieldStore::FindEntry(FrameFieldId id) const
+  {
+    return std::find_if(m_entries.begin(), m_entries.end(), [id](const FieldEntry & entry)
+    {
+      return entry.Id == id;
+    });
+  }
+
+  //-------------------------------------------------------
+  void FrameFieldStore::Compact()
+  {
+    // Move the values to the front in storage order (so no value is overwritten before it is moved), every entry keeps its capacity
+    std::sort(m_entries.begin(), m_entries.end(), [](const FieldEntry & a, const FieldEntry & b)
+    {
+      return a.Offset < b.Offset;
+    });
+    uint32 offset(0);
+    for (auto& entry : m_entries)
+    {
+      if (entry.Offset != offset)
+      {
+        std::copy(m_values.begin() + entry.Offset, m_values.begin() + entry.Offset + entry.Capacity + 1, m_values.begin() + offset);
+        entry.Offset = offset;
+      }
+      offset += entry.Capacity + 1;
+    }
+    m_values.resize(offset);
+    m_unusedCharacters = 0;
+  }
+}
@@ -0,0 +1,120 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// STL includes
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  typedef uint32 FrameFieldId;
+  static const FrameFieldId INVALID_FRAME_FIELD_ID = 0;
+
+  /*
+  Process-wide table of interned custom frame field names.
+  Each unique field name is assigned a compact integer id the first time it is seen, so items store ids instead of names.
+  Lookups hash the characters in place, they do not allocate once the name is known.
+  Ids are never released, they are valid for the lifetime of the process.
+  */
+  class FrameFieldNameTable
+  {
+  public:
+    static FrameFieldNameTable& Instance();
+
+    /// Return the id of the field name, interning it if it has not been seen before
+    FrameFieldId Intern(const wchar_t* fieldName, uint32 length);
+    /// Return the id of the field name, INVALID_FRAME_FIELD_ID if it has never been interned
+    FrameFieldId Find(const wchar_t* fieldName, uint32 length) const;
+
+    /// Return the field name of an id, empty string if the id is unknown
+    const std::wstring& GetName(FrameFieldId id) const;
+    /// Returns true if the field name contains "Transform" (the field carries transform data), computed once per name
+    bool IsTransformField(FrameFieldId id) const;
+
+  protected:
+    FrameFieldNameTable();
+
+    FrameFieldId FindInternal(size_t hash, const wchar_t* fieldName, uint32 length) const;
+
+  protected:
+    mutable std::mutex                                    m_mutex;
+    std::unordered_multimap<size_t, FrameFieldId>         m_fieldIds;           // hash of the name -> id
+    std::deque<std::wstring>                              m_fieldNames;         // index is id - 1, deque keeps references stable
+    std::vector<bool>                                     m_isTransformField;   // index is id - 1
+    std::wstring                                          m_emptyName;
+  };
+
+  /*
+  Custom frame fields of one buffer item: interned field ids and the values packed in a character arena.
+  Clearing keeps the capacity, so a buffer slot that is overwritten reuses its storage and setting fields
+  of the usual size does not allocate. Replaced values are compacted away when they make up most of the arena.
+  */
+  class FrameFieldStore
+  {
+  public:
+    /// Set the value of a field, replacing the previous value
+    void Set(FrameFieldId id, const wchar_t* value, uint32 length);
+    /// Get the value of a field (null terminated), returns false if the field is not set
+    bool Get(FrameFieldId id, const wchar_t*& outValue, uint32& outLength) const;
+    /// Remove a field, returns false if the field is not set
+    bool Erase(FrameFieldId id);
+    /// Remove all fields, keeping the storage
+    void Clear();
+
+    bool Empty() const;
+    uint32 GetNumberOfFields() const;
+    /// Get the field at position (0 <= position < GetNumberOfFields())
+    void GetField(uint32 position, FrameFieldId& outId, const wchar_t*& outValue, uint32& outLength) const;
+
+    /// Convert to a name -> value map
+    FrameFields ToFrameFields() const;
+
+  protected:
+    struct FieldEntry
+    {
+      FrameFieldId  Id;
+      uint32        Offset;   // in characters, into m_values
+      uint32        Length;   // in characters, without the terminating null
+      uint32        Capacity; // in characters, without the terminating null
+    };
+
+    std::vector<FieldEntry>::iterator FindEntry(FrameFieldId id);
+    std::vector<FieldEntry>::const_iterator FindEntry(FrameFieldId id) const;
+    void Compact();
+
+  protected:
+    std::vector<FieldEntry>   m_entries;          // a handful of fields per item, searched linearly
+    std::vector<wchar_t>      m_values;           // null terminated values
+    uint32                    m_unusedCharacters = 0;
+  };
+}
@@ -0,0 +1,370 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#include "pch.h"
+#include "FrameSpillStore.h"
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+  static const uint64 SPILL_FRAME_ALIGNMENT = 64; // every spilled frame starts on its own cache line
+  static const size_t MAXIMUM_RESIDENT_READ_SEGMENTS = 2;
+
+  // Unique across all stores of the process, so no store ever recreates a file that may still be mapped
+  std::atomic<uint32> NextSegmentGeneration(0);
+}
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  FrameSpillStore::FrameSpillStore()
+    : m_generation(0)
+    , m_segmentSizeBytes(0)
+    , m_writeOffset(0)
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  FrameSpillStore::~FrameSpillStore()
+  {
+    Close();
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameSpillStore::Open(const std::wstring& directory, uint64 segmentSizeBytes)
+  {
+    Close();
+
+    if (directory.empty() || segmentSizeBytes == 0)
+    {
+      OutputDebugStringA("FrameSpillStore: Invalid spill directory or segment size.");
+      return false;
+    }
+
+    m_directory = directory;
+    m_segmentSizeBytes = segmentSizeBytes;
+    m_generation = NextSegmentGeneration++;
+    if (!StartSegment())
+    {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void FrameSpillStore::Close()
+  {
+    if (m_writeView != nullptr)
+    {
+      FlushViewOfFile(m_writeView.get(), 0);
+    }
+    m_writeView = nullptr;
+    m_residentViews.clear();
+
+    // Items handed out may still reference a view, the view is unmapped when its last reference is released
+    for (auto& segment : m_segments)
+    {
+      if (segment.Mapping != nullptr)
+      {
+        CloseHandle(segment.Mapping);
+      }
+      if (segment.File != INVALID_HANDLE_VALUE)
+      {
+        CloseHandle(segment.File);
+      }
+    }
+    m_segments.clear();
+    m_records.clear();
+    m_timestamps.clear();
+    m_writeOffset = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameSpillStore::IsOpen() const
+  {
+    return !m_segments.empty();
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameSpillStore::Clear()
+  {
+    const std::wstring directory(m_directory);
+    const uint64 segmentSizeBytes(m_segmentSizeBytes);
+    const uint32 generation(m_generation);
+    const uint32 segmentCount(static_cast<uint32>(m_segments.size()));
+    Close();
+
+    // Items handed out may still map a file of the old generation, such a file cannot be deleted and is left on disk
+    for (uint32 i = 0; i < segmentCount; ++i)
+    {
+      DeleteFileW(GetSegmentFileName(generation, i).c_str());
+    }
+
+    return Open(directory, segmentSizeBytes);
+  }
+
+  //----------------------------------------------------------------------------
+  std::wstring FrameSpillStore::GetSegmentFileName(uint32 generation, uint32 segmentIndex) const
+  {
+    return m_directory + L"\\segment_" + std::to_wstring(generation) + L"_" + std::to_wstring(segmentIndex) + L".bin";
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameSpillStore::StartSegment()
+  {
+    // The current segment is complete, write it back and let it be unmapped once no reader uses it
+    if (m_writeView != nullptr)
+    {
+      FlushViewOfFile(m_writeView.get(), m_writeOffset);
+      m_writeView = nullptr;
+    }
+
+    Segment segment;
+    std::wstring fileName = GetSegmentFileName(m_generation, static_cast<uint32>(m_segments.size()));
+    segment.File = CreateFile2(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, CREATE_ALWAYS, nullptr);
+    if (segment.File == INVALID_HANDLE_VALUE)
+    {
+      std::stringstream ss;
+      ss << "FrameSpillStore: Unable to create segment file (error: " << GetLastError() << ").";
+      OutputDebugStringA(ss.str().c_str());
+      return false;
+    }
+
+    // The file is extended to the segment size by the mapping
+    segment.Mapping = CreateFileMappingFromApp(segment.File, nullptr, PAGE_READWRITE, m_segmentSizeBytes, nullptr);
+    if (segment.Mapping == nullptr)
+    {
+      std::stringstream ss;
+      ss << "FrameSpillStore: Unable to map segment file (error: " << GetLastError() << ").";
+      OutputDebugStringA(ss.str().c_str());
+      CloseHandle(segment.File);
+      return false;
+    }
+
+    m_segments.push_back(segment);
+    m_writeView = MapSegment(static_cast<uint32>(m_segments.size() - 1), true);
+    if (m_writeView == nullptr)
+    {
+      return false;
+    }
+    m_writeOffset = 0;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<byte> FrameSpillStore::MapSegment(uint32 segmentIndex, bool writable)
+  {
+    Segment& segment = m_segments[segmentIndex];
+    void* view = MapViewOfFileFromApp(segment.Mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, static_cast<SIZE_T>(m_segmentSizeBytes));
+    if (view == nullptr)
+    {
+      std::stringstream ss;
+      ss << "FrameSpillStore: Unable to map view of segment " << segmentIndex << " (error: " << GetLastError() << ").";
+      OutputDebugStringA(ss.str().c_str());
+      return nullptr;
+    }
+
+    std::shared_ptr<byte> sharedView(static_cast<byte*>(view), [](byte * p)
+    {
+      UnmapViewOfFile(p);
+    });
+    segment.View = sharedView;
+    return sharedView;
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<byte> FrameSpillStore::GetSegmentView(uint32 segmentIndex)
+  {
+    // Reuse a view that is still mapped (the write view or one held by an item)
+    std::shared_ptr<byte> view = m_segments[segmentIndex].View.lock();
+    if (view == nullptr)
+    {
+      view = MapSegment(segmentIndex, false);
+      if (view == nullptr)
+      {
+        return nullptr;
+      }
+    }
+
+    // Keep the most recently read segments mapped, playback tends to read the same segment repeatedly
+    auto iter = std::find(m_residentViews.begin(), m_residentViews.end(), view);
+    if (iter != m_residentViews.end())
+    {
+      m_residentViews.erase(iter);
+    }
+    m_residentViews.push_front(view);
+    if (m_residentViews.size() > MAXIMUM_RESIDENT_READ_SEGMENTS)
+    {
+      m_residentViews.pop_back();
+    }
+    return view;
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameSpillStore::Append(StreamBufferItem^ item)
+  {
+    if (!IsOpen() || item == nullptr)
+    {
+      return false;
+    }
+
+    SpilledItemRecord record;
+    record.FilteredTimestamp = item->GetFilteredTimestamp(0.f);   // 0.0 because timestamps in the buffer are in local time
+    record.UnfilteredTimestamp = item->GetUnfilteredTimestamp(0.f);
+    if (!m_timestamps.empty() && record.FilteredTimestamp <= m_timestamps.back())
+    {
+      OutputDebugStringA("FrameSpillStore: Item timestamp is not newer than the last spilled item, item is not spilled.");
+      return false;
+    }
+    record.Index = item->GetIndex();
+    record.Uid = item->GetUid();
+    record.Status = item->GetStatus();
+    record.ValidTransformData = item->HasValidTransformData();
+    record.Matrix = item->GetMatrix();
+    record.Rotation = item->GetRotation();
+    record.Translation = item->GetTranslation();
+    record.Scale = item->GetScale();
+
+    VideoFrame^ frame = item->GetFrame();
+    std::shared_ptr<byte> frameData = item->HasValidVideoData() ? frame->GetImageDataInternal() : nullptr;
+    if (frameData != nullptr && frame->GetFrameSizeBytes() > 0)
+    {
+      const uint64 frameSizeBytes = frame->GetFrameSizeBytes();
+      if (frameSizeBytes > m_segmentSizeBytes)
+      {
+        OutputDebugStringA("FrameSpillStore: Frame is larger than the segment size, item is not spilled.");
+        return false;
+      }
+
+      const uint64 offset = (m_writeOffset + SPILL_FRAME_ALIGNMENT - 1) / SPILL_FRAME_ALIGNMENT * SPILL_FRAME_ALIGNMENT;
+      if (offset + frameSizeBytes > m_segmentSizeBytes)
+      {
+        if (!StartSegment())
+        {
+          return false;
+        }
+        record.Offset = 0;
+      }
+      else
+      {
+        record.Offset = offset;
+      }
+
+      memcpy(m_writeView.get() + record.Offset, frameData.get(), static_cast<size_t>(frameSizeBytes));
+      m_writeOffset = record.Offset + frameSizeBytes;
+
+      record.Segment = static_cast<uint32>(m_segments.size() - 1);
+      record.FrameSizeBytes = frameSizeBytes;
+      record.Dimensions = frame->GetDimensions();
+      record.ScalarType = static_cast<IGTL_SCALAR_TYPE>(frame->GetScalarPixelType());
+      record.NumberOfScalarComponents = static_cast<uint16>(frame->GetNumberOfScalarComponents());
+      record.ImageType = static_cast<US_IMAGE_TYPE>(frame->GetImageType());
+      record.ImageOrientation = static_cast<US_IMAGE_ORIENTATION>(frame->GetImageOrientation());
+    }
+
+    m_records.push_back(record);
+    m_timestamps.push_back(record.FilteredTimestamp);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 FrameSpillStore::GetNumberOfItems() const
+  {
+    return m_records.size();
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameSpillStore::FindClosestItem(float localTime, uint64& outItemIndex) const
+  {
+    if (m_timestamps.empty())
+    {
+      return false;
+    }
+
+    auto iter = std::lower_bound(m_timestamps.begin(), m_timestamps.end(), localTime);
+    if (iter == m_timestamps.end())
+    {
+      outItemIndex = m_timestamps.size() - 1;
+    }
+    else if (iter == m_timestamps.begin() || *iter - localTime < localTime - *(iter - 1))
+    {
+      outItemIndex = iter - m_timestamps.begin();
+    }
+    else
+    {
+      outItemIndex = iter - m_timestamps.begin() - 1;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  const SpilledItemRecord& FrameSpillStore::GetRecord(uint64 itemIndex) const
+  {
+    return m_records[static_cast<size_t>(itemIndex)];
+  }
+
+  //----------------------------------------------------------------------------
+  StreamBufferItem^ FrameSpillStore::GetItem(uint64 itemIndex)
+  {
+    if (itemIndex >= m_records.size())
+    {
+      return nullptr;
+    }
+
+    const SpilledItemRecord& record = m_records[static_cast<size_t>(itemIndex)];
+    StreamBufferItem^ item = ref new StreamBufferItem();
+    item->SetFilteredTimestamp(record.FilteredTimestamp);
+    item->SetUnfilteredTimestamp(record.UnfilteredTimestamp);
+    item->SetIndex(record.Index);
+    item->SetUid(record.Uid);
+    if (record.ValidTransformData)
+    {
+      item->SetMatrixInternal(record.Matrix, record.Rotation, record.Translation, record.Scale);
+    }
+    item->SetStatus(record.Status);
+
+    if (record.FrameSizeBytes > 0)
+    {
+      std::shared_ptr<byte> view = GetSegmentView(record.Segment);
+      if (view == nullptr)
+      {
+        return nullptr;
+      }
+
+      // Alias the mapped view, the item keeps the segment mapped as long as it references the frame
+      std::shared_ptr<byte> frameData(view, view.get() + record.Offset);
+      item->GetFrame()->SetImageData(frameData, record.NumberOfScalarComponents, record.ScalarType, record.Dimensions);
+      item->GetFrame()->SetImageType(record.ImageType);
+      item->GetFrame()->SetImageOrientation(record.ImageOrientation);
+    }
+
+    return item;
+  }
+}
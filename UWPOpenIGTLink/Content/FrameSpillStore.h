@@ -0,0 +1,122 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+#include "StreamBufferItem.h"
+
+// STL includes
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  /// Everything but the frame pixels of a spilled item, kept in memory for the whole recording
+  struct SpilledItemRecord
+  {
+    float                                     FilteredTimestamp = 0.f;
+    float                                     UnfilteredTimestamp = 0.f;
+    uint32                                    Index = 0;
+    BufferItemUidType                         Uid = 0;
+    int                                       Status = TOOL_MISSING;
+    bool                                      ValidTransformData = false;
+    Windows::Foundation::Numerics::float4x4   Matrix = Windows::Foundation::Numerics::float4x4::identity();
+    Windows::Foundation::Numerics::quaternion Rotation = Windows::Foundation::Numerics::quaternion::identity();
+    Windows::Foundation::Numerics::float3     Translation = Windows::Foundation::Numerics::float3::zero();
+    Windows::Foundation::Numerics::float3     Scale = Windows::Foundation::Numerics::float3::one();
+
+    // Location and format of the frame in the segment files, FrameSizeBytes is 0 if the item has no frame
+    uint32                                    Segment = 0;
+    uint64                                    Offset = 0;
+    uint64                                    FrameSizeBytes = 0;
+    FrameSize                                 Dimensions = { 0, 0, 0 };
+    IGTL_SCALAR_TYPE                          ScalarType = IGTL_SCALARTYPE_UINT8;
+    uint16                                    NumberOfScalarComponents = 0;
+    US_IMAGE_TYPE                             ImageType = US_IMG_BRIGHTNESS;
+    US_IMAGE_ORIENTATION                      ImageOrientation = US_IMG_ORIENT_MF;
+  };
+
+  /*
+  Append-only store of buffer items for recordings that are longer than the buffer.
+  Frames are copied into fixed size segment files (segment_<generation>_<n>.bin in the given directory) through a memory mapped view.
+  Every Open and Clear starts a new generation of files, files of an earlier generation may still be mapped by items handed out.
+  Only the segment being written and the most recently read segments are mapped, the rest of the recording stays on disk.
+  The timestamps, poses and frame locations of all items are kept in memory, so temporal lookups never touch the disk.
+  Items read back reference the mapped frame without a copy, their frame data must be treated as read only.
+  Custom frame fields are not stored. Not thread safe, the owning Buffer serializes the calls.
+  */
+  class FrameSpillStore
+  {
+  public:
+    FrameSpillStore();
+    ~FrameSpillStore();
+
+    /// Create the first segment of a new generation in an existing directory the application can write to (e.g. the local folder)
+    bool Open(const std::wstring& directory, uint64 segmentSizeBytes);
+    /// Unmap and close all segments, the segment files are left on disk
+    void Close();
+    bool IsOpen() const;
+    /// Remove all items and start a new generation of segment files, the files of the old one are deleted unless an item still maps them
+    bool Clear();
+
+    /// Copy the item to the end of the store, its timestamp must be newer than the last one
+    bool Append(StreamBufferItem^ item);
+
+    uint64 GetNumberOfItems() const;
+    /// Find the item with the filtered timestamp (local time) closest to the requested time
+    bool FindClosestItem(float localTime, uint64& outItemIndex) const;
+    const SpilledItemRecord& GetRecord(uint64 itemIndex) const;
+    /// Recreate an item, mapping the segment of its frame if needed. Returns nullptr on failure.
+    StreamBufferItem^ GetItem(uint64 itemIndex);
+
+  protected:
+    struct Segment
+    {
+      HANDLE              File = INVALID_HANDLE_VALUE;
+      HANDLE              Mapping = nullptr;
+      std::weak_ptr<byte> View;
+    };
+
+    bool StartSegment();
+    std::wstring GetSegmentFileName(uint32 generation, uint32 segmentIndex) const;
+    std::shared_ptr<byte> MapSegment(uint32 segmentIndex, bool writable);
+    std::shared_ptr<byte> GetSegmentView(uint32 segmentIndex);
+
+  protected:
+    std::wstring                        m_directory;
+    uint32                              m_generation;
+    uint64                              m_segmentSizeBytes;
+    std::vector<Segment>                m_segments;
+    std::shared_ptr<byte>               m_writeView;      // view of the last segment, frames are appended at m_writeOffset
+    uint64                              m_writeOffset;
+    std::deque<std::shared_ptr<byte>>   m_residentViews;  // most recently read segments, front is the most recent
+    std::vector<float>                  m_timestamps;     // filtered timestamps of m_records, contiguous for the search
+    std::vector<SpilledItemRecord>      m_records;
+  };
+}
@@ -26,6 +26,8 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 // Local includes
 #include "pch.h"
+#include "ByteSwap.h"
+#include "Crc64.h"
 #include "IGTClient.h"
 #include "IGTCommon.h"
 #include "TrackedFrameMessage.h"
@@ -38,6 +40,7 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include <igtlOSUtil.h>
 #include <igtlPolyDataMessage.h>
 #include <igtlStatusMessage.h>
+#include <igtl_header.h>
 
 // STL includes
 #include <chrono>
@@ -66,8 +69,14 @@ namespace UWPOpenIGTLink
   namespace
   {
     static const double NEGLIGIBLE_DIFFERENCE = 0.0001;
+    // Device name of the GET_STATUS clock probes, the server answers with a STATUS message of the same name
+    static const char* CLOCK_PROBE_DEVICE_NAME = "ClockProbe";
   }
   const int IGTClient::CLIENT_SOCKET_TIMEOUT_MSEC = 500;
+  const int IGTClient::CLOCK_PROBE_INTERVAL_MSEC = 1000;
+  const double IGTClient::CLOCK_PROBE_TIMEOUT_SEC = 1.0;
+  const uint64 IGTClient::MAXIMUM_PLAUSIBLE_BODY_SIZE = 512 * 1024 * 1024;
+  const uint32 IGTClient::RECEIVE_CHUNK_SIZE = 1024 * 1024;
   // TODO tune
   const BufferItemList::size_type IGTClient::MESSAGE_LIST_IMAGE_MAX_SIZE = 200;
   const BufferItemList::size_type IGTClient::MESSAGE_LIST_TRACKEDFRAME_MAX_SIZE = 200;
@@ -81,6 +90,10 @@ namespace UWPOpenIGTLink
   {
     m_igtlMessageFactory->AddMessageType("TRACKEDFRAME", (igtl::MessageFactory::PointerToMessageBaseNew)&igtl::TrackedFrameMessage::New);
 
+    std::vector<std::string> messageTypes;
+    m_igtlMessageFactory->GetAvailableMessageTypes(messageTypes);
+    m_knownMessageTypes.insert(begin(messageTypes), end(messageTypes));
+
     m_clientSocket->Control->KeepAlive = true;
     m_clientSocket->Control->NoDelay = false; // true => accumulate data until enough has been queued to occupy a full TCP/IP packet
     m_sendStream = ref new DataWriter(m_clientSocket->OutputStream);
@@ -133,7 +146,9 @@ namespace UWPOpenIGTLink
           {
             previousTask.wait();
 
-            std::lock_guard<std::mutex> guard(m_socketMutex);
+            std::lock(m_socketMutex, m_sendMutex);
+            std::lock_guard<std::mutex> readGuard(m_socketMutex, std::adopt_lock);
+            std::lock_guard<std::mutex> sendGuard(m_sendMutex, std::adopt_lock);
             m_sendStream = nullptr;
             m_readStream = nullptr;
             delete m_clientSocket;
@@ -154,6 +169,18 @@ namespace UWPOpenIGTLink
           }
         });
 
+        // Clock probes are sent from their own thread, the receiver pump handles the replies
+        {
+          std::lock_guard<std::mutex> guard(m_ingestMutex);
+          m_clockOffsetEstimator.Clear();
+          m_clockProbeSendTime = UNDEFINED_TIMESTAMP;
+        }
+        m_clockProbeTokenSource = cancellation_token_source();
+        create_task([this]()
+        {
+          ClockProbePump();
+        });
+
         return true;
       });
     });
@@ -164,6 +191,7 @@ namespace UWPOpenIGTLink
   {
     m_clientSocket->CancelIOAsync();
     m_receiverPumpTokenSource.cancel();
+    m_clockProbeTokenSource.cancel();
   }
 
   //----------------------------------------------------------------------------
@@ -249,7 +277,18 @@ namespace UWPOpenIGTLink
     frameSizeUint[1] = static_cast<uint16>(frameSize[1]);
     frameSizeUint[2] = static_cast<uint16>(frameSize[2]);
     std::shared_ptr<byte> imgData = std::shared_ptr<byte>(new byte[imgMsg->GetImageSize()], [](byte * p) {delete[] p; });
-    memcpy((void*)imgData.get(), imgMsg->GetScalarPointer(), imgMsg->GetImageSize());
+
+    // Scalars are sent in the byte order of the sender, convert while copying if it differs from ours
+    const bool senderIsBigEndian = imgMsg->GetEndian() == igtl::ImageMessage::ENDIAN_BIG;
+    const bool receiverIsBigEndian = igtl_is_little_endian() == 0;
+    if (senderIsBigEndian != receiverIsBigEndian && imgMsg->GetScalarSize() > 1)
+    {
+      CopyAndSwapScalars(imgData.get(), imgMsg->GetScalarPointer(), imgMsg->GetImageSize() / imgMsg->GetScalarSize(), imgMsg->GetScalarSize());
+    }
+    else
+    {
+      memcpy((void*)imgData.get(), imgMsg->GetScalarPointer(), imgMsg->GetImageSize());
+    }
 
     frame->SetImageData(imgData, static_cast<uint16>(imgMsg->GetNumComponents()), (IGTL_SCALAR_TYPE)imgMsg->GetScalarType(), frameSizeUint);
     //frame->Type = US_IMG_BRIGHTNESS; // Not perfect, but this data isn't transmitted with an image message, could check metadata?
@@ -738,7 +777,7 @@ namespace UWPOpenIGTLink
       return task_from_result(false);
     }
 
-    std::lock_guard<std::mutex> guard(m_socketMutex);
+    std::lock_guard<std::mutex> guard(m_sendMutex);
     m_sendStream->WriteBytes(Platform::ArrayReference<byte>((byte*)packedMessage->GetBufferPointer(), packedMessage->GetBufferSize()));
     return create_task(m_sendStream->StoreAsync()).then([size = packedMessage->GetBufferSize()](task<uint32> writeTask)
     {
@@ -761,7 +800,7 @@ namespace UWPOpenIGTLink
     // Keep track of requested message
     packedMessage->SetCommandId(m_nextQueryId);
 
-    std::lock_guard<std::mutex> guard(m_socketMutex);
+    std::lock_guard<std::mutex> guard(m_sendMutex);
     m_sendStream->WriteBytes(Platform::ArrayReference<byte>((byte*)packedMessage->GetBufferPointer(), packedMessage->GetBufferSize()));
     return create_task(m_sendStream->StoreAsync()).then([this, size = packedMessage->GetBufferSize()](task<uint32> writeTask)
     {
@@ -852,6 +891,81 @@ namespace UWPOpenIGTLink
     return std::find(begin(m_outstandingQueries), end(m_outstandingQueries), commandId) == end(m_outstandingQueries);
   }
 
+  //----------------------------------------------------------------------------
+  void IGTClient::SetImageIngestBuffer(Buffer^ buffer)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    m_imageIngestTarget.TargetBuffer = buffer;
+    UpdateIngestTimeOffsets();
+  }
+
+  //----------------------------------------------------------------------------
+  Buffer^ IGTClient::GetImageIngestBuffer()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_imageIngestTarget.TargetBuffer;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::SetTrackedFrameIngestBuffer(Buffer^ buffer)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    m_trackedFrameIngestTarget.TargetBuffer = buffer;
+    UpdateIngestTimeOffsets();
+  }
+
+  //----------------------------------------------------------------------------
+  Buffer^ IGTClient::GetTrackedFrameIngestBuffer()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_trackedFrameIngestTarget.TargetBuffer;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::SetToolIngestBuffer(TransformName^ name, Buffer^ buffer)
+  {
+    if (name == nullptr)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Null transform name sent to SetToolIngestBuffer.");
+    }
+
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    if (buffer == nullptr)
+    {
+      m_toolIngestTargets.erase(name->GetTransformNameInternal());
+      return;
+    }
+    m_toolIngestTargets[name->GetTransformNameInternal()].TargetBuffer = buffer;
+    UpdateIngestTimeOffsets();
+  }
+
+  //----------------------------------------------------------------------------
+  Buffer^ IGTClient::GetToolIngestBuffer(TransformName^ name)
+  {
+    if (name == nullptr)
+    {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    auto iter = m_toolIngestTargets.find(name->GetTransformNameInternal());
+    return iter == m_toolIngestTargets.end() ? nullptr : iter->second.TargetBuffer;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::SetTrackedFrameJoiner(TrackedFrameJoiner^ joiner)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    m_trackedFrameJoiner = joiner;
+  }
+
+  //----------------------------------------------------------------------------
+  TrackedFrameJoiner^ IGTClient::GetTrackedFrameJoiner()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_trackedFrameJoiner;
+  }
+
   //----------------------------------------------------------------------------
   void IGTClient::DataReceiverPump()
   {
@@ -860,61 +974,95 @@ namespace UWPOpenIGTLink
     auto headerMsg = m_igtlMessageFactory->CreateHeaderMessage(IGTL_HEADER_VERSION_1);
     auto token = m_receiverPumpTokenSource.get_token();
 
-    while (!token.is_canceled())
     {
-      headerMsg->InitBuffer();
+      std::lock_guard<std::mutex> guard(m_socketMutex);
+      m_pendingReceiveBytes.clear();
+    }
+
+    // Raw (network byte order) copy of the current header, used as the starting point of a resynchronization
+    byte rawHeader[IGTL_HEADER_SIZE];
+    bool headerPending(false);
 
-      // Receive generic header from the socket
-      int numOfBytesReceived = 0;
+    while (!token.is_canceled())
+    {
+      if (!headerPending)
       {
-        numOfBytesReceived = SocketReceive(headerMsg->GetBufferPointer(), headerMsg->GetBufferSize());
-        if (numOfBytesReceived == 0)
+        headerMsg->InitBuffer();
+
+        // Receive generic header from the socket
+        int numOfBytesReceived = 0;
         {
-          // Graceful disconnect, other end closes the connection
-          break;
+          numOfBytesReceived = SocketReceive(headerMsg->GetBufferPointer(), headerMsg->GetBufferSize());
+          if (numOfBytesReceived == 0)
+          {
+            // Graceful disconnect, other end closes the connection
+            break;
+          }
+          if (numOfBytesReceived != headerMsg->GetBufferSize())
+          {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+          }
         }
-        if (numOfBytesReceived != headerMsg->GetBufferSize())
+        memcpy(rawHeader, headerMsg->GetBufferPointer(), IGTL_HEADER_SIZE);
+
+        // Only a header that cannot be unpacked means the stream lost its framing, the plausibility heuristics are for the resynchronization scan
+        int c = headerMsg->Unpack(1);
+        if (!(c & igtl::MessageHeader::UNPACK_HEADER))
         {
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
-          continue;
+          ErrorMessage(this, L"Failed to receive message (invalid header). Resynchronizing.");
+          if (!ResynchronizeHeader(headerMsg, rawHeader, token))
+          {
+            break;
+          }
         }
       }
+      headerPending = false;
 
-      int c = headerMsg->Unpack(1);
-      if (!(c & igtl::MessageHeader::UNPACK_HEADER))
-      {
-        ErrorMessage(this, L"Failed to receive message (invalid header).");
-        continue;
-      }
+      // The header bytes are the first of the message to arrive
+      const double receiveTime = m_lastReceiveTime;
 
+      // Header has been converted to host byte order by Unpack
+      const uint64 bodyCrc = reinterpret_cast<igtl_header*>(headerMsg->GetBufferPointer())->crc;
+
+      // Message types the factory does not know are valid messages all the same, their body is skipped below
       igtl::MessageBase::Pointer bodyMsg = nullptr;
-      try
-      {
-        bodyMsg = m_igtlMessageFactory->CreateReceiveMessage(headerMsg);
-      }
-      catch (const std::exception&)
+      if (m_knownMessageTypes.find(headerMsg->GetMessageType()) != m_knownMessageTypes.end())
       {
-        // Message header was not correct, skip this message
-        // Will be impossible to tell if the body of this message is in the socket... this is a pretty bad corruption.
-        // Force re-connect?
-        ErrorMessage(this, L"Corruption in the message header. Serious error.");
-        continue;
+        try
+        {
+          bodyMsg = m_igtlMessageFactory->CreateReceiveMessage(headerMsg);
+        }
+        catch (const std::exception&)
+        {
+          // Message header was not correct, it is impossible to tell where the body of this message ends
+          // Search the stream for the next plausible header instead of reconnecting
+          ErrorMessage(this, L"Corruption in the message header. Resynchronizing.");
+          if (!ResynchronizeHeader(headerMsg, rawHeader, token))
+          {
+            break;
+          }
+          headerPending = true;
+          continue;
+        }
       }
 
       if (bodyMsg.IsNull())
       {
         std::string msgType = headerMsg->GetMessageType();
         ErrorMessage(this, L"Unable to create message of type: " + ref new Platform::String(std::wstring(begin(msgType), end(msgType)).c_str()));
+        // Skip the body so the next header is read from the right position
+        if (!SkipBody(headerMsg->GetBodySizeToRead()))
+        {
+          break;
+        }
         continue;
       }
 
       // Accept all messages but status messages, they are used as a keep alive mechanism
       if (typeid(*bodyMsg) == typeid(igtl::TrackedFrameMessage))
       {
-        SocketReceive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
-
-        c = bodyMsg->Unpack(1);
-        if (!(c & igtl::MessageHeader::UNPACK_BODY))
+        if (!ReceiveBody(bodyMsg, bodyCrc))
         {
           ErrorMessage(this, L"Failed to receive reply (invalid body)");
           continue;
@@ -925,6 +1073,8 @@ namespace UWPOpenIGTLink
         // Post process tracked frame to adjust for unit scale
         trackedFrameMessage->ApplyTransformUnitScaling(m_trackerUnitScale);
 
+        IngestTrackedFrameMessage(bodyMsg, receiveTime);
+
         // Save reply
         std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
         m_receivedTrackedFrameMessages.push_back(bodyMsg);
@@ -935,10 +1085,7 @@ namespace UWPOpenIGTLink
         {
           continue;
         }
-        SocketReceive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
-
-        c = bodyMsg->Unpack(1);
-        if (!(c & igtl::MessageHeader::UNPACK_BODY))
+        if (!ReceiveBody(bodyMsg, bodyCrc))
         {
           ErrorMessage(this, L"Failed to receive reply (invalid body)");
           continue;
@@ -959,16 +1106,15 @@ namespace UWPOpenIGTLink
           element->SetMatrix(mat);
         }
 
+        IngestTDataMessage(bodyMsg, receiveTime);
+
         // Save reply
         std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
         m_receivedTDataMessages.push_back(bodyMsg);
       }
       else if (typeid(*bodyMsg) == typeid(igtl::TransformMessage))
       {
-        SocketReceive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
-
-        c = bodyMsg->Unpack(1);
-        if (!(c & igtl::MessageHeader::UNPACK_BODY))
+        if (!ReceiveBody(bodyMsg, bodyCrc))
         {
           ErrorMessage(this, L"Failed to receive reply (invalid body)");
           continue;
@@ -982,6 +1128,8 @@ namespace UWPOpenIGTLink
         mat[2][3] = mat[2][3] * m_trackerUnitScale;
         transformMessage->SetMatrix(mat);
 
+        IngestTransformMessage(bodyMsg, receiveTime);
+
         // Save reply
         std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
         m_receivedTransformMessages.push_back(bodyMsg);
@@ -989,10 +1137,7 @@ namespace UWPOpenIGTLink
       else if (typeid(*bodyMsg) == typeid(igtl::PolyDataMessage))
       {
         // We got ourselves a live one! 3D model sent over the network
-        SocketReceive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
-
-        c = bodyMsg->Unpack(1);
-        if (!(c & igtl::MessageHeader::UNPACK_BODY))
+        if (!ReceiveBody(bodyMsg, bodyCrc))
         {
           ErrorMessage(this, L"Failed to receive reply (invalid body)");
           continue;
@@ -1004,10 +1149,7 @@ namespace UWPOpenIGTLink
       }
       else if (typeid(*bodyMsg) == typeid(igtl::RTSCommandMessage))
       {
-        SocketReceive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
-
-        c = bodyMsg->Unpack(1);
-        if (!(c & igtl::MessageHeader::UNPACK_BODY))
+        if (!ReceiveBody(bodyMsg, bodyCrc))
         {
           ErrorMessage(this, L"Failed to receive reply (invalid body)");
           continue;
@@ -1034,10 +1176,7 @@ namespace UWPOpenIGTLink
       }
       else if (typeid(*bodyMsg) == typeid(igtl::ImageMessage))
       {
-        SocketReceive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
-
-        c = bodyMsg->Unpack(1);
-        if (!(c & igtl::MessageHeader::UNPACK_BODY))
+        if (!ReceiveBody(bodyMsg, bodyCrc))
         {
           ErrorMessage(this, L"Failed to receive reply (invalid body)");
           continue;
@@ -1045,16 +1184,43 @@ namespace UWPOpenIGTLink
 
         auto imgMsg = (igtl::ImageMessage*)bodyMsg.GetPointer();
 
+        IngestImageMessage(bodyMsg, receiveTime);
+
         // Save reply
         std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
         m_receivedImageMessages.push_back(bodyMsg);
       }
+      else if (typeid(*bodyMsg) == typeid(igtl::StatusMessage))
+      {
+        if (!ReceiveBody(bodyMsg, bodyCrc))
+        {
+          ErrorMessage(this, L"Failed to receive reply (invalid body)");
+          continue;
+        }
+
+        // Status messages are a keep alive mechanism, or the reply to a clock probe
+        AddClockProbeReply(bodyMsg, receiveTime);
+      }
       else
       {
         // if the incoming message is not a reply to a command, we discard it and continue
         std::string msgType = bodyMsg->GetMessageType();
         ErrorMessage(this, L"Received message: " + ref new Platform::String(std::wstring(begin(msgType), end(msgType)).c_str()) + L" (not processed)");
-        SocketReceive(nullptr, bodyMsg->GetBodySizeToRead());
+        if (!SkipBody(bodyMsg->GetBodySizeToRead()))
+        {
+          break;
+        }
+      }
+
+      // Join the images with their poses as soon as the message completed them, not under the ingest lock as it raises events
+      TrackedFrameJoiner^ joiner(nullptr);
+      {
+        std::lock_guard<std::mutex> guard(m_ingestMutex);
+        joiner = m_trackedFrameJoiner;
+      }
+      if (joiner != nullptr)
+      {
+        joiner->Process();
       }
 
       PruneIGTMessages();
@@ -1063,6 +1229,20 @@ namespace UWPOpenIGTLink
     return;
   }
 
+  //----------------------------------------------------------------------------
+  void IGTClient::ClockProbePump()
+  {
+    auto token = m_clockProbeTokenSource.get_token();
+    while (!token.is_canceled() && m_connected)
+    {
+      if (m_clockSynchronization)
+      {
+        SendClockProbe();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(CLOCK_PROBE_INTERVAL_MSEC));
+    }
+  }
+
   //----------------------------------------------------------------------------
   void IGTClient::PruneIGTMessages()
   {
@@ -1306,14 +1486,36 @@ namespace UWPOpenIGTLink
   int32 IGTClient::SocketReceive(void* dest, int size)
   {
     std::lock_guard<std::mutex> guard(m_socketMutex);
+
+    // Consume any bytes that were read ahead while resynchronizing first
+    int pendingBytes = static_cast<int>((std::min)(m_pendingReceiveBytes.size(), static_cast<size_t>(size)));
+    if (pendingBytes > 0)
+    {
+      if (dest != nullptr)
+      {
+        memcpy(dest, m_pendingReceiveBytes.data(), pendingBytes);
+        dest = static_cast<byte*>(dest) + pendingBytes;
+      }
+      m_pendingReceiveBytes.erase(m_pendingReceiveBytes.begin(), m_pendingReceiveBytes.begin() + pendingBytes);
+      size -= pendingBytes;
+
+      // Read-ahead bytes arrived with the read that loaded them, not with the previous one
+      m_lastReceiveTime = m_pendingReceiveTime;
+      if (size == 0)
+      {
+        return pendingBytes;
+      }
+    }
+
     auto loadTask = create_task(m_readStream->LoadAsync(size));
     int bytesLoaded(-1);
     try
     {
       bytesLoaded = loadTask.get();
+      m_lastReceiveTime = GetMonotonicTimeSec();
       if (bytesLoaded != size)
       {
-        return bytesLoaded;
+        return pendingBytes + bytesLoaded;
       }
 
       auto buffer = m_readStream->ReadBuffer(size);
@@ -1328,7 +1530,561 @@ namespace UWPOpenIGTLink
       return -1;
     }
 
-    return bytesLoaded;
+    return pendingBytes + bytesLoaded;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::SkipBody(uint64 bodySize)
+  {
+    while (bodySize > 0)
+    {
+      const int chunkSize = static_cast<int>((std::min)(bodySize, static_cast<uint64>(RECEIVE_CHUNK_SIZE)));
+      if (SocketReceive(nullptr, chunkSize) != chunkSize)
+      {
+        // Connection closed or lost
+        return false;
+      }
+      bodySize -= chunkSize;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::IsPlausibleHeader(const byte* data) const
+  {
+    const igtl_header* header = reinterpret_cast<const igtl_header*>(data);
+
+    // Version, big endian, must be a header version this library can read
+    uint16 version = static_cast<uint16>((data[0] << 8) | data[1]);
+    if (version < IGTL_HEADER_VERSION_1 || version > IGTL_HEADER_VERSION_2)
+    {
+      return false;
+    }
+
+    // Message type: upper case alphanumeric name padded with zeros, and known to the factory
+    std::string messageType(header->name, strnlen(header->name, IGTL_HEADER_TYPE_SIZE));
+    if (messageType.empty())
+    {
+      return false;
+    }
+    for (size_t i = messageType.length(); i < IGTL_HEADER_TYPE_SIZE; ++i)
+    {
+      if (header->name[i] != 0)
+      {
+        return false;
+      }
+    }
+    if (m_knownMessageTypes.find(messageType) == m_knownMessageTypes.end())
+    {
+      return false;
+    }
+
+    // Device name: printable characters padded with zeros
+    size_t deviceNameLength = strnlen(header->device_name, IGTL_HEADER_NAME_SIZE);
+    for (size_t i = 0; i < IGTL_HEADER_NAME_SIZE; ++i)
+    {
+      const char ch = header->device_name[i];
+      if ((i < deviceNameLength && (ch < 0x20 || ch > 0x7E)) || (i >= deviceNameLength && ch != 0))
+      {
+        return false;
+      }
+    }
+
+    // Body size, big endian
+    uint64 bodySize(0);
+    for (int i = 0; i < 8; ++i)
+    {
+      bodySize = (bodySize << 8) | data[offsetof(igtl_header, body_size) + i];
+    }
+    return bodySize <= MAXIMUM_PLAUSIBLE_BODY_SIZE;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::ResynchronizeHeader(igtl::MessageHeader::Pointer headerMsg, byte* rawHeader, const cancellation_token& token)
+  {
+    m_resynchronizationCount++;
+
+    // The header buffer has been byte swapped by Unpack, start the scan from the raw bytes
+    headerMsg->InitBuffer();
+    std::vector<byte> window(rawHeader, rawHeader + IGTL_HEADER_SIZE);
+    window.reserve(3 * IGTL_HEADER_SIZE);
+    {
+      std::lock_guard<std::mutex> guard(m_socketMutex);
+      window.insert(window.end(), m_pendingReceiveBytes.begin(), m_pendingReceiveBytes.end());
+      m_pendingReceiveBytes.clear();
+    }
+
+    // Candidate headers can start anywhere after the first byte of the rejected header
+    size_t searchStart = 1;
+    std::vector<byte> chunk(IGTL_HEADER_SIZE);
+    while (!token.is_canceled())
+    {
+      while (window.size() < searchStart + IGTL_HEADER_SIZE)
+      {
+        if (SocketReceive(chunk.data(), IGTL_HEADER_SIZE) != IGTL_HEADER_SIZE)
+        {
+          // Connection closed or lost
+          return false;
+        }
+        window.insert(window.end(), chunk.begin(), chunk.end());
+      }
+
+      // A header starts with a big endian version (high byte zero) followed by an upper case type name
+      const byte* begin = window.data() + searchStart;
+      const byte* end = window.data() + window.size() - IGTL_HEADER_SIZE + 1;
+      const byte* candidate = begin;
+      while (candidate < end)
+      {
+        candidate = static_cast<const byte*>(memchr(candidate, 0, end - candidate));
+        if (candidate == nullptr)
+        {
+          break;
+        }
+        if (candidate[1] >= IGTL_HEADER_VERSION_1 && candidate[1] <= IGTL_HEADER_VERSION_2 &&
+            candidate[2] >= 'A' && candidate[2] <= 'Z' && IsPlausibleHeader(candidate))
+        {
+          break;
+        }
+        ++candidate;
+      }
+
+      if (candidate != nullptr && candidate < end)
+      {
+        size_t offset = candidate - window.data();
+        memcpy(rawHeader, candidate, IGTL_HEADER_SIZE);
+        memcpy(headerMsg->GetBufferPointer(), candidate, IGTL_HEADER_SIZE);
+        {
+          std::lock_guard<std::mutex> guard(m_socketMutex);
+          m_pendingReceiveBytes.insert(m_pendingReceiveBytes.begin(), window.begin() + offset + IGTL_HEADER_SIZE, window.end());
+          m_pendingReceiveTime = m_lastReceiveTime;
+        }
+        if (headerMsg->Unpack(1) & igtl::MessageHeader::UNPACK_HEADER)
+        {
+          return true;
+        }
+
+        // Unpack rejected it after all, take the bytes back and keep looking
+        {
+          std::lock_guard<std::mutex> guard(m_socketMutex);
+          m_pendingReceiveBytes.clear();
+        }
+        headerMsg->InitBuffer();
+        searchStart = offset + 1;
+        continue;
+      }
+
+      // Nothing found, keep the tail that could still hold the beginning of a header
+      size_t keep = IGTL_HEADER_SIZE - 1;
+      window.erase(window.begin(), window.end() - keep);
+      searchStart = 0;
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::ReceiveBody(igtl::MessageBase::Pointer bodyMsg, uint64 expectedCrc)
+  {
+    byte* body = static_cast<byte*>(bodyMsg->GetBufferBodyPointer());
+    const uint64 bodySize = bodyMsg->GetBufferBodySize();
+    const bool verifyCrc = !m_trustedLink;
+    const bool reportProgress = bodySize > RECEIVE_CHUNK_SIZE;
+    std::string messageType = bodyMsg->GetMessageType();
+    Platform::String^ messageTypeString = ref new Platform::String(std::wstring(begin(messageType), end(messageType)).c_str());
+
+    uint64 received(0);
+    uint64 crc(0);
+    uint32 chunkSize(0);
+    task<uint32> loadTask;
+    {
+      std::lock_guard<std::mutex> guard(m_socketMutex);
+
+      // Bytes read ahead during resynchronization belong to this body
+      received = (std::min)(static_cast<uint64>(m_pendingReceiveBytes.size()), bodySize);
+      if (received > 0)
+      {
+        memcpy(body, m_pendingReceiveBytes.data(), static_cast<size_t>(received));
+        m_pendingReceiveBytes.erase(m_pendingReceiveBytes.begin(), m_pendingReceiveBytes.begin() + static_cast<size_t>(received));
+      }
+
+      if (received < bodySize)
+      {
+        chunkSize = static_cast<uint32>((std::min)(static_cast<uint64>(RECEIVE_CHUNK_SIZE), bodySize - received));
+        loadTask = create_task(m_readStream->LoadAsync(chunkSize));
+      }
+    }
+
+    uint64 verified(0);
+    while (received < bodySize)
+    {
+      {
+        // Guards the read stream only, sends lock m_sendMutex and are not held back by a large body arriving
+        std::lock_guard<std::mutex> guard(m_socketMutex);
+        try
+        {
+          if (loadTask.get() != chunkSize)
+          {
+            return false;
+          }
+          auto buffer = m_readStream->ReadBuffer(chunkSize);
+          memcpy(body + received, GetDataFromIBuffer<byte>(buffer), chunkSize);
+        }
+        catch (...)
+        {
+          return false;
+        }
+        received += chunkSize;
+
+        // Queue the next chunk before checksumming this one so the two overlap
+        if (received < bodySize)
+        {
+          chunkSize = static_cast<uint32>((std::min)(static_cast<uint64>(RECEIVE_CHUNK_SIZE), bodySize - received));
+          loadTask = create_task(m_readStream->LoadAsync(chunkSize));
+        }
+      }
+
+      if (verifyCrc)
+      {
+        crc = Crc64(body + verified, received - verified, crc);
+        verified = received;
+      }
+
+      if (reportProgress)
+      {
+        ReceiveProgress(this, messageTypeString, received, bodySize);
+      }
+    }
+
+    if (verifyCrc)
+    {
+      crc = Crc64(body + verified, received - verified, crc);
+      if (crc != expectedCrc)
+      {
+        return false;
+      }
+    }
+
+    // CRC has already been verified (or is intentionally skipped), don't let igtl compute it again
+    int c = bodyMsg->Unpack(0);
+    return (c & igtl::MessageHeader::UNPACK_BODY) != 0;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::IngestImageMessage(igtl::MessageBase::Pointer message, double receiveTime)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    if (m_imageIngestTarget.TargetBuffer == nullptr)
+    {
+      return;
+    }
+
+    auto imgMsg = dynamic_cast<igtl::ImageMessage*>(message.GetPointer());
+    auto ts = igtl::TimeStamp::New();
+    imgMsg->GetTimeStamp(ts);
+
+    int size[3];
+    imgMsg->GetDimensions(size);
+    FrameSize frameSize = { static_cast<uint16>(size[0]), static_cast<uint16>(size[1]), static_cast<uint16>(size[2]) };
+
+    // Share the scalars of the message (the image keeps the message alive), only a byte order conversion needs a copy
+    std::shared_ptr<byte> imageData(nullptr);
+    const bool senderIsBigEndian = imgMsg->GetEndian() == igtl::ImageMessage::ENDIAN_BIG;
+    const bool receiverIsBigEndian = igtl_is_little_endian() == 0;
+    if (senderIsBigEndian != receiverIsBigEndian && imgMsg->GetScalarSize() > 1)
+    {
+      imageData = std::shared_ptr<byte>(new byte[imgMsg->GetImageSize()], [](byte * p) {delete[] p; });
+      CopyAndSwapScalars(imageData.get(), imgMsg->GetScalarPointer(), imgMsg->GetImageSize() / imgMsg->GetScalarSize(), imgMsg->GetScalarSize());
+    }
+    else
+    {
+      imageData = std::shared_ptr<byte>(static_cast<byte*>(imgMsg->GetScalarPointer()), [message](byte*) {});
+    }
+
+    auto image = ref new Image();
+    image->SetImageData(imageData, static_cast<uint16>(imgMsg->GetNumComponents()), (IGTL_SCALAR_TYPE)imgMsg->GetScalarType(), frameSize);
+
+    // Same image type and orientation as GetImage, they aren't transmitted with an image message
+    if (!PrepareIngestFrameFormat(m_imageIngestTarget.TargetBuffer, image, US_IMG_BRIGHTNESS, US_IMG_ORIENT_MF))
+    {
+      return;
+    }
+    float unfilteredTimestamp(0.f);
+    float filteredTimestamp(0.f);
+    GetIngestTimestamps(ts->GetTimeStamp(), receiveTime, unfilteredTimestamp, filteredTimestamp);
+    m_imageIngestTarget.TargetBuffer->AddItem(image, US_IMG_ORIENT_MF, US_IMG_BRIGHTNESS, m_imageIngestTarget.FrameNumber++, nullptr, nullptr, nullptr, unfilteredTimestamp, filteredTimestamp);
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::IngestTrackedFrameMessage(igtl::MessageBase::Pointer message, double receiveTime)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    if (m_trackedFrameIngestTarget.TargetBuffer == nullptr && m_toolIngestTargets.empty())
+    {
+      return;
+    }
+
+    auto trackedFrameMsg = dynamic_cast<igtl::TrackedFrameMessage*>(message.GetPointer());
+    float unfilteredTimestamp(0.f);
+    float filteredTimestamp(0.f);
+    GetIngestTimestamps(trackedFrameMsg->GetTimestamp(), receiveTime, unfilteredTimestamp, filteredTimestamp);
+
+    if (m_trackedFrameIngestTarget.TargetBuffer != nullptr && trackedFrameMsg->GetImage() != nullptr)
+    {
+      auto fields = ref new Map<Platform::String^, Platform::String^>();
+      for (auto& pair : trackedFrameMsg->GetMetaData())
+      {
+        std::wstring keyWideStr(pair.first.begin(), pair.first.end());
+        std::wstring valueWideStr(pair.second.second.begin(), pair.second.second.end());
+        fields->Insert(ref new Platform::String(keyWideStr.c_str()), ref new Platform::String(valueWideStr.c_str()));
+      }
+
+      // The image of the message is already reference counted, the buffer shares it
+      FrameSize frameSize = { trackedFrameMsg->GetFrameSize()[0], trackedFrameMsg->GetFrameSize()[1], trackedFrameMsg->GetFrameSize()[2] };
+      auto image = ref new Image();
+      image->SetImageData(trackedFrameMsg->GetImage(), trackedFrameMsg->GetNumberOfComponents(), trackedFrameMsg->GetScalarType(), frameSize);
+
+      if (PrepareIngestFrameFormat(m_trackedFrameIngestTarget.TargetBuffer, image, trackedFrameMsg->GetImageType(), trackedFrameMsg->GetImageOrientation()))
+      {
+        m_trackedFrameIngestTarget.TargetBuffer->AddItem(image, trackedFrameMsg->GetImageOrientation(), trackedFrameMsg->GetImageType(), m_trackedFrameIngestTarget.FrameNumber++,
+            nullptr, nullptr, fields, unfilteredTimestamp, filteredTimestamp);
+      }
+    }
+
+    for (auto& transform : trackedFrameMsg->GetFrameTransforms())
+    {
+      IngestPose(transform->Name->GetTransformNameInternal(), transform->Matrix, transform->Valid, unfilteredTimestamp, filteredTimestamp);
+    }
+    if (m_embeddedImageTransformName != nullptr)
+    {
+      float4x4 embeddedImageTransform = trackedFrameMsg->GetEmbeddedImageTransform();
+      IngestPose(m_embeddedImageTransformName->GetTransformNameInternal(), embeddedImageTransform, embeddedImageTransform != float4x4::identity(), unfilteredTimestamp, filteredTimestamp);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::IngestTransformMessage(igtl::MessageBase::Pointer message, double receiveTime)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    if (m_toolIngestTargets.empty())
+    {
+      return;
+    }
+
+    auto transformMessage = dynamic_cast<igtl::TransformMessage*>(message.GetPointer());
+    auto ts = igtl::TimeStamp::New();
+    transformMessage->GetTimeStamp(ts);
+
+    igtl::Matrix4x4 mat;
+    transformMessage->GetMatrix(mat);
+    float4x4 matrix;
+    XMStoreFloat4x4(&matrix, XMLoadFloat4x4(&DirectX::XMFLOAT4X4(&mat[0][0])));
+
+    float unfilteredTimestamp(0.f);
+    float filteredTimestamp(0.f);
+    GetIngestTimestamps(ts->GetTimeStamp(), receiveTime, unfilteredTimestamp, filteredTimestamp);
+
+    std::string name(transformMessage->GetDeviceName());
+    IngestPose(std::wstring(begin(name), end(name)), matrix, matrix != float4x4::identity(), unfilteredTimestamp, filteredTimestamp);
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::IngestTDataMessage(igtl::MessageBase::Pointer message, double receiveTime)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    if (m_toolIngestTargets.empty())
+    {
+      return;
+    }
+
+    auto tdataMsg = dynamic_cast<igtl::TrackingDataMessage*>(message.GetPointer());
+    auto ts = igtl::TimeStamp::New();
+    tdataMsg->GetTimeStamp(ts);
+    float unfilteredTimestamp(0.f);
+    float filteredTimestamp(0.f);
+    GetIngestTimestamps(ts->GetTimeStamp(), receiveTime, unfilteredTimestamp, filteredTimestamp);
+
+    auto element = igtl::TrackingDataElement::New();
+    igtl::Matrix4x4 mat;
+    for (int i = 0; i < tdataMsg->GetNumberOfTrackingDataElements(); ++i)
+    {
+      tdataMsg->GetTrackingDataElement(i, element);
+      element->GetMatrix(mat);
+      float4x4 matrix;
+      XMStoreFloat4x4(&matrix, XMLoadFloat4x4(&DirectX::XMFLOAT4X4(&mat[0][0])));
+
+      std::string name(element->GetName());
+      IngestPose(std::wstring(begin(name), end(name)), matrix, matrix != float4x4::identity(), unfilteredTimestamp, filteredTimestamp);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::IngestPose(const std::wstring& name, const float4x4& matrix, bool valid, float unfilteredTimestamp, float filteredTimestamp)
+  {
+    auto iter = m_toolIngestTargets.find(name);
+    if (iter == m_toolIngestTargets.end())
+    {
+      return;
+    }
+    iter->second.TargetBuffer->AddTimeStampedItem(matrix, valid ? TOOL_OK : TOOL_MISSING, iter->second.FrameNumber++, unfilteredTimestamp, nullptr, filteredTimestamp);
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::GetIngestTimestamps(double messageTimestamp, double receiveTime, float& outUnfilteredTimestamp, float& outFilteredTimestamp)
+  {
+    if (m_globalTimeOrigin == UNDEFINED_TIMESTAMP)
+    {
+      m_globalTimeOrigin = receiveTime;
+    }
+
+    // Absolute times (seconds since the epoch or since boot) only keep sub-millisecond resolution as float relative to the origin
+    if (m_receiveTimestamping)
+    {
+      if (m_ingestTimeOrigin == UNDEFINED_TIMESTAMP)
+      {
+        m_ingestTimeOrigin = receiveTime;
+        UpdateIngestTimeOffsets();
+      }
+      // The buffer filters the arrival jitter out of the receive times
+      outUnfilteredTimestamp = static_cast<float>(receiveTime - m_ingestTimeOrigin);
+      outFilteredTimestamp = UNDEFINED_TIMESTAMP_FLOAT;
+      return;
+    }
+
+    if (m_ingestTimeOrigin == UNDEFINED_TIMESTAMP)
+    {
+      m_ingestTimeOrigin = messageTimestamp;
+      UpdateIngestTimeOffsets();
+    }
+    outUnfilteredTimestamp = static_cast<float>(messageTimestamp - m_ingestTimeOrigin);
+    outFilteredTimestamp = outUnfilteredTimestamp;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::PrepareIngestFrameFormat(Buffer^ buffer, Image^ image, int imageType, int imageOrientation)
+  {
+    if (buffer->GetNumberOfItems() > 0)
+    {
+      // Buffer::AddItem reports a format mismatch
+      return true;
+    }
+
+    // The first item defines the frame format of the buffer
+    auto frameSize = image->GetFrameSize();
+    return buffer->SetFrameSize(frameSize[0], frameSize[1], frameSize[2]) &&
+           buffer->SetPixelType(image->ScalarType) &&
+           buffer->SetNumberOfScalarComponents(image->NumberOfScalarComponents) &&
+           buffer->SetImageType(imageType) &&
+           buffer->SetImageOrientation(imageOrientation);
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::SendClockProbe()
+  {
+    auto getStatusMsg = igtl::GetStatusMessage::New();
+    getStatusMsg->SetDeviceName(CLOCK_PROBE_DEVICE_NAME);
+    getStatusMsg->Pack();
+
+    // The send stream has its own lock, a pump blocked waiting for the next header does not hold back the probe
+    std::lock_guard<std::mutex> guard(m_sendMutex);
+    if (m_sendStream == nullptr)
+    {
+      return false;
+    }
+
+    {
+      // Stamped once the send stream is ours, waiting for it is not part of the round trip
+      std::lock_guard<std::mutex> ingestGuard(m_ingestMutex);
+      m_clockProbeSendTime = GetMonotonicTimeSec();
+    }
+    m_sendStream->WriteBytes(Platform::ArrayReference<byte>((byte*)getStatusMsg->GetBufferPointer(), getStatusMsg->GetBufferSize()));
+    create_task(m_sendStream->StoreAsync()).then([](task<uint32> writeTask)
+    {
+      try
+      {
+        writeTask.get();
+      }
+      catch (Platform::Exception^ exception)
+      {
+        // The reply will not come, the next probe replaces this one
+      }
+    });
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::AddClockProbeReply(igtl::MessageBase::Pointer reply, double receiveTime)
+  {
+    if (std::string(reply->GetDeviceName()) != CLOCK_PROBE_DEVICE_NAME)
+    {
+      // Keep alive or device status, its send time is unrelated to the probe
+      return;
+    }
+
+    auto ts = igtl::TimeStamp::New();
+    reply->GetTimeStamp(ts);
+    if (ts->GetTimeStamp() == 0.0)
+    {
+      // Not stamped by the server
+      return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    if (m_clockProbeSendTime == UNDEFINED_TIMESTAMP || receiveTime < m_clockProbeSendTime)
+    {
+      // Unsolicited reply, or one that was on its way before the probe was sent
+      return;
+    }
+
+    double sendTime = m_clockProbeSendTime;
+    m_clockProbeSendTime = UNDEFINED_TIMESTAMP;
+    if (receiveTime - sendTime > CLOCK_PROBE_TIMEOUT_SEC)
+    {
+      return;
+    }
+
+    if (m_clockOffsetEstimator.AddSample(sendTime, ts->GetTimeStamp(), receiveTime))
+    {
+      UpdateIngestTimeOffsets();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::UpdateIngestTimeOffsets()
+  {
+    if (!m_clockSynchronization || m_ingestTimeOrigin == UNDEFINED_TIMESTAMP || m_globalTimeOrigin == UNDEFINED_TIMESTAMP)
+    {
+      return;
+    }
+
+    // global = local + offset = monotonic time - global time origin
+    double offset(0.0);
+    if (m_receiveTimestamping)
+    {
+      offset = m_ingestTimeOrigin - m_globalTimeOrigin;
+    }
+    else if (m_clockOffsetEstimator.HasEstimate())
+    {
+      // local = server time - ingest time origin, server time = monotonic time + clock offset
+      offset = m_ingestTimeOrigin - m_clockOffsetEstimator.GetOffsetSec(GetMonotonicTimeSec()) - m_globalTimeOrigin;
+    }
+    else
+    {
+      return;
+    }
+
+    const float offsetSec = static_cast<float>(offset);
+    if (m_imageIngestTarget.TargetBuffer != nullptr)
+    {
+      m_imageIngestTarget.TargetBuffer->SetLocalTimeOffsetSec(offsetSec);
+    }
+    if (m_trackedFrameIngestTarget.TargetBuffer != nullptr)
+    {
+      m_trackedFrameIngestTarget.TargetBuffer->SetLocalTimeOffsetSec(offsetSec);
+    }
+    for (auto& pair : m_toolIngestTargets)
+    {
+      pair.second.TargetBuffer->SetLocalTimeOffsetSec(offsetSec);
+    }
   }
 
   //----------------------------------------------------------------------------
@@ -1396,4 +2152,105 @@ namespace UWPOpenIGTLink
   {
     m_embeddedImageTransformName = arg;
   }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::TrustedLink::get()
+  {
+    return m_trustedLink;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::TrustedLink::set(bool arg)
+  {
+    m_trustedLink = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::ResynchronizationCount::get()
+  {
+    return m_resynchronizationCount;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::ReceiveTimestamping::get()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_receiveTimestamping;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::ReceiveTimestamping::set(bool arg)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    if (m_receiveTimestamping != arg)
+    {
+      // The origin is in the clock domain of the ingested timestamps
+      m_receiveTimestamping = arg;
+      m_ingestTimeOrigin = UNDEFINED_TIMESTAMP;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::ClockSynchronization::get()
+  {
+    return m_clockSynchronization;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::ClockSynchronization::set(bool arg)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    m_clockSynchronization = arg;
+    UpdateIngestTimeOffsets();
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::ClockSynchronized::get()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_clockOffsetEstimator.HasEstimate();
+  }
+
+  //----------------------------------------------------------------------------
+  double IGTClient::ClockOffsetSec::get()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_clockOffsetEstimator.GetOffsetSec(GetMonotonicTimeSec());
+  }
+
+  //----------------------------------------------------------------------------
+  double IGTClient::ClockOffsetUncertaintySec::get()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_clockOffsetEstimator.GetUncertaintySec();
+  }
+
+  //----------------------------------------------------------------------------
+  double IGTClient::ClockDriftPpm::get()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_clockOffsetEstimator.GetDriftPpm();
+  }
+
+  //----------------------------------------------------------------------------
+  double IGTClient::GlobalTimeOrigin::get()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_globalTimeOrigin;
+  }
+
+  //----------------------------------------------------------------------------
+  double IGTClient::IngestTimeOrigin::get()
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    return m_ingestTimeOrigin;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::IngestTimeOrigin::set(double arg)
+  {
+    std::lock_guard<std::mutex> guard(m_ingestMutex);
+    m_ingestTimeOrigin = arg;
+    UpdateIngestTimeOffsets();
+  }
 }
@@ -27,10 +27,13 @@ OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 // Local includes
+#include "Buffer.h"
+#include "ClockOffsetEstimator.h"
 #include "Command.h"
 #include "IGTCommon.h"
 #include "Polydata.h"
 #include "TrackedFrame.h"
+#include "TrackedFrameJoiner.h"
 #include "TrackedFrameMessage.h"
 
 // IGT includes
@@ -41,7 +44,10 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include <igtlTransformMessage.h>
 
 // STL includes
+#include <atomic>
 #include <deque>
+#include <map>
+#include <set>
 #include <string>
 
 // Windows includes
@@ -62,6 +68,7 @@ namespace UWPOpenIGTLink
   ref class IGTClient;
   public delegate void ErrorMessageEventHandler(IGTClient^ sender, Platform::String^ s);
   public delegate void WarningMessageEventHandler(IGTClient^ sender, Platform::String^ s);
+  public delegate void ReceiveProgressEventHandler(IGTClient^ sender, Platform::String^ messageType, uint64 bytesReceived, uint64 bodySize);
 
   ///
   /// \class IGTLinkClient
@@ -81,9 +88,42 @@ namespace UWPOpenIGTLink
     property float TrackerUnitScale { float get(); void set(float); }
     property TransformName^ EmbeddedImageTransformName { TransformName ^ get(); void set(TransformName^); }
 
+    /// When true the body CRC of received messages is not verified. Only enable for loopback or shared-memory links that cannot corrupt data.
+    property bool TrustedLink { bool get(); void set(bool); }
+
+    /// Number of times the receive stream had to be resynchronized to the next plausible message header after corruption
+    property uint64 ResynchronizationCount { uint64 get(); }
+
+    /*!
+      When true the ingest buffers get the time the message arrived at the socket (monotonic clock, see GetMonotonicTimeSec) as the
+      unfiltered timestamp and compute the filtered timestamp from it, instead of using the sender's timestamp. Resets IngestTimeOrigin.
+    */
+    property bool ReceiveTimestamping { bool get(); void set(bool); }
+
+    /// Time (seconds) that maps to time 0 in the ingest buffers, in the sender's clock or with ReceiveTimestamping in the monotonic clock.
+    /// Set from the first ingested message if not set before.
+    property double IngestTimeOrigin { double get(); void set(double); }
+
+    /*!
+      When true a GET_STATUS round trip is sent every second while connected, and the STATUS replies are used to estimate
+      the server clock against the monotonic clock (see ClockOffsetEstimator). The local time offset of the ingest buffers
+      is kept up to date, so that their global time is GetMonotonicTimeSec() - GlobalTimeOrigin.
+    */
+    property bool ClockSynchronization { bool get(); void set(bool); }
+    /// True once a round trip has been accepted since connecting
+    property bool ClockSynchronized { bool get(); }
+    /// Server clock - monotonic clock in seconds, now
+    property double ClockOffsetSec { double get(); }
+    property double ClockOffsetUncertaintySec { double get(); }
+    property double ClockDriftPpm { double get(); }
+    /// Monotonic time (seconds) that is time 0 in the global time of the ingest buffers, set by the first ingested message
+    property double GlobalTimeOrigin { double get(); }
+
   public:
     event ErrorMessageEventHandler^ ErrorMessage;
     event WarningMessageEventHandler^ WarningMessage;
+    /// Raised after each chunk of a message body larger than one receive chunk (1MB) has arrived
+    event ReceiveProgressEventHandler^ ReceiveProgress;
 
   public:
     IGTClient();
@@ -122,6 +162,25 @@ namespace UWPOpenIGTLink
     /// Answer if a command has been completed and result returned
     bool IsCommandComplete(uint32 commandId);
 
+    /// Add every received IMAGE message to the buffer (nullptr to stop), sharing the image memory of the message
+    void SetImageIngestBuffer(Buffer^ buffer);
+    Buffer^ GetImageIngestBuffer();
+
+    /// Add every received TRACKEDFRAME message (image and custom fields) to the buffer (nullptr to stop), sharing the image memory of the message
+    void SetTrackedFrameIngestBuffer(Buffer^ buffer);
+    Buffer^ GetTrackedFrameIngestBuffer();
+
+    /*!
+      Add every received pose of the tool to the buffer (nullptr to stop), from TRANSFORM messages, TDATA elements
+      and TRACKEDFRAME transforms. The name must match the transform name as it is sent by the server.
+    */
+    void SetToolIngestBuffer(TransformName^ name, Buffer^ buffer);
+    Buffer^ GetToolIngestBuffer(TransformName^ name);
+
+    /// Run the joiner (see TrackedFrameJoiner::Process) on the receiver thread after each received message, nullptr to stop
+    void SetTrackedFrameJoiner(TrackedFrameJoiner^ joiner);
+    TrackedFrameJoiner^ GetTrackedFrameJoiner();
+
   internal:
     /// Send a packed message to the connected server
     Concurrency::task<bool> SendMessageAsyncInternal(igtl::MessageBase::Pointer packedMessage);
@@ -132,6 +191,9 @@ namespace UWPOpenIGTLink
     /// Threaded function to receive data from the connected server
     void DataReceiverPump();
 
+    /// Threaded function to send the clock synchronization round trips
+    void ClockProbePump();
+
   protected private:
     void PruneIGTMessages();
 
@@ -158,20 +220,70 @@ namespace UWPOpenIGTLink
 
     int32 SocketReceive(void* dest, int size);
 
+    /*!
+      Receive the body of a message directly into its buffer in chunks of RECEIVE_CHUNK_SIZE bytes, without staging the whole body.
+      The CRC of each chunk is computed while the next one is loading (unless the link is trusted), then the body is unpacked.
+      Only the read stream is locked while a chunk is awaited, messages and clock probes are sent under their own lock.
+    */
+    bool ReceiveBody(igtl::MessageBase::Pointer bodyMsg, uint64 expectedCrc);
+
+    /// Read past the body of a message that is not received (unknown type) in chunks of RECEIVE_CHUNK_SIZE bytes, returns false if the connection was lost
+    bool SkipBody(uint64 bodySize);
+
+    /*!
+      Scan the incoming byte stream for the next plausible message header (supported version, known message type,
+      printable device name, sane body size) starting after the first byte of rawHeader, the rejected header.
+      These heuristics only pick a candidate out of a stream that has lost its framing, headers received in sequence
+      are accepted as long as they unpack (messages of unknown types, long bodies or unusual device names are valid).
+      On success headerMsg contains the candidate header (already unpacked), rawHeader its network byte order copy,
+      and any bytes read past it are kept for the next SocketReceive call.
+      Returns false if the connection was lost or the receiver is being cancelled.
+    */
+    bool ResynchronizeHeader(igtl::MessageHeader::Pointer headerMsg, byte* rawHeader, const Concurrency::cancellation_token& token);
+    bool IsPlausibleHeader(const byte* data) const;
+
+    /*!
+      Add a received message to the ingest buffers, called by the receiver pump before the message can be pruned.
+      receiveTime is the monotonic time the header of the message was read from the socket.
+    */
+    void IngestImageMessage(igtl::MessageBase::Pointer message, double receiveTime);
+    void IngestTrackedFrameMessage(igtl::MessageBase::Pointer message, double receiveTime);
+    void IngestTransformMessage(igtl::MessageBase::Pointer message, double receiveTime);
+    void IngestTDataMessage(igtl::MessageBase::Pointer message, double receiveTime);
+
+    /// Add a pose to the buffer of the tool if there is one, caller must hold m_ingestMutex
+    void IngestPose(const std::wstring& name, const Windows::Foundation::Numerics::float4x4& matrix, bool valid, float unfilteredTimestamp, float filteredTimestamp);
+    /// Convert the timestamps of a message to the ingest buffer time, caller must hold m_ingestMutex
+    void GetIngestTimestamps(double messageTimestamp, double receiveTime, float& outUnfilteredTimestamp, float& outFilteredTimestamp);
+    /// Match the frame format of an empty buffer to the image, returns false if the buffer holds items of another format
+    static bool PrepareIngestFrameFormat(Buffer^ buffer, Image^ image, int imageType, int imageOrientation);
+
+    /// Send a GET_STATUS message and remember its send time
+    bool SendClockProbe();
+    /// Add the round trip of a received STATUS message to the clock offset estimate if it answers the outstanding probe (same device name)
+    void AddClockProbeReply(igtl::MessageBase::Pointer reply, double receiveTime);
+    /// Set the local time offset of the ingest buffers from the clock offset estimate, caller must hold m_ingestMutex
+    void UpdateIngestTimeOffsets();
+
   protected private:
     /// igtl Factory for message sending
     igtl::MessageFactory::Pointer                     m_igtlMessageFactory = igtl::MessageFactory::New();
+    std::set<std::string>                             m_knownMessageTypes;
 
     Concurrency::task<void>                           m_dataReceiverTask;
     Concurrency::cancellation_token_source            m_receiverPumpTokenSource;
 
-    /// Socket that is connected to the server
+    /// Socket that is connected to the server, m_socketMutex guards the read stream and m_sendMutex the send stream
     std::mutex                                        m_socketMutex;
+    std::mutex                                        m_sendMutex;
     Windows::Networking::Sockets::StreamSocket^       m_clientSocket = ref new Windows::Networking::Sockets::StreamSocket();
     Windows::Storage::Streams::DataWriter^            m_sendStream = nullptr;
     Windows::Storage::Streams::DataReader^            m_readStream = nullptr;
     Windows::Networking::HostName^                    m_hostName = nullptr;
     std::atomic_bool                                  m_connected = false;
+    std::vector<byte>                                 m_pendingReceiveBytes; // bytes read ahead during resynchronization, consumed before the socket
+    double                                            m_lastReceiveTime = 0.0; // monotonic time the latest socket read completed
+    double                                            m_pendingReceiveTime = 0.0; // monotonic time the read-ahead bytes were loaded
 
     /// Lists of messages received through the socket, transformed to igtl messages
     mutable std::mutex                                m_receivedMessagesMutex;
@@ -196,8 +308,35 @@ namespace UWPOpenIGTLink
     TransformName^                                    m_embeddedImageTransformName = nullptr;
     Platform::String^                                 m_serverPort = L"18944";
     int                                               m_serverIGTLVersion = IGTL_HEADER_VERSION_2;
+    std::atomic_bool                                  m_trustedLink = false;
+    std::atomic<uint64>                               m_resynchronizationCount = 0;
+
+    /// Buffers fed by the receiver pump
+    struct IngestTarget
+    {
+      Buffer^ TargetBuffer = nullptr;
+      uint32  FrameNumber = 0;
+    };
+    std::mutex                                        m_ingestMutex;
+    IngestTarget                                      m_imageIngestTarget;
+    IngestTarget                                      m_trackedFrameIngestTarget;
+    std::map<std::wstring, IngestTarget>              m_toolIngestTargets;
+    double                                            m_ingestTimeOrigin = UNDEFINED_TIMESTAMP;
+    TrackedFrameJoiner^                               m_trackedFrameJoiner = nullptr;
+    bool                                              m_receiveTimestamping = false;
+
+    /// Clock synchronization, the estimate is guarded by m_ingestMutex
+    Concurrency::cancellation_token_source            m_clockProbeTokenSource;
+    std::atomic_bool                                  m_clockSynchronization = false;
+    double                                            m_clockProbeSendTime = UNDEFINED_TIMESTAMP;
+    ClockOffsetEstimator                              m_clockOffsetEstimator;
+    double                                            m_globalTimeOrigin = UNDEFINED_TIMESTAMP;
 
     static const int                                  CLIENT_SOCKET_TIMEOUT_MSEC;
+    static const int                                  CLOCK_PROBE_INTERVAL_MSEC;
+    static const double                               CLOCK_PROBE_TIMEOUT_SEC;
+    static const uint64                               MAXIMUM_PLAUSIBLE_BODY_SIZE;
+    static const uint32                               RECEIVE_CHUNK_SIZE;
     static const MessageList::size_type               MESSAGE_LIST_IMAGE_MAX_SIZE;
     static const MessageList::size_type               MESSAGE_LIST_TRACKEDFRAME_MAX_SIZE;
     static const MessageList::size_type               MESSAGE_LIST_COMMANDREPLY_MAX_SIZE;
@@ -0,0 +1,319 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#include "pch.h"
+#include "PlayoutScheduler.h"
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+
+using namespace Platform::Collections;
+using namespace Windows::Foundation::Collections;
+
+namespace
+{
+  static const uint32 AGE_WINDOW_SIZE = 300;          // number of recorded vsync ages, 5 s at 60 Hz
+  static const float DELAY_DECREASE_FACTOR = 0.02f;   // fraction of the excess delay removed per vsync
+}
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  PlayoutFrame::PlayoutFrame(float contentTime, StreamBufferItem^ frame, IVectorView<StreamBufferItem^>^ poses, bool underrun)
+    : m_contentTime(contentTime)
+    , m_frame(frame)
+    , m_poses(poses)
+    , m_underrun(underrun)
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  float PlayoutFrame::ContentTime::get()
+  {
+    return m_contentTime;
+  }
+
+  //----------------------------------------------------------------------------
+  StreamBufferItem^ PlayoutFrame::Frame::get()
+  {
+    return m_frame;
+  }
+
+  //----------------------------------------------------------------------------
+  IVectorView<StreamBufferItem^>^ PlayoutFrame::Poses::get()
+  {
+    return m_poses;
+  }
+
+  //----------------------------------------------------------------------------
+  bool PlayoutFrame::Underrun::get()
+  {
+    return m_underrun;
+  }
+
+  //----------------------------------------------------------------------------
+  PlayoutScheduler::PlayoutScheduler(Buffer^ frameBuffer)
+    : m_frameBuffer(frameBuffer)
+  {
+    m_ages.reserve(AGE_WINDOW_SIZE);
+  }
+
+  //----------------------------------------------------------------------------
+  PlayoutScheduler::~PlayoutScheduler()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 PlayoutScheduler::AddPoseBuffer(Buffer^ poseBuffer)
+  {
+    if (poseBuffer == nullptr)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Pose buffer must not be null.");
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_poseBuffers.push_back(poseBuffer);
+    return static_cast<uint32>(m_poseBuffers.size() - 1);
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 PlayoutScheduler::GetNumberOfPoseBuffers()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return static_cast<uint32>(m_poseBuffers.size());
+  }
+
+  //----------------------------------------------------------------------------
+  void PlayoutScheduler::SetTargetUnderrunRate(float rate)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_targetUnderrunRate = (std::min)((std::max)(rate, 0.f), 1.f);
+  }
+
+  //----------------------------------------------------------------------------
+  float PlayoutScheduler::GetTargetUnderrunRate()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_targetUnderrunRate;
+  }
+
+  //----------------------------------------------------------------------------
+  void PlayoutScheduler::SetMinimumDelaySec(float delaySec)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_minimumDelaySec = (std::max)(delaySec, 0.f);
+    m_maximumDelaySec = (std::max)(m_maximumDelaySec, m_minimumDelaySec);
+  }
+
+  //----------------------------------------------------------------------------
+  float PlayoutScheduler::GetMinimumDelaySec()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_minimumDelaySec;
+  }
+
+  //----------------------------------------------------------------------------
+  void PlayoutScheduler::SetMaximumDelaySec(float delaySec)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_maximumDelaySec = (std::max)(delaySec, 0.f);
+    m_minimumDelaySec = (std::min)(m_minimumDelaySec, m_maximumDelaySec);
+  }
+
+  //----------------------------------------------------------------------------
+  float PlayoutScheduler::GetMaximumDelaySec()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_maximumDelaySec;
+  }
+
+  //----------------------------------------------------------------------------
+  float PlayoutScheduler::GetPlayoutDelaySec()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_playoutDelaySec;
+  }
+
+  //----------------------------------------------------------------------------
+  float PlayoutScheduler::GetArrivalJitterSec()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_arrivalJitterSec;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 PlayoutScheduler::GetNumberOfPresentations()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numberOfPresentations;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 PlayoutScheduler::GetNumberOfUnderruns()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numberOfUnderruns;
+  }
+
+  //----------------------------------------------------------------------------
+  PlayoutFrame^ PlayoutScheduler::GetPresentationFrame(float vsyncTime)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    // The content time is servable if every buffer has data up to it, so the age of the oldest newest item matters
+    bool hasData(false);
+    float age(0.f);
+    auto recordAge = [&](Buffer^ buffer)
+    {
+      float latestTimestamp(0.f);
+      if (buffer->GetLatestTimeStamp(&latestTimestamp) != ITEM_OK)
+      {
+        return;
+      }
+      age = hasData ? (std::max)(age, vsyncTime - latestTimestamp) : vsyncTime - latestTimestamp;
+      hasData = true;
+    };
+    if (m_frameBuffer != nullptr)
+    {
+      recordAge(m_frameBuffer);
+    }
+    for (auto poseBuffer : m_poseBuffers)
+    {
+      recordAge(poseBuffer);
+    }
+    if (!hasData)
+    {
+      return nullptr;
+    }
+
+    UpdatePlayoutDelay(age, m_playoutDelayValid ? (std::max)(vsyncTime - m_lastVsyncTime, 0.f) : 0.f);
+    m_lastVsyncTime = vsyncTime;
+
+    float contentTime = vsyncTime - m_playoutDelaySec;
+    bool underrun = age > m_playoutDelaySec;
+    m_numberOfPresentations++;
+    if (underrun)
+    {
+      m_numberOfUnderruns++;
+    }
+
+    StreamBufferItem^ frame = nullptr;
+    if (m_frameBuffer != nullptr)
+    {
+      // Pinned while it is copied, the writer must not reuse the slot item while the frame is presented
+      StreamBufferItem^ pinnedFrame = m_frameBuffer->PinStreamBufferItemFromTime(contentTime);
+      if (pinnedFrame != nullptr)
+      {
+        frame = ref new StreamBufferItem();
+        frame->ShallowCopyInternal(pinnedFrame, true);
+        m_frameBuffer->UnpinStreamBufferItem(pinnedFrame);
+      }
+    }
+    auto poses = ref new Vector<StreamBufferItem^>();
+    for (auto poseBuffer : m_poseBuffers)
+    {
+      StreamBufferItem^ pose = poseBuffer->GetStreamBufferItemFromTime(contentTime, INTERPOLATED);
+      if (pose == nullptr)
+      {
+        // Nothing to interpolate from (e.g. the buffer is empty)
+        pose = ref new StreamBufferItem();
+        pose->SetStatus(TOOL_MISSING);
+        pose->SetFilteredTimestamp(contentTime - poseBuffer->GetLocalTimeOffsetSec());
+        pose->SetUnfilteredTimestamp(contentTime - poseBuffer->GetLocalTimeOffsetSec());
+      }
+      poses->Append(pose);
+    }
+
+    return ref new PlayoutFrame(contentTime, frame, poses->GetView(), underrun);
+  }
+
+  //----------------------------------------------------------------------------
+  void PlayoutScheduler::Reset()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_ages.clear();
+    m_agesWritePointer = 0;
+    m_arrivalJitterSec = 0.f;
+    m_playoutDelaySec = 0.f;
+    m_playoutDelayValid = false;
+    m_lastVsyncTime = 0.f;
+    m_numberOfPresentations = 0;
+    m_numberOfUnderruns = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  void PlayoutScheduler::UpdatePlayoutDelay(float age, float elapsedSec)
+  {
+    if (m_ages.size() < AGE_WINDOW_SIZE)
+    {
+      m_ages.push_back(age);
+    }
+    else
+    {
+      m_ages[m_agesWritePointer] = age;
+      m_agesWritePointer = (m_agesWritePointer + 1) % AGE_WINDOW_SIZE;
+    }
+
+    double sum(0.0);
+    double sumOfSquares(0.0);
+    for (auto value : m_ages)
+    {
+      sum += value;
+      sumOfSquares += static_cast<double>(value) * value;
+    }
+    double mean = sum / m_ages.size();
+    m_arrivalJitterSec = static_cast<float>(std::sqrt((std::max)(sumOfSquares / m_ages.size() - mean * mean, 0.0)));
+
+    // Smallest delay that would have served all but the target fraction of the recent vsyncs
+    std::vector<float> sortedAges(m_ages);
+    auto quantileIndex = static_cast<size_t>(std::ceil((1.0 - m_targetUnderrunRate) * (sortedAges.size() - 1)));
+    std::nth_element(sortedAges.begin(), sortedAges.begin() + quantileIndex, sortedAges.end());
+    float requiredDelay = sortedAges[quantileIndex];
+
+    if (!m_playoutDelayValid)
+    {
+      m_playoutDelaySec = (std::min)((std::max)(requiredDelay, m_minimumDelaySec), m_maximumDelaySec);
+      m_playoutDelayValid = true;
+      return;
+    }
+
+    float delay = m_playoutDelaySec;
+    if (requiredDelay > delay)
+    {
+      delay = requiredDelay;
+    }
+    else
+    {
+      // Shrink slowly, the content time then runs slightly faster than the display instead of jumping
+      delay -= (delay - requiredDelay) * DELAY_DECREASE_FACTOR;
+    }
+    delay = (std::min)((std::max)(delay, m_minimumDelaySec), m_maximumDelaySec);
+
+    // Growing faster than the display time advances would move the content time backwards, hold it still instead
+    m_playoutDelaySec = (std::min)(delay, m_playoutDelaySec + elapsedSec);
+  }
+}
@@ -0,0 +1,135 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+// Local includes
+#include "Buffer.h"
+#include "IGTCommon.h"
+#include "StreamBufferItem.h"
+
+// STL includes
+#include <mutex>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  /// Content of one display refresh, see PlayoutScheduler::GetPresentationFrame
+  public ref class PlayoutFrame sealed
+  {
+  public:
+    /// Time of the presented content (vsync time - playout delay), in the time domain of the buffers
+    property float ContentTime { float get(); }
+    /// Copy of the frame closest to the content time sharing its image, nullptr if there is no frame buffer or it is empty
+    property StreamBufferItem^ Frame { StreamBufferItem^ get(); }
+    /// Poses interpolated at the content time, in the order the pose buffers were added (TOOL_MISSING status if unavailable)
+    property Windows::Foundation::Collections::IVectorView<StreamBufferItem^>^ Poses { Windows::Foundation::Collections::IVectorView<StreamBufferItem^>^ get(); }
+    /// True if the newest data of some buffer was older than the content time, i.e. the content had not arrived yet
+    property bool Underrun { bool get(); }
+
+  internal:
+    PlayoutFrame(float contentTime, StreamBufferItem^ frame, Windows::Foundation::Collections::IVectorView<StreamBufferItem^>^ poses, bool underrun);
+
+  protected private:
+    float                                                         m_contentTime;
+    StreamBufferItem^                                             m_frame;
+    Windows::Foundation::Collections::IVectorView<StreamBufferItem^>^ m_poses;
+    bool                                                          m_underrun;
+  };
+
+  /*!
+    Paces the presentation of buffered content to the display refresh (e.g. 60 Hz) instead of showing the newest item.
+    At each vsync the age of the newest item of every buffer (vsync time - latest filtered timestamp) is recorded.
+    The content time of a presentation is vsync time - playout delay, and it can be served without an underrun
+    if the delay is at least the age of the newest item of every buffer. The delay is therefore the
+    (1 - target underrun rate) quantile of the recent ages, which covers the frame period plus the arrival jitter.
+    The delay shrinks slowly, and it grows by at most the time elapsed since the previous vsync (the content holds still
+    until the delay has caught up), so the presented content time advances smoothly and never goes backwards.
+    The vsync times must be in the time domain of the buffers (global time, see Buffer::SetLocalTimeOffsetSec).
+  */
+  public ref class PlayoutScheduler sealed
+  {
+  public:
+    /// frameBuffer may be nullptr for pose only presentation
+    PlayoutScheduler(Buffer^ frameBuffer);
+    virtual ~PlayoutScheduler();
+
+    /// Add a buffer of poses to interpolate at the content time, returns its index in PlayoutFrame::Poses
+    uint32 AddPoseBuffer(Buffer^ poseBuffer);
+    /// Get the number of pose buffers
+    uint32 GetNumberOfPoseBuffers();
+
+    /// Set the allowed fraction of presentations whose content has not arrived yet (default 0.01)
+    void SetTargetUnderrunRate(float rate);
+    float GetTargetUnderrunRate();
+    /// Set the range of the playout delay in seconds (default 0 - 0.5)
+    void SetMinimumDelaySec(float delaySec);
+    float GetMinimumDelaySec();
+    void SetMaximumDelaySec(float delaySec);
+    float GetMaximumDelaySec();
+
+    /// Get the current playout delay in seconds
+    float GetPlayoutDelaySec();
+    /// Get the standard deviation of the age of the newest item at the recent vsync times in seconds
+    float GetArrivalJitterSec();
+    /// Get the number of presentations and underruns since construction or Reset
+    uint64 GetNumberOfPresentations();
+    uint64 GetNumberOfUnderruns();
+
+    /*!
+      Get the frame and poses to show at a display refresh and update the playout delay.
+      Call once per vsync, with non-decreasing vsync times. Returns nullptr if all buffers are empty.
+    */
+    PlayoutFrame^ GetPresentationFrame(float vsyncTime);
+
+    /// Forget the recorded ages, the delay and the statistics
+    void Reset();
+
+  protected private:
+    /// Record the age of the newest item and update m_playoutDelaySec, growing it by at most elapsedSec, caller must hold m_mutex
+    void UpdatePlayoutDelay(float age, float elapsedSec);
+
+  protected private:
+    std::mutex              m_mutex;
+    Buffer^                 m_frameBuffer;
+    std::vector<Buffer^>    m_poseBuffers;
+
+    float                   m_targetUnderrunRate = 0.01f;
+    float                   m_minimumDelaySec = 0.f;
+    float                   m_maximumDelaySec = 0.5f;
+    float                   m_playoutDelaySec = 0.f;
+    bool                    m_playoutDelayValid = false;
+    float                   m_lastVsyncTime = 0.f;
+
+    // Ages of the newest item at the recent vsync times, circular
+    std::vector<float>      m_ages;
+    uint32                  m_agesWritePointer = 0;
+    float                   m_arrivalJitterSec = 0.f;
+
+    uint64                  m_numberOfPresentations = 0;
+    uint64                  m_numberOfUnderruns = 0;
+  };
+}
@@ -0,0 +1,508 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#include "pch.h"
+#include "PoseBuffer.h"
+
+// STL includes
+#include <algorithm>
+#include <sstream>
+
+using namespace Windows::Foundation::Numerics;
+
+namespace
+{
+  static const float NEGLIGIBLE_TIME_DIFFERENCE = 0.00001f; // in seconds, used for comparing between exact timestamps
+  static const uint32 DEFAULT_BUFFER_SIZE = 50;
+}
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  PoseBuffer::PoseBuffer()
+  {
+    this->SetBufferSize(DEFAULT_BUFFER_SIZE);
+  }
+
+  //----------------------------------------------------------------------------
+  PoseBuffer::~PoseBuffer()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  bool PoseBuffer::SetBufferSize(uint32 numberOfItems)
+  {
+    if (numberOfItems < 1)
+    {
+      OutputDebugStringA("PoseBuffer: Cannot set buffer size, at least one item is required.");
+      return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_bufferSize = numberOfItems;
+    m_numberOfItems = 0;
+    m_writePointer = 0;
+    m_filteredTimestamps.assign(m_bufferSize, 0.f);
+    m_unfilteredTimestamps.assign(m_bufferSize, 0.f);
+    m_indices.assign(m_bufferSize, 0);
+    m_poses.assign(m_bufferSize, ToolPose());
+    m_status.assign(m_bufferSize, static_cast<uint8>(TOOL_MISSING));
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 PoseBuffer::GetBufferSize()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_bufferSize;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 PoseBuffer::GetNumberOfItems()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numberOfItems;
+  }
+
+  //----------------------------------------------------------------------------
+  bool PoseBuffer::AddTimeStampedItem(float4x4 matrix, int toolStatus, uint32 frameNumber, float unfilteredTimestamp, float filteredTimestamp)
+  {
+    if (IsUndefinedTimestamp(unfilteredTimestamp))
+    {
+      unfilteredTimestamp = filteredTimestamp;
+    }
+    if (IsUndefinedTimestamp(filteredTimestamp))
+    {
+      filteredTimestamp = unfilteredTimestamp;
+    }
+    if (IsUndefinedTimestamp(filteredTimestamp))
+    {
+      OutputDebugStringA("PoseBuffer: Cannot add item without a timestamp.");
+      return false;
+    }
+
+    // Decompose once here instead of on every interpolated query
+    ToolPose pose;
+    DecomposeMatrix(matrix, pose.Scale, pose.Rotation, pose.Translation);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_numberOfItems > 0 && filteredTimestamp <= m_filteredTimestamps[GetSlot(m_numberOfItems - 1)])
+    {
+      // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
+      OutputDebugStringA("PoseBuffer: Need to skip newly added item - new timestamp is not newer than the last one!");
+      return false;
+    }
+
+    const uint32 slot = m_writePointer;
+    m_filteredTimestamps[slot] = filteredTimestamp;
+    m_unfilteredTimestamps[slot] = unfilteredTimestamp;
+    m_indices[slot] = frameNumber;
+    m_poses[slot] = pose;
+    m_status[slot] = static_cast<uint8>(toolStatus);
+
+    m_writePointer = (m_writePointer + 1) % m_bufferSize;
+    m_numberOfItems = (std::min)(m_numberOfItems + 1, m_bufferSize);
+    ++m_latestItemUid;
+
+    if (m_history != nullptr && !m_history->AddSample(filteredTimestamp, m_latestItemUid, pose, toolStatus))
+    {
+      // The item stays in the buffer, the history continues with a new block from the next item
+      OutputDebugStringA("PoseBuffer: Failed to add item to the history, its timestamp is too close to the previous one.");
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  StreamBufferItem^ PoseBuffer::GetStreamBufferItemFromTime(float time, int interpolation)
+  {
+    PoseBufferSample sample;
+    float localTimeOffsetSec(0.f);
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      localTimeOffsetSec = m_localTimeOffsetSec;
+      if (EvaluatePose(time - m_localTimeOffsetSec, (DATA_ITEM_TEMPORAL_INTERPOLATION)interpolation, sample) != ITEM_OK)
+      {
+        std::stringstream ss;
+        ss << "PoseBuffer: Cannot get an item for time: " << std::fixed << time;
+        OutputDebugStringA(ss.str().c_str());
+        return nullptr;
+      }
+    }
+
+    StreamBufferItem^ item = ref new StreamBufferItem();
+    item->SetUid(sample.Uid);
+    item->SetIndex(sample.Index);
+    item->SetFilteredTimestamp(sample.FilteredTimestamp);
+    item->SetUnfilteredTimestamp(sample.UnfilteredTimestamp);
+    item->SetMatrixInternal(sample.Matrix, sample.Pose.Rotation, sample.Pose.Translation, sample.Pose.Scale);
+    item->SetStatus(sample.Status);
+    return item;
+  }
+
+  //----------------------------------------------------------------------------
+  int PoseBuffer::GetMatrixFromTime(float time, int interpolation, float4x4* outMatrix, int* outToolStatus)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    PoseBufferSample sample;
+    ItemStatus status = EvaluatePose(time - m_localTimeOffsetSec, (DATA_ITEM_TEMPORAL_INTERPOLATION)interpolation, sample);
+    if (status == ITEM_OK)
+    {
+      *outMatrix = sample.Matrix;
+      *outToolStatus = sample.Status;
+    }
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 PoseBuffer::GetInterpolatedMatrices(const Platform::Array<float>^ times, Platform::WriteOnlyArray<float4x4>^ outMatrices, Platform::WriteOnlyArray<int>^ outToolStatus)
+  {
+    if (times == nullptr || outMatrices == nullptr || outToolStatus == nullptr || outMatrices->Length != times->Length || outToolStatus->Length != times->Length)
+    {
+      OutputDebugStringA("PoseBuffer: Cannot interpolate matrices, the output arrays must have the same length as the times.");
+      return 0;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    uint32 numberOfValidMatrices(0);
+    PoseBufferSample sample;
+    for (uint32 i = 0; i < times->Length; ++i)
+    {
+      if (EvaluatePose(times[i] - m_localTimeOffsetSec, INTERPOLATED, sample) == ITEM_OK && sample.Status == TOOL_OK)
+      {
+        outMatrices[i] = sample.Matrix;
+        outToolStatus[i] = TOOL_OK;
+        ++numberOfValidMatrices;
+      }
+      else
+      {
+        outMatrices[i] = float4x4::identity();
+        outToolStatus[i] = TOOL_MISSING;
+      }
+    }
+    return numberOfValidMatrices;
+  }
+
+  //----------------------------------------------------------------------------
+  BufferItemUidType PoseBuffer::GetOldestItemUidInBuffer()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_latestItemUid - m_numberOfItems + 1;
+  }
+
+  //----------------------------------------------------------------------------
+  BufferItemUidType PoseBuffer::GetLatestItemUidInBuffer()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_latestItemUid;
+  }
+
+  //----------------------------------------------------------------------------
+  int PoseBuffer::GetItemUidFromTime(float time, BufferItemUidType* outUid)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    uint32 position(0);
+    ItemStatus status = FindClosestPosition(time - m_localTimeOffsetSec, position);
+    if (status == ITEM_OK)
+    {
+      *outUid = m_latestItemUid - m_numberOfItems + 1 + position;
+    }
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  int PoseBuffer::GetLatestTimeStamp(float* outLatestTimestamp)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_numberOfItems == 0)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    *outLatestTimestamp = m_filteredTimestamps[GetSlot(m_numberOfItems - 1)] + m_localTimeOffsetSec;
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  int PoseBuffer::GetOldestTimeStamp(float* outOldestTimestamp)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_numberOfItems == 0)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    *outOldestTimestamp = m_filteredTimestamps[GetSlot(0)] + m_localTimeOffsetSec;
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  int PoseBuffer::GetTimeStamp(BufferItemUidType uid, float* outTimestamp)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    uint32 position(0);
+    ItemStatus status = GetPositionFromUid(uid, position);
+    if (status == ITEM_OK)
+    {
+      *outTimestamp = m_filteredTimestamps[GetSlot(position)] + m_localTimeOffsetSec;
+    }
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  int PoseBuffer::GetIndex(BufferItemUidType uid, uint32* outIndex)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    uint32 position(0);
+    ItemStatus status = GetPositionFromUid(uid, position);
+    if (status == ITEM_OK)
+    {
+      *outIndex = m_indices[GetSlot(position)];
+    }
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  void PoseBuffer::SetLocalTimeOffsetSec(float offsetSec)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_localTimeOffsetSec = offsetSec;
+  }
+
+  //----------------------------------------------------------------------------
+  float PoseBuffer::GetLocalTimeOffsetSec()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_localTimeOffsetSec;
+  }
+
+  //----------------------------------------------------------------------------
+  void PoseBuffer::SetMaxAllowedTimeDifference(float maxAllowedTimeDifference)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_maxAllowedTimeDifference = maxAllowedTimeDifference;
+  }
+
+  //----------------------------------------------------------------------------
+  float PoseBuffer::GetMaxAllowedTimeDifference()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_maxAllowedTimeDifference;
+  }
+
+  //----------------------------------------------------------------------------
+  bool PoseBuffer::EnableCompactHistory(float translationResolution)
+  {
+    if (translationResolution <= 0.f)
+    {
+      OutputDebugStringA("PoseBuffer: Cannot enable the history, the translation resolution must be positive.");
+      return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_history = std::make_unique<CompactPoseHistory>(translationResolution);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void PoseBuffer::DisableCompactHistory()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_history = nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  bool PoseBuffer::IsCompactHistoryEnabled()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_history != nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 PoseBuffer::GetNumberOfHistoryItems()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_history == nullptr ? 0 : m_history->GetNumberOfSamples();
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 PoseBuffer::GetHistoryMemoryUsageBytes()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_history == nullptr ? 0 : m_history->GetMemoryUsageBytes();
+  }
+
+  //----------------------------------------------------------------------------
+  void PoseBuffer::Clear()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_numberOfItems = 0;
+    m_writePointer = 0;
+    if (m_history != nullptr)
+    {
+      m_history->Clear();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 PoseBuffer::GetSlot(uint32 position)
+  {
+    uint32 slot = m_writePointer + m_bufferSize - m_numberOfItems + position;
+    return (slot >= m_bufferSize) ? slot - m_bufferSize : slot;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus PoseBuffer::GetPositionFromUid(BufferItemUidType uid, uint32& outPosition)
+  {
+    // the caller must have locked the buffer
+    if (m_numberOfItems == 0 || uid > m_latestItemUid)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    const BufferItemUidType oldestUid = m_latestItemUid - m_numberOfItems + 1;
+    if (uid < oldestUid)
+    {
+      return ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    outPosition = static_cast<uint32>(uid - oldestUid);
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus PoseBuffer::FindClosestPosition(float localTime, uint32& outPosition)
+  {
+    // the caller must have locked the buffer
+    if (m_numberOfItems == 0)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+
+    // If the timestamp is slightly out of range then still accept it
+    if (localTime < m_filteredTimestamps[GetSlot(0)] - NEGLIGIBLE_TIME_DIFFERENCE)
+    {
+      return ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    if (localTime > m_filteredTimestamps[GetSlot(m_numberOfItems - 1)] + NEGLIGIBLE_TIME_DIFFERENCE)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+
+    // First item later than the requested time
+    uint32 first(0);
+    uint32 count(m_numberOfItems);
+    while (count > 0)
+    {
+      uint32 step = count / 2;
+      if (m_filteredTimestamps[GetSlot(first + step)] <= localTime)
+      {
+        first += step + 1;
+        count -= step + 1;
+      }
+      else
+      {
+        count = step;
+      }
+    }
+
+    if (first == 0)
+    {
+      outPosition = 0;
+    }
+    else if (first == m_numberOfItems)
+    {
+      outPosition = m_numberOfItems - 1;
+    }
+    else
+    {
+      const bool laterIsClosest = m_filteredTimestamps[GetSlot(first)] - localTime < localTime - m_filteredTimestamps[GetSlot(first - 1)];
+      outPosition = laterIsClosest ? first : first - 1;
+    }
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus PoseBuffer::EvaluatePose(float localTime, DATA_ITEM_TEMPORAL_INTERPOLATION interpolation, PoseBufferSample& outSample)
+  {
+    // the caller must have locked the buffer
+    if (m_history != nullptr && m_numberOfItems > 0 && localTime < m_filteredTimestamps[GetSlot(0)])
+    {
+      // Older than the buffer, only available from the history (the history has the oldest item of the buffer as well)
+      return m_history->EvaluatePose(localTime, interpolation, m_maxAllowedTimeDifference, outSample);
+    }
+
+    uint32 positionA(0);
+    ItemStatus status = FindClosestPosition(localTime, positionA);
+    if (status != ITEM_OK)
+    {
+      return status;
+    }
+
+    const uint32 slotA = GetSlot(positionA);
+    const float timeA = m_filteredTimestamps[slotA];
+    outSample.Uid = m_latestItemUid - m_numberOfItems + 1 + positionA;
+    outSample.Index = m_indices[slotA];
+    outSample.FilteredTimestamp = timeA;
+    outSample.UnfilteredTimestamp = m_unfilteredTimestamps[slotA];
+    outSample.Pose = m_poses[slotA];
+    outSample.Status = static_cast<TOOL_STATUS>(m_status[slotA]);
+
+    if (fabs(timeA - localTime) < NEGLIGIBLE_TIME_DIFFERENCE || interpolation == CLOSEST_TIME)
+    {
+      outSample.Matrix = ComposeMatrix(outSample.Pose.Scale, outSample.Pose.Rotation, outSample.Pose.Translation);
+      return ITEM_OK;
+    }
+    if (interpolation != INTERPOLATED && interpolation != EXTRAPOLATED)
+    {
+      // No item exactly at the requested time
+      return ITEM_UNKNOWN_ERROR;
+    }
+
+    // Same rules as Buffer: if the interpolation is not possible the closest pose is returned with TOOL_MISSING status
+    outSample.FilteredTimestamp = localTime;
+    outSample.UnfilteredTimestamp = localTime;
+    outSample.Status = TOOL_MISSING;
+    outSample.Matrix = ComposeMatrix(outSample.Pose.Scale, outSample.Pose.Rotation, outSample.Pose.Translation);
+
+    const bool itemBisOlder = localTime < timeA;
+    if (m_status[slotA] != TOOL_OK || fabs(timeA - localTime) > m_maxAllowedTimeDifference ||
+        (itemBisOlder && positionA == 0) || (!itemBisOlder && positionA + 1 >= m_numberOfItems))
+    {
+      return ITEM_OK;
+    }
+    const uint32 slotB = GetSlot(itemBisOlder ? positionA - 1 : positionA + 1);
+    const float timeB = m_filteredTimestamps[slotB];
+    if (m_status[slotB] != TOOL_OK || fabs(timeB - localTime) > m_maxAllowedTimeDifference)
+    {
+      return ITEM_OK;
+    }
+
+    const float itemBweight = (localTime - timeA) / (timeB - timeA);
+    const ToolPose& poseA = m_poses[slotA];
+    const ToolPose& poseB = m_poses[slotB];
+    outSample.Matrix = InterpolateDecomposedMatrix(poseA.Scale, poseA.Rotation, poseA.Translation, poseB.Scale, poseB.Rotation, poseB.Translation, itemBweight,
+                       outSample.Pose.Scale, outSample.Pose.Rotation, outSample.Pose.Translation);
+    outSample.UnfilteredTimestamp = m_unfilteredTimestamps[slotA] * (1.f - itemBweight) + m_unfilteredTimestamps[slotB] * itemBweight;
+    outSample.Status = TOOL_OK;
+    return ITEM_OK;
+  }
+}
@@ -0,0 +1,160 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+// Local includes
+#include "CompactPoseHistory.h"
+#include "IGTCommon.h"
+#include "StreamBufferItem.h"
+#include "TimestampedCircularBuffer.h"
+
+// STL includes
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    Circular buffer of tracker poses without video or custom fields (e.g. a single tool of a high rate tracker).
+    Instead of a StreamBufferItem per slot the samples are stored in contiguous arrays (timestamps, frame indices,
+    decomposed poses, status), 53 bytes per sample, and the temporal search only touches the timestamp array.
+    The temporal queries follow the same rules as the corresponding Buffer methods.
+  */
+  public ref class PoseBuffer sealed
+  {
+  public:
+    PoseBuffer();
+    virtual ~PoseBuffer();
+
+    /*! Set the maximum number of items in the buffer, removes all items */
+    bool SetBufferSize(uint32 numberOfItems);
+    /*! Get the maximum number of items in the buffer */
+    uint32 GetBufferSize();
+    /*! Get the number of items in the buffer */
+    uint32 GetNumberOfItems();
+
+    /*!
+    Add a matrix plus status to the buffer, see Buffer::AddTimeStampedItem.
+    If filteredTimestamp is UNDEFINED_TIMESTAMP then the unfiltered timestamp is used.
+    If the timestamp is not later than the latest item then nothing is added.
+    */
+    bool AddTimeStampedItem(Windows::Foundation::Numerics::float4x4 matrix, int toolStatus, uint32 frameNumber, float unfilteredTimestamp, float filteredTimestamp);
+
+    /*! Get the item at the specified time, see Buffer::GetStreamBufferItemFromTime (EXTRAPOLATED is handled as INTERPOLATED) */
+    StreamBufferItem^ GetStreamBufferItemFromTime(float time, int interpolation);
+
+    /*!
+    Get the matrix at the specified time without creating an item, see GetStreamBufferItemFromTime.
+    \return ITEM_OK, ITEM_NOT_AVAILABLE_YET, ITEM_NOT_AVAILABLE_ANYMORE or ITEM_UNKNOWN_ERROR (no item exactly at the requested time)
+    */
+    int GetMatrixFromTime(float time, int interpolation, Windows::Foundation::Numerics::float4x4* outMatrix, int* outToolStatus);
+
+    /*!
+    Interpolate the matrix for each of the requested times, see Buffer::GetInterpolatedMatrices.
+    \return the number of elements with TOOL_OK status
+    */
+    uint32 GetInterpolatedMatrices(const Platform::Array<float>^ times,
+                                   Platform::WriteOnlyArray<Windows::Foundation::Numerics::float4x4>^ outMatrices,
+                                   Platform::WriteOnlyArray<int>^ outToolStatus);
+
+    /*! Get buffer item unique IDs */
+    BufferItemUidType GetOldestItemUidInBuffer();
+    BufferItemUidType GetLatestItemUidInBuffer();
+    int GetItemUidFromTime(float time, BufferItemUidType* outUid);
+
+    /*! Get latest timestamp in the buffer */
+    int GetLatestTimeStamp(float* outLatestTimestamp);
+    /*! Get oldest timestamp in the buffer */
+    int GetOldestTimeStamp(float* outOldestTimestamp);
+    /*! Get buffer item timestamp */
+    int GetTimeStamp(BufferItemUidType uid, float* outTimestamp);
+    /*! Get the index assigned by the data acquisition system (usually a counter) by item UID */
+    int GetIndex(BufferItemUidType uid, uint32* outIndex);
+
+    /*! Set the local time offset in seconds (global = local + offset) */
+    void SetLocalTimeOffsetSec(float offsetSec);
+    /*! Get the local time offset in seconds (global = local + offset) */
+    float GetLocalTimeOffsetSec();
+
+    /*! Set maximum allowed time difference in seconds between the desired and the closest valid timestamp */
+    void SetMaxAllowedTimeDifference(float maxAllowedTimeDifference);
+    /*! Get maximum allowed time difference in seconds between the desired and the closest valid timestamp */
+    float GetMaxAllowedTimeDifference();
+
+    /*!
+    Keep every added item in a quantised history (about 13 bytes per item, see CompactPoseHistory for the error bounds),
+    so poses older than the buffer remain available to the temporal queries for long recordings.
+    translationResolution is the translation quantisation step in the units of the matrices (e.g. 0.02 mm).
+    The frame index of items served from the history is 0 and their uid counts from the item added first after enabling.
+    */
+    bool EnableCompactHistory(float translationResolution);
+    /*! Discard the history */
+    void DisableCompactHistory();
+    /*! Returns true if added items are kept in the history */
+    bool IsCompactHistoryEnabled();
+    /*! Get the number of items in the history */
+    uint64 GetNumberOfHistoryItems();
+    /*! Get the memory used by the history in bytes */
+    uint64 GetHistoryMemoryUsageBytes();
+
+    /*! Remove all items, including the history */
+    void Clear();
+
+  protected private:
+    /// Physical slot of the i-th oldest item
+    uint32 GetSlot(uint32 position);
+    /// Position (0 = oldest) of an item, caller must hold m_mutex
+    ItemStatus GetPositionFromUid(BufferItemUidType uid, uint32& outPosition);
+    /// Position of the item closest to the local time, caller must hold m_mutex
+    ItemStatus FindClosestPosition(float localTime, uint32& outPosition);
+    /*!
+      Evaluate the pose at the local time, caller must hold m_mutex.
+      The uid and index are those of the closest item, the pose, status and timestamps those of the (possibly interpolated) result.
+    */
+    ItemStatus EvaluatePose(float localTime, DATA_ITEM_TEMPORAL_INTERPOLATION interpolation, PoseBufferSample& outSample);
+
+  protected private:
+    std::mutex              m_mutex;
+    uint32                  m_bufferSize = 0;
+    uint32                  m_numberOfItems = 0;
+    uint32                  m_writePointer = 0;
+    BufferItemUidType       m_latestItemUid = 0;
+    float                   m_localTimeOffsetSec = 0.f;
+    float                   m_maxAllowedTimeDifference = 0.5f;
+
+    // One element per slot
+    std::vector<float>      m_filteredTimestamps;
+    std::vector<float>      m_unfilteredTimestamps;
+    std::vector<uint32>     m_indices;
+    std::vector<ToolPose>   m_poses;
+    std::vector<uint8>      m_status;
+
+    // All items added since the history was enabled, nullptr if it is disabled
+    std::unique_ptr<CompactPoseHistory> m_history;
+  };
+}
@@ -38,7 +38,11 @@ namespace UWPOpenIGTLink
     , m_uid(0)
     , m_validTransformData(false)
     , m_matrix(float4x4::identity())
+    , m_rotation(quaternion::identity())
+    , m_translation(float3::zero())
+    , m_scale(float3::one())
     , m_status(TOOL_OK)
+    , m_pinCount(0)
   {
   }
 
@@ -50,11 +54,21 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   void StreamBufferItem::SetCustomFrameField(Platform::String^ fieldName, Platform::String^ fieldValue)
   {
-    m_customFrameFields[std::wstring(fieldName->Data())] = std::wstring(fieldValue->Data());
+    if (fieldName == nullptr || fieldValue == nullptr)
+    {
+      return;
+    }
+    m_customFrameFields.Set(FrameFieldNameTable::Instance().Intern(fieldName->Data(), fieldName->Length()), fieldValue->Data(), fieldValue->Length());
   }
 
   //----------------------------------------------------------------------------
   bool StreamBufferItem::DeepCopy(StreamBufferItem^ dataItem)
+  {
+    return DeepCopyInternal(dataItem, true);
+  }
+
+  //----------------------------------------------------------------------------
+  bool StreamBufferItem::DeepCopyInternal(StreamBufferItem^ dataItem, bool copyFrame)
   {
     if (dataItem == nullptr)
     {
@@ -68,13 +82,57 @@ namespace UWPOpenIGTLink
     m_uid = dataItem->m_uid;
     m_validTransformData = dataItem->m_validTransformData;
     m_matrix = dataItem->m_matrix;
+    m_rotation = dataItem->m_rotation;
+    m_translation = dataItem->m_translation;
+    m_scale = dataItem->m_scale;
     m_status = dataItem->m_status;
 
-    m_frame->DeepCopy(dataItem->m_frame);
+    if (copyFrame)
+    {
+      m_frame->DeepCopy(dataItem->m_frame);
+    }
 
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  bool StreamBufferItem::ShallowCopyInternal(StreamBufferItem^ dataItem, bool copyFields)
+  {
+    if (!DeepCopyInternal(dataItem, false))
+    {
+      return false;
+    }
+
+    if (dataItem->m_frame->HasImage())
+    {
+      m_frame->ShallowCopy(dataItem->m_frame->GetImage(), dataItem->m_frame->GetImageOrientation(), dataItem->m_frame->GetImageType());
+    }
+    if (copyFields)
+    {
+      m_customFrameFields = dataItem->m_customFrameFields;
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void StreamBufferItem::PinInternal()
+  {
+    m_pinCount.fetch_add(1, std::memory_order_acquire);
+  }
+
+  //----------------------------------------------------------------------------
+  void StreamBufferItem::UnpinInternal()
+  {
+    m_pinCount.fetch_sub(1, std::memory_order_release);
+  }
+
+  //----------------------------------------------------------------------------
+  bool StreamBufferItem::IsPinnedInternal() const
+  {
+    return m_pinCount.load(std::memory_order_acquire) > 0;
+  }
+
   //----------------------------------------------------------------------------
   bool StreamBufferItem::SetMatrix(float4x4 matrix)
   {
@@ -82,15 +140,47 @@ namespace UWPOpenIGTLink
 
     m_matrix = matrix;
 
+    // Decompose once here instead of on every interpolated query
+    DecomposeMatrix(matrix, m_scale, m_rotation, m_translation);
+
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  void StreamBufferItem::SetMatrixInternal(const float4x4& matrix, const quaternion& rotation, const float3& translation, const float3& scale)
+  {
+    m_validTransformData = true;
+
+    m_matrix = matrix;
+    m_rotation = rotation;
+    m_translation = translation;
+    m_scale = scale;
+  }
+
   //----------------------------------------------------------------------------
   float4x4 StreamBufferItem::GetMatrix()
   {
     return m_matrix;
   }
 
+  //----------------------------------------------------------------------------
+  quaternion StreamBufferItem::GetRotation()
+  {
+    return m_rotation;
+  }
+
+  //----------------------------------------------------------------------------
+  float3 StreamBufferItem::GetTranslation()
+  {
+    return m_translation;
+  }
+
+  //----------------------------------------------------------------------------
+  float3 StreamBufferItem::GetScale()
+  {
+    return m_scale;
+  }
+
   //----------------------------------------------------------------------------
   void StreamBufferItem::SetStatus(int status)
   {
@@ -106,7 +196,7 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   bool StreamBufferItem::HasValidFieldData()
   {
-    return m_customFrameFields.size() > 0;
+    return !m_customFrameFields.Empty();
   }
 
   //----------------------------------------------------------------------------
@@ -171,11 +261,11 @@ namespace UWPOpenIGTLink
       return nullptr;
     }
 
-    FrameFields::iterator fieldIterator;
-    fieldIterator = m_customFrameFields.find(std::wstring(fieldName->Data()));
-    if (fieldIterator != m_customFrameFields.end())
+    const wchar_t* value(nullptr);
+    uint32 length(0);
+    if (m_customFrameFields.Get(FrameFieldNameTable::Instance().Find(fieldName->Data(), fieldName->Length()), value, length))
     {
-      return ref new Platform::String(fieldIterator->second.c_str());
+      return ref new Platform::String(value, length);
     }
     return nullptr;
   }
@@ -188,13 +278,7 @@ namespace UWPOpenIGTLink
       return false;
     }
 
-    FrameFields::iterator field = m_customFrameFields.find(std::wstring(fieldName->Data()));
-    if (field != m_customFrameFields.end())
-    {
-      m_customFrameFields.erase(field);
-      return true;
-    }
-    return false;
+    return m_customFrameFields.Erase(FrameFieldNameTable::Instance().Find(fieldName->Data(), fieldName->Length()));
   }
 
   //----------------------------------------------------------------------------
@@ -212,13 +296,40 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   FrameFields StreamBufferItem::GetCustomFrameFields()
   {
-    return m_customFrameFields;
+    return m_customFrameFields.ToFrameFields();
   }
 
   //----------------------------------------------------------------------------
   void StreamBufferItem::SetCustomFrameFieldInternal(const std::wstring& fieldName, const std::wstring& fieldValue)
   {
-    m_customFrameFields[fieldName] = fieldValue;
+    m_customFrameFields.Set(FrameFieldNameTable::Instance().Intern(fieldName.c_str(), static_cast<uint32>(fieldName.size())), fieldValue.c_str(), static_cast<uint32>(fieldValue.size()));
+  }
+
+  //----------------------------------------------------------------------------
+  bool StreamBufferItem::SetCustomFrameFieldsInternal(FrameFieldsABI^ fields)
+  {
+    if (fields == nullptr)
+    {
+      return false;
+    }
+
+    FrameFieldNameTable& nameTable = FrameFieldNameTable::Instance();
+    bool hasTransformField(false);
+    for (auto field : fields)
+    {
+      Platform::String^ fieldName = field->Key;
+      Platform::String^ fieldValue = field->Value;
+      FrameFieldId id = nameTable.Intern(fieldName->Data(), fieldName->Length());
+      m_customFrameFields.Set(id, fieldValue == nullptr ? nullptr : fieldValue->Data(), fieldValue == nullptr ? 0 : fieldValue->Length());
+      hasTransformField = hasTransformField || nameTable.IsTransformField(id);
+    }
+    return hasTransformField;
+  }
+
+  //----------------------------------------------------------------------------
+  void StreamBufferItem::ClearCustomFrameFieldsInternal()
+  {
+    m_customFrameFields.Clear();
   }
 
   //----------------------------------------------------------------------------
@@ -27,10 +27,12 @@ OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 // Local includes
+#include "FrameFieldStore.h"
 #include "IGTCommon.h"
 #include "VideoFrame.h"
 
 // STL includes
+#include <atomic>
 #include <map>
 #include <vector>
 
@@ -83,6 +85,11 @@ namespace UWPOpenIGTLink
     bool SetMatrix(Windows::Foundation::Numerics::float4x4 matrix);
     Windows::Foundation::Numerics::float4x4 GetMatrix();
 
+    /*! Rotation, translation and scale of the matrix, decomposed once when the matrix is set */
+    Windows::Foundation::Numerics::quaternion GetRotation();
+    Windows::Foundation::Numerics::float3 GetTranslation();
+    Windows::Foundation::Numerics::float3 GetScale();
+
     void SetStatus(int status);
     int GetStatus();
 
@@ -97,16 +104,38 @@ namespace UWPOpenIGTLink
     FrameFields GetCustomFrameFields();
     /*! Set custom frame field */
     void SetCustomFrameFieldInternal(const std::wstring& fieldName, const std::wstring& fieldValue);
+    /*! Set all fields of the map, returns true if one of them carries transform data (its name contains "Transform") */
+    bool SetCustomFrameFieldsInternal(FrameFieldsABI^ fields);
+    /*! Remove all custom frame fields, the field storage is kept for the next item of the buffer slot */
+    void ClearCustomFrameFieldsInternal();
+    /*! Copy the item, the video frame is only copied if copyFrame is true (not needed for transform only items) */
+    bool DeepCopyInternal(StreamBufferItem^ dataItem, bool copyFrame);
+    /*! Copy the item sharing its image instead of copying the pixels, the custom fields are only copied if copyFields is true */
+    bool ShallowCopyInternal(StreamBufferItem^ dataItem, bool copyFields);
+    /*!
+      Pins of readers that use the item without holding the buffer lock (see TimestampedCircularBuffer::PinItemInternal).
+      The buffer never modifies a pinned item, it gives the slot a new item instead.
+    */
+    void PinInternal();
+    void UnpinInternal();
+    bool IsPinnedInternal() const;
+    /*! Set the matrix together with its already known decomposition */
+    void SetMatrixInternal(const Windows::Foundation::Numerics::float4x4& matrix, const Windows::Foundation::Numerics::quaternion& rotation,
+                           const Windows::Foundation::Numerics::float3& translation, const Windows::Foundation::Numerics::float3& scale);
 
   protected private:
     float                                     m_filteredTimeStamp;
     float                                     m_unfilteredTimeStamp;
     uint32                                    m_index;
     BufferItemUidType                         m_uid;
-    FrameFields                               m_customFrameFields;
+    FrameFieldStore                           m_customFrameFields;
     bool                                      m_validTransformData;
     VideoFrame^                               m_frame = ref new VideoFrame();
     Windows::Foundation::Numerics::float4x4   m_matrix;
+    Windows::Foundation::Numerics::quaternion m_rotation;
+    Windows::Foundation::Numerics::float3     m_translation;
+    Windows::Foundation::Numerics::float3     m_scale;
     TOOL_STATUS                               m_status;
+    std::atomic<uint32>                       m_pinCount;
   };
 }
\ No newline at end of file
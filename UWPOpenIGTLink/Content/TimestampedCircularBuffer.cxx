@@ -29,12 +29,65 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 // STL includes
 #include <stdexcept>
+#include <thread>
 
 namespace UWPOpenIGTLink
 {
+  namespace
+  {
+    //----------------------------------------------------------------------------
+    void ThrowOnItemStatus(ItemStatus status)
+    {
+      switch (status)
+      {
+        case ITEM_NOT_AVAILABLE_YET:
+          throw UWPOpenIGTLink::ItemNotAvailableYetException();
+        case ITEM_NOT_AVAILABLE_ANYMORE:
+          throw UWPOpenIGTLink::ItemNotAvailableAnymoreException();
+        default:
+          break;
+      }
+    }
+
+    /// Registers a reader of the slot records for its lifetime, the writer only frees retired records when there is none
+    class SlotRecordsReader
+    {
+    public:
+      explicit SlotRecordsReader(std::atomic<uint32>& readers)
+        : m_readers(readers)
+      {
+        m_readers.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in ReclaimSlotRecords: either the writer sees this reader, or this reader sees the current records
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+      }
+
+      ~SlotRecordsReader()
+      {
+        m_readers.fetch_sub(1, std::memory_order_release);
+      }
+
+    private:
+      std::atomic<uint32>& m_readers;
+    };
+  }
+
+  //----------------------------------------------------------------------------
+  BufferSlotIndex::BufferSlotIndex(BufferItemList::size_type size)
+    : Size(size)
+    , Sequence(new std::atomic<uint32>[size]())
+    , Uid(new BufferItemUidType[size]())
+    , FilteredTimestamp(new float[size]())
+    , UnfilteredTimestamp(new float[size]())
+    , Index(new uint32[size]())
+    , Period(new float[size]())
+    , IndexGap(new uint32[size]())
+  {
+  }
+
   //----------------------------------------------------------------------------
   TimestampedCircularBuffer::TimestampedCircularBuffer()
-    : m_writePointer(0)
+    : m_numberOfItems(0)
+    , m_writePointer(0)
     , m_currentTimeStamp(0.f)
     , m_localTimeOffsetSec(0.f)
     , m_latestItemUid(0)
@@ -42,12 +95,18 @@ namespace UWPOpenIGTLink
     , m_maxAllowedFilteringTimeDifference(0.5f)
     , m_startTime(0.f)
     , m_negligibleTimeDifferenceSec(0.00001f)
+    , m_stateSequence(0)
+    , m_slotRecordReaders(0)
   {
     m_bufferItemContainer.resize(0);
     m_filterContainerIndexVector.resize(0);
     m_filterContainerTimestampVector.resize(0);
     m_filterContainersOldestIndex = 0;
     m_filterContainersNumberOfValidElements = 0;
+    m_filterSumX = m_filterSumY = m_filterSumXX = m_filterSumXY = 0.0;
+    m_filterReferenceX = m_filterReferenceY = 0.0;
+    m_filterItemsSinceRebase = 0;
+    RebuildSlotRecords();
   }
 
   //----------------------------------------------------------------------------
@@ -71,11 +130,66 @@ namespace UWPOpenIGTLink
       return false;
     }
 
+    if (GetBufferSize() == 0)
+    {
+      OutputDebugStringA("Need to skip newly added frame - buffer has no storage allocated!");
+      return false;
+    }
+
+    // When the buffer is full the slot we are about to overwrite holds the oldest item, hide it from readers first
+    if (m_numberOfItems == GetBufferSize())
+    {
+      // The second oldest item becomes the oldest one, its period to the overwritten item leaves the statistics
+      if (GetBufferSize() > 1)
+      {
+        AccumulateFramePeriod((m_writePointer + 1) % GetBufferSize(), -1);
+      }
+      PublishState(m_numberOfItems - 1);
+    }
+
+    BufferSlotIndex& slots = *m_slotRecords.back();
+    m_pendingItem.Active = true;
+    m_pendingItem.BufferIndex = m_writePointer;
+    m_pendingItem.Uid = slots.Uid[m_writePointer];
+    m_pendingItem.FilteredTimestamp = slots.FilteredTimestamp[m_writePointer];
+    m_pendingItem.Period = slots.Period[m_writePointer];
+    m_pendingItem.IndexGap = slots.IndexGap[m_writePointer];
+    m_pendingItem.CurrentTimeStamp = m_currentTimeStamp;
+    m_pendingItem.NumberOfItems = m_numberOfItems;
+    m_pendingItem.PinnedItem = nullptr;
+
     // Increase frame unique ID
     *newFrameUid = ++m_latestItemUid;
     *bufferIndex = m_writePointer;
     m_currentTimeStamp = timestamp;
 
+    // A pinned item must not change until its readers unpin it, so leave it to them and give the slot a new item
+    StreamBufferItem^ overwrittenItem = m_bufferItemContainer[m_writePointer];
+    if (overwrittenItem != nullptr && overwrittenItem->IsPinnedInternal())
+    {
+      m_pendingItem.PinnedItem = overwrittenItem;
+      StreamBufferItem^ newItem = ref new StreamBufferItem();
+      VideoFrame^ pinnedFrame = overwrittenItem->GetFrame();
+      if (pinnedFrame->HasImage())
+      {
+        newItem->GetFrame()->ShallowCopy(pinnedFrame->GetImage(), pinnedFrame->GetImageOrientation(), pinnedFrame->GetImageType());
+      }
+      m_bufferItemContainer[m_writePointer] = newItem;
+    }
+    else if (overwrittenItem != nullptr)
+    {
+      // The fields of the overwritten item must not show up in the new one, their storage is reused
+      overwrittenItem->ClearCustomFrameFieldsInternal();
+    }
+
+    // Mark the slot as being written, readers still holding an older state will notice the sequence change
+    slots.Sequence[m_writePointer].store(slots.Sequence[m_writePointer].load(std::memory_order_relaxed) | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slots.Uid[m_writePointer] = m_latestItemUid;
+    slots.FilteredTimestamp[m_writePointer] = timestamp;
+    slots.Period[m_writePointer] = 0.f;
+    slots.IndexGap[m_writePointer] = 0;
+
     m_numberOfItems++;
     if (m_numberOfItems > GetBufferSize())
     {
@@ -91,6 +205,298 @@ namespace UWPOpenIGTLink
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::CommitNewItem(BufferItemList::size_type bufferIndex)
+  {
+    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
+
+    if (bufferIndex >= GetBufferSize())
+    {
+      return;
+    }
+
+    BufferSlotIndex& slots = *m_slotRecords.back();
+    StreamBufferItem^ item = m_bufferItemContainer[bufferIndex];
+    if (item != nullptr)
+    {
+      slots.UnfilteredTimestamp[bufferIndex] = item->GetUnfilteredTimestamp(0.f);
+      slots.Index[bufferIndex] = item->GetIndex();
+    }
+
+    // The new item adds its period to the previous item to the frame statistics
+    if (m_numberOfItems > 1)
+    {
+      BufferItemList::size_type previousIndex = (bufferIndex + GetBufferSize() - 1) % GetBufferSize();
+      slots.Period[bufferIndex] = slots.FilteredTimestamp[bufferIndex] - slots.FilteredTimestamp[previousIndex];
+      slots.IndexGap[bufferIndex] = slots.Index[bufferIndex] - slots.Index[previousIndex];
+      AccumulateFramePeriod(bufferIndex, 1);
+    }
+
+    slots.Sequence[bufferIndex].store(slots.Sequence[bufferIndex].load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    m_pendingItem = BufferPendingItem();
+    PublishState(m_numberOfItems);
+    ReclaimSlotRecords();
+  }
+
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::AbortNewItem(BufferItemList::size_type bufferIndex)
+  {
+    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
+
+    if (!m_pendingItem.Active || m_pendingItem.BufferIndex != bufferIndex || bufferIndex >= GetBufferSize())
+    {
+      return;
+    }
+
+    BufferSlotIndex& slots = *m_slotRecords.back();
+    slots.Uid[bufferIndex] = m_pendingItem.Uid;
+    slots.FilteredTimestamp[bufferIndex] = m_pendingItem.FilteredTimestamp;
+    slots.Period[bufferIndex] = m_pendingItem.Period;
+    slots.IndexGap[bufferIndex] = m_pendingItem.IndexGap;
+    if (m_pendingItem.PinnedItem != nullptr)
+    {
+      m_bufferItemContainer[bufferIndex] = m_pendingItem.PinnedItem;
+    }
+
+    m_latestItemUid--;
+    m_currentTimeStamp = m_pendingItem.CurrentTimeStamp;
+    m_numberOfItems = m_pendingItem.NumberOfItems;
+    m_writePointer = bufferIndex;
+
+    slots.Sequence[bufferIndex].store(slots.Sequence[bufferIndex].load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    // Failed adds are rare, the overwritten item is simply counted again
+    m_pendingItem = BufferPendingItem();
+    RecomputeFrameStatistics();
+    PublishState(m_numberOfItems);
+  }
+
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::PublishState(BufferItemList::size_type numberOfItems)
+  {
+    // the caller must have locked the buffer
+    uint32 sequence = m_stateSequence.load(std::memory_order_relaxed);
+    m_stateSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_publishedState.Slots = m_slotRecords.back().get();
+    m_publishedState.BufferSize = GetBufferSize();
+    m_publishedState.NumberOfItems = numberOfItems;
+    m_publishedState.WritePointer = m_writePointer;
+    m_publishedState.LatestItemUid = m_latestItemUid;
+
+    // Only periods of items newer than the oldest item count
+    BufferItemUidType oldestUid = m_latestItemUid - (numberOfItems > 0 ? numberOfItems - 1 : 0);
+    while (!m_minimumPeriodQueue.empty() && m_minimumPeriodQueue.front().first <= oldestUid)
+    {
+      m_minimumPeriodQueue.pop_front();
+    }
+    while (!m_maximumPeriodQueue.empty() && m_maximumPeriodQueue.front().first <= oldestUid)
+    {
+      m_maximumPeriodQueue.pop_front();
+    }
+    m_frameStatistics.MinimumPeriod = m_minimumPeriodQueue.empty() ? 0.f : m_minimumPeriodQueue.front().second;
+    m_frameStatistics.MaximumPeriod = m_maximumPeriodQueue.empty() ? 0.f : m_maximumPeriodQueue.front().second;
+    m_publishedFrameStatistics = m_frameStatistics;
+
+    m_stateSequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::AccumulateFramePeriod(BufferItemList::size_type bufferIndex, int sign)
+  {
+    // the caller must have locked the buffer
+    BufferSlotIndex& slots = *m_slotRecords.back();
+    const double period = slots.Period[bufferIndex];
+    if (period <= 0.0)
+    {
+      // not part of the statistics
+      return;
+    }
+
+    const uint32 indexGap = slots.IndexGap[bufferIndex];
+    const double idealPeriod = (indexGap > 0) ? period / indexGap : period;
+
+    m_frameStatistics.NumberOfPeriods += sign;
+    m_frameStatistics.SumPeriod += sign * period;
+    m_frameStatistics.SumPeriodSquared += sign * period * period;
+    m_frameStatistics.SumIdealPeriod += sign * idealPeriod;
+    m_frameStatistics.SumIdealPeriodSquared += sign * idealPeriod * idealPeriod;
+    m_frameStatistics.NumberOfDroppedFrames += sign * static_cast<int64>(indexGap > 1 ? indexGap - 1 : 0);
+    m_frameStatistics.NumberOfInvalidFrameNumbers += sign * static_cast<int64>(indexGap == 0 ? 1 : 0);
+
+    if (sign > 0)
+    {
+      // Periods that can never be the minimum/maximum again are dropped from the back of the queues
+      const BufferItemUidType uid = slots.Uid[bufferIndex];
+      const float periodSec = slots.Period[bufferIndex];
+      while (!m_minimumPeriodQueue.empty() && m_minimumPeriodQueue.back().second >= periodSec)
+      {
+        m_minimumPeriodQueue.pop_back();
+      }
+      m_minimumPeriodQueue.emplace_back(uid, periodSec);
+      while (!m_maximumPeriodQueue.empty() && m_maximumPeriodQueue.back().second <= periodSec)
+      {
+        m_maximumPeriodQueue.pop_back();
+      }
+      m_maximumPeriodQueue.emplace_back(uid, periodSec);
+    }
+    else
+    {
+      // the sums are only corrected when the oldest item leaves the buffer, keep them from drifting below zero
+      if (m_frameStatistics.NumberOfPeriods == 0)
+      {
+        m_frameStatistics = BufferFrameStatistics();
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::RecomputeFrameStatistics()
+  {
+    // the caller must have locked the buffer
+    m_frameStatistics = BufferFrameStatistics();
+    m_minimumPeriodQueue.clear();
+    m_maximumPeriodQueue.clear();
+
+    BufferSlotIndex& slots = *m_slotRecords.back();
+    const BufferItemList::size_type bufferSize = GetBufferSize();
+    for (BufferItemList::size_type i = 0; i < m_numberOfItems; ++i)
+    {
+      // from the oldest item to the latest one
+      BufferItemList::size_type bufferIndex = (m_writePointer + bufferSize - m_numberOfItems + i) % bufferSize;
+      if (i == 0)
+      {
+        slots.Period[bufferIndex] = 0.f;
+        slots.IndexGap[bufferIndex] = 0;
+        continue;
+      }
+      BufferItemList::size_type previousIndex = (bufferIndex + bufferSize - 1) % bufferSize;
+      slots.Period[bufferIndex] = slots.FilteredTimestamp[bufferIndex] - slots.FilteredTimestamp[previousIndex];
+      slots.IndexGap[bufferIndex] = slots.Index[bufferIndex] - slots.Index[previousIndex];
+      AccumulateFramePeriod(bufferIndex, 1);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::ReadFrameStatistics(BufferFrameStatistics& outStatistics)
+  {
+    for (;;)
+    {
+      uint32 sequence = m_stateSequence.load(std::memory_order_acquire);
+      if ((sequence & 1) != 0)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      outStatistics = m_publishedFrameStatistics;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (m_stateSequence.load(std::memory_order_relaxed) == sequence)
+      {
+        return;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::RebuildSlotRecords()
+  {
+    // the caller must have locked the buffer
+    // Readers may still hold a pointer to the previous records, so they are retired and freed later by ReclaimSlotRecords
+    std::unique_ptr<BufferSlotIndex> slots(new BufferSlotIndex((std::max<BufferItemList::size_type>)(GetBufferSize(), 1)));
+    for (BufferItemList::size_type i = 0; i < GetBufferSize(); ++i)
+    {
+      StreamBufferItem^ item = m_bufferItemContainer[i];
+      slots->Uid[i] = item->GetUid();
+      slots->FilteredTimestamp[i] = item->GetFilteredTimestamp(0.f);
+      slots->UnfilteredTimestamp[i] = item->GetUnfilteredTimestamp(0.f);
+      slots->Index[i] = item->GetIndex();
+    }
+    m_slotRecords.push_back(std::move(slots));
+    m_pendingItem = BufferPendingItem();
+
+    RecomputeFrameStatistics();
+    PublishState(m_numberOfItems);
+    ReclaimSlotRecords();
+  }
+
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::ReclaimSlotRecords()
+  {
+    // the caller must have locked the buffer and published the current records
+    if (m_slotRecords.size() < 2)
+    {
+      return;
+    }
+
+    // Readers that register after this point read the current records, the ones registered before are counted
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_slotRecordReaders.load(std::memory_order_acquire) != 0)
+    {
+      // Retry on the next commit
+      return;
+    }
+    m_slotRecords.erase(m_slotRecords.begin(), m_slotRecords.end() - 1);
+  }
+
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::ReadPublishedState(BufferPublishedState& outState)
+  {
+    for (;;)
+    {
+      uint32 sequence = m_stateSequence.load(std::memory_order_acquire);
+      if ((sequence & 1) != 0)
+      {
+        // The writer is in the middle of a (very short) update
+        std::this_thread::yield();
+        continue;
+      }
+      outState = m_publishedState;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (m_stateSequence.load(std::memory_order_relaxed) == sequence)
+      {
+        return;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool TimestampedCircularBuffer::ReadSlot(const BufferPublishedState& state, BufferItemUidType uid, BufferSlotData& outData)
+  {
+    BufferItemList::size_type bufferIndex = (state.WritePointer + state.BufferSize - 1 - (state.LatestItemUid - uid)) % state.BufferSize;
+    const BufferSlotIndex& slots = *state.Slots;
+
+    uint32 sequence = slots.Sequence[bufferIndex].load(std::memory_order_acquire);
+    if ((sequence & 1) != 0)
+    {
+      return false;
+    }
+    outData.Uid = slots.Uid[bufferIndex];
+    outData.FilteredTimestamp = slots.FilteredTimestamp[bufferIndex];
+    outData.UnfilteredTimestamp = slots.UnfilteredTimestamp[bufferIndex];
+    outData.Index = slots.Index[bufferIndex];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slots.Sequence[bufferIndex].load(std::memory_order_relaxed) == sequence && outData.Uid == uid;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::ReadItemData(BufferItemUidType uid, BufferSlotData& outData)
+  {
+    SlotRecordsReader reader(m_slotRecordReaders);
+    BufferPublishedState state;
+    ReadPublishedState(state);
+    if (state.NumberOfItems == 0 || uid > state.LatestItemUid)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    if (uid < state.LatestItemUid - (state.NumberOfItems - 1) || !ReadSlot(state, uid, outData))
+    {
+      return ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    return ITEM_OK;
+  }
+
   //----------------------------------------------------------------------------
   // Sets the buffer size, and copies the maximum number of the most current old
   // frames and timestamps
@@ -152,21 +558,31 @@ namespace UWPOpenIGTLink
       m_numberOfItems = GetBufferSize();
     }
 
+    RebuildSlotRecords();
+
     return true;
   }
 
   //----------------------------------------------------------------------------
   StreamBufferItem^ TimestampedCircularBuffer::GetBufferItemFromUid(BufferItemUidType uid)
+  {
+    StreamBufferItem^ item;
+    ThrowOnItemStatus(GetBufferItemFromUidInternal(uid, item));
+    return item;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetBufferItemFromUidInternal(BufferItemUidType uid, StreamBufferItem^& outItem)
   {
     // the caller must have locked the buffer
-    BufferItemUidType oldestUid = m_latestItemUid - (m_numberOfItems - 1);
-    if (uid < oldestUid)
+    if (m_numberOfItems == 0 || uid > m_latestItemUid)
     {
-      throw UWPOpenIGTLink::ItemNotAvailableAnymoreException();
+      return ITEM_NOT_AVAILABLE_YET;
     }
-    else if (uid > m_latestItemUid)
+    BufferItemUidType oldestUid = m_latestItemUid - (m_numberOfItems - 1);
+    if (uid < oldestUid)
     {
-      throw UWPOpenIGTLink::ItemNotAvailableYetException();
+      return ITEM_NOT_AVAILABLE_ANYMORE;
     }
     BufferItemList::size_type bufferIndex = (m_writePointer - 1) - (m_latestItemUid - uid);
     if (bufferIndex > ((m_latestItemUid - uid) - (m_writePointer - 1)))
@@ -174,7 +590,48 @@ namespace UWPOpenIGTLink
       // Underflow
       bufferIndex = m_bufferItemContainer.size() + (m_writePointer - 1) - (m_latestItemUid - uid);
     }
-    return m_bufferItemContainer[bufferIndex];
+    outItem = m_bufferItemContainer[bufferIndex];
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::PinItemInternal(BufferItemUidType uid, StreamBufferItem^& outItem)
+  {
+    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
+
+    // Only published items can be pinned, the item between PrepareForNewItem and CommitNewItem is still being written
+    if (m_publishedState.NumberOfItems == 0 || uid > m_publishedState.LatestItemUid)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    if (uid < m_publishedState.LatestItemUid - (m_publishedState.NumberOfItems - 1))
+    {
+      return ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+
+    StreamBufferItem^ item;
+    ItemStatus status = GetBufferItemFromUidInternal(uid, item);
+    if (status != ITEM_OK)
+    {
+      return status;
+    }
+    item->PinInternal();
+    outItem = item;
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::PinItemFromTimeInternal(float time, StreamBufferItem^& outItem)
+  {
+    // Holding the lock keeps the writer from overwriting the found item before it is pinned
+    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
+    BufferItemUidType uid(0);
+    ItemStatus status = GetItemUidFromTimeInternal(time, uid);
+    if (status != ITEM_OK)
+    {
+      return status;
+    }
+    return PinItemInternal(uid, outItem);
   }
 
   //----------------------------------------------------------------------------
@@ -191,17 +648,41 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   float TimestampedCircularBuffer::GetFilteredTimeStamp(BufferItemUidType uid)
   {
-    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
-    StreamBufferItem^ itemPtr = GetBufferItemFromUid(uid);
-    return itemPtr->GetFilteredTimestamp(m_localTimeOffsetSec);
+    float timestamp(0.f);
+    ThrowOnItemStatus(GetFilteredTimeStampInternal(uid, timestamp));
+    return timestamp;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetFilteredTimeStampInternal(BufferItemUidType uid, float& outTimestamp)
+  {
+    BufferSlotData data;
+    ItemStatus status = ReadItemData(uid, data);
+    if (status == ITEM_OK)
+    {
+      outTimestamp = data.FilteredTimestamp + m_localTimeOffsetSec;
+    }
+    return status;
   }
 
   //----------------------------------------------------------------------------
   float TimestampedCircularBuffer::GetUnfilteredTimeStamp(BufferItemUidType uid)
   {
-    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
-    StreamBufferItem^ itemPtr = GetBufferItemFromUid(uid);
-    return itemPtr->GetUnfilteredTimestamp(m_localTimeOffsetSec);
+    float timestamp(0.f);
+    ThrowOnItemStatus(GetUnfilteredTimeStampInternal(uid, timestamp));
+    return timestamp;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetUnfilteredTimeStampInternal(BufferItemUidType uid, float& outTimestamp)
+  {
+    BufferSlotData data;
+    ItemStatus status = ReadItemData(uid, data);
+    if (status == ITEM_OK)
+    {
+      outTimestamp = data.UnfilteredTimestamp + m_localTimeOffsetSec;
+    }
+    return status;
   }
 
   //----------------------------------------------------------------------------
@@ -243,143 +724,248 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   BufferItemList::size_type TimestampedCircularBuffer::GetIndex(BufferItemUidType uid)
   {
-    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
-    StreamBufferItem^ itemPtr = GetBufferItemFromUid(uid);
-    if (itemPtr == nullptr)
+    BufferItemList::size_type index(0);
+    ThrowOnItemStatus(GetIndexInternal(uid, index));
+    return index;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetIndexInternal(BufferItemUidType uid, BufferItemList::size_type& outIndex)
+  {
+    BufferSlotData data;
+    ItemStatus status = ReadItemData(uid, data);
+    if (status == ITEM_OK)
     {
-      return 0;
+      outIndex = data.Index;
     }
-    return itemPtr->GetIndex();
+    return status;
   }
 
   //----------------------------------------------------------------------------
   BufferItemList::size_type TimestampedCircularBuffer::GetBufferIndexFromTime(float time)
   {
-    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
-
-    BufferItemUidType itemUid = GetItemUidFromTime(time);
+    BufferItemList::size_type bufferIndex(0);
+    ThrowOnItemStatus(GetBufferIndexFromTimeInternal(time, bufferIndex));
+    return bufferIndex;
+  }
 
-    BufferItemList::size_type bufferIndex = (m_writePointer - 1) - (m_latestItemUid - itemUid);
-    if (bufferIndex > ((m_latestItemUid - itemUid) - (m_writePointer - 1)))
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetBufferIndexFromTimeInternal(float time, BufferItemList::size_type& outBufferIndex)
+  {
+    BufferPublishedState state;
+    BufferItemUidType itemUid(0);
+    ItemStatus status = FindItemUidFromTime(time, state, itemUid);
+    if (status == ITEM_OK)
     {
-      // Underflow
-      bufferIndex = m_bufferItemContainer.size() + (m_writePointer - 1) - (m_latestItemUid - itemUid);
+      outBufferIndex = (state.WritePointer + state.BufferSize - 1 - (state.LatestItemUid - itemUid)) % state.BufferSize;
     }
-    return bufferIndex;
+    return status;
   }
 
   //----------------------------------------------------------------------------
-  // do a simple divide-and-conquer search for the transform
-  // that best matches the given timestamp
   BufferItemUidType TimestampedCircularBuffer::GetItemUidFromTime(float time)
   {
-    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
+    BufferItemUidType itemUid(0);
+    ThrowOnItemStatus(GetItemUidFromTimeInternal(time, itemUid));
+    return itemUid;
+  }
 
-    if (m_numberOfItems == 1)
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetItemUidFromTimeInternal(float time, BufferItemUidType& outUid)
+  {
+    BufferPublishedState state;
+    BufferItemUidType itemUid(0);
+    ItemStatus status = FindItemUidFromTime(time, state, itemUid);
+    if (status == ITEM_OK)
     {
-      // There is only one item, it's the closest one to any timestamp
-      return m_latestItemUid;
+      outUid = itemUid;
     }
+    return status;
+  }
 
-    BufferItemUidType lo = m_latestItemUid - (m_numberOfItems - 1);   // oldest item UID
-    BufferItemUidType hi = m_latestItemUid; // latest item UID
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::FindItemUidFromTime(float time, BufferPublishedState& state, BufferItemUidType& outUid)
+  {
+    // Search in local time, the timestamp array is stored without the offset (global = local + offset)
+    const float localTime = time - m_localTimeOffsetSec;
+    SlotRecordsReader reader(m_slotRecordReaders);
 
-    // minimum time
-    // This method is called often, therefore instead of calling GetTimeStamp(lo, tlo) we perform low-level operations to get the timestamp
-    BufferItemList::size_type loBufferIndex = (m_writePointer - 1) - (m_latestItemUid - lo);
-    if (loBufferIndex > ((m_latestItemUid - lo) - (m_writePointer - 1)))
+    for (;;)
     {
-      loBufferIndex = m_bufferItemContainer.size() + (m_writePointer - 1) - (m_latestItemUid - lo);
-    }
-    float tlo = m_bufferItemContainer[loBufferIndex]->GetFilteredTimestamp(m_localTimeOffsetSec);
+      ReadPublishedState(state);
 
-    // This method is called often, therefore instead of calling GetTimeStamp(hi, thi) we perform low-level operations to get the timestamp
-    BufferItemList::size_type hiBufferIndex = (m_writePointer - 1) - (m_latestItemUid - hi);
-    if (hiBufferIndex > ((m_latestItemUid - hi) - (m_writePointer - 1)))
-    {
-      hiBufferIndex = m_bufferItemContainer.size() + (m_writePointer - 1) - (m_latestItemUid - hi);
-    }
-    float thi = m_bufferItemContainer[hiBufferIndex]->GetFilteredTimestamp(m_localTimeOffsetSec);
+      if (state.NumberOfItems == 0)
+      {
+        return ITEM_NOT_AVAILABLE_YET;
+      }
 
-    // If the timestamp is slightly out of range then still accept it
-    // (due to errors in conversions there could be slight differences)
-    if (time < tlo - m_negligibleTimeDifferenceSec)
-    {
-      throw UWPOpenIGTLink::ItemNotAvailableAnymoreException();
-    }
-    else if (time > thi + m_negligibleTimeDifferenceSec)
-    {
-      throw UWPOpenIGTLink::ItemNotAvailableYetException();
-    }
+      const BufferItemUidType oldestUid = state.LatestItemUid - (state.NumberOfItems - 1);
+      if (state.NumberOfItems == 1)
+      {
+        // There is only one item, it's the closest one to any timestamp
+        outUid = oldestUid;
+        return ITEM_OK;
+      }
 
-    for (;;)
-    {
-      if (hi - lo <= 1)
+      // Positions below are relative to the oldest item, position i lives in buffer slot (oldestSlot + i) mod BufferSize
+      const BufferItemList::size_type count = state.NumberOfItems;
+      const BufferItemList::size_type bufferSize = state.BufferSize;
+      const BufferItemList::size_type oldestSlot = (state.WritePointer + bufferSize - count) % bufferSize;
+      const float* timestamps = state.Slots->FilteredTimestamp.get();
+      auto timestampAt = [timestamps, oldestSlot, bufferSize](BufferItemList::size_type position)
       {
-        if (time - tlo > thi - time)
+        BufferItemList::size_type slot = oldestSlot + position;
+        slot = (slot >= bufferSize) ? slot - bufferSize : slot;
+        return timestamps[slot];
+      };
+
+      const float tOldest = timestampAt(0);
+      const float tLatest = timestampAt(count - 1);
+
+      // If the timestamp is slightly out of range then still accept it
+      // (due to errors in conversions there could be slight differences)
+      ItemStatus status = ITEM_OK;
+      if (localTime < tOldest - m_negligibleTimeDifferenceSec)
+      {
+        status = ITEM_NOT_AVAILABLE_ANYMORE;
+      }
+      else if (localTime > tLatest + m_negligibleTimeDifferenceSec)
+      {
+        status = ITEM_NOT_AVAILABLE_YET;
+      }
+
+      BufferItemList::size_type lo(0);
+      if (status == ITEM_OK)
+      {
+        // Interpolated guess, exact for a constant item rate
+        BufferItemList::size_type guess(0);
+        if (tLatest > tOldest && localTime > tOldest)
+        {
+          guess = (std::min<BufferItemList::size_type>)(count - 1, static_cast<BufferItemList::size_type>((localTime - tOldest) / (tLatest - tOldest) * (count - 1)));
+        }
+
+        // Gallop from the guess to a bracket [lo, hi) with timestampAt(lo) <= localTime < timestampAt(hi) (or lo = 0, hi = count)
+        BufferItemList::size_type hi(count);
+        BufferItemList::size_type step(1);
+        if (timestampAt(guess) <= localTime)
         {
-          return hi;
+          lo = guess;
+          for (;;)
+          {
+            hi = (std::min<BufferItemList::size_type>)(lo + step, count);
+            if (hi == count || timestampAt(hi) > localTime)
+            {
+              break;
+            }
+            lo = hi;
+            step *= 2;
+          }
         }
         else
         {
-          return lo;
+          hi = guess;
+          for (;;)
+          {
+            lo = (hi > step) ? hi - step : 0;
+            if (lo == 0 || timestampAt(lo) <= localTime)
+            {
+              break;
+            }
+            hi = lo;
+            step *= 2;
+          }
         }
-      }
 
-      BufferItemList::size_type mid = (lo + hi) / 2;
+        // Branchless binary search for the last position in the bracket that is not later than the requested time
+        BufferItemList::size_type length = hi - lo;
+        while (length > 1)
+        {
+          BufferItemList::size_type half = length / 2;
+          lo = (timestampAt(lo + half) <= localTime) ? lo + half : lo;
+          length -= half;
+        }
 
-      // This is a hot loop, therefore instead of calling GetTimeStamp(mid, tmid) we perform low-level operations to get the timestamp
-      BufferItemList::size_type midBufferIndex = (m_writePointer - 1) - (m_latestItemUid - mid);
-      if (midBufferIndex > ((m_latestItemUid - mid) - (m_writePointer - 1)))
-      {
-        midBufferIndex = m_bufferItemContainer.size() + (m_writePointer - 1) - (m_latestItemUid - mid);
+        if (lo + 1 < count && localTime - timestampAt(lo) > timestampAt(lo + 1) - localTime)
+        {
+          ++lo;
+        }
       }
-      float tmid = m_bufferItemContainer[midBufferIndex]->GetFilteredTimestamp(m_localTimeOffsetSec);
 
-      if (time < tmid)
-      {
-        hi = mid;
-        thi = tmid;
-      }
-      else
+      // The timestamps were read without per slot validation. The writer only ever overwrites the oldest slot
+      // and hides it from the published state first, so the result is valid if the oldest item is still there.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      BufferPublishedState currentState;
+      ReadPublishedState(currentState);
+      if (currentState.Slots != state.Slots || currentState.LatestItemUid - (currentState.NumberOfItems - 1) > oldestUid)
       {
-        lo = mid;
-        tlo = tmid;
+        continue;
       }
+
+      outUid = oldestUid + lo;
+      return status;
     }
-    assert(false);
   }
 
   //----------------------------------------------------------------------------
   BufferItemUidType TimestampedCircularBuffer::GetLatestItemUidInBuffer()
   {
-    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
-    return m_latestItemUid;
+    BufferPublishedState state;
+    ReadPublishedState(state);
+    return state.LatestItemUid;
   }
 
   //----------------------------------------------------------------------------
   BufferItemUidType TimestampedCircularBuffer::GetOldestItemUidInBuffer()
   {
-    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
+    BufferPublishedState state;
+    ReadPublishedState(state);
     // LatestItemUid - ( NumberOfItems - 1 ) is the oldest element in the buffer
-    return m_latestItemUid - (m_numberOfItems - 1);
+    return state.LatestItemUid - (state.NumberOfItems - 1);
   }
 
   //----------------------------------------------------------------------------
   float TimestampedCircularBuffer::GetLatestTimeStamp()
   {
-    return GetTimeStamp(GetLatestItemUidInBuffer());
+    float timestamp(0.f);
+    ThrowOnItemStatus(GetLatestTimeStampInternal(timestamp));
+    return timestamp;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetLatestTimeStampInternal(float& outTimestamp)
+  {
+    return GetTimeStampInternal(GetLatestItemUidInBuffer(), outTimestamp);
   }
 
   //----------------------------------------------------------------------------
   float TimestampedCircularBuffer::GetOldestTimeStamp()
   {
-    // The oldest item may be removed from the buffer at any moment
-    // therefore we need to retrieve its UID and timestamp within a single lock
-    std::lock_guard<std::recursive_mutex> bufferGuardedLock(m_mutex);
-    // LatestItemUid - ( NumberOfItems - 1 ) is the oldest element in the buffer
-    BufferItemUidType oldestUid = (m_latestItemUid - (m_numberOfItems - 1));
-    return GetTimeStamp(oldestUid);
+    float timestamp(0.f);
+    ThrowOnItemStatus(GetOldestTimeStampInternal(timestamp));
+    return timestamp;
+  }
+
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetOldestTimeStampInternal(float& outTimestamp)
+  {
+    // The oldest item may be overwritten at any moment, retry with the new oldest item in that case
+    SlotRecordsReader reader(m_slotRecordReaders);
+    for (;;)
+    {
+      BufferPublishedState state;
+      ReadPublishedState(state);
+      if (state.NumberOfItems == 0)
+      {
+        return ITEM_NOT_AVAILABLE_YET;
+      }
+
+      BufferSlotData data;
+      if (ReadSlot(state, state.LatestItemUid - (state.NumberOfItems - 1), data))
+      {
+        outTimestamp = data.FilteredTimestamp + m_localTimeOffsetSec;
+        return ITEM_OK;
+      }
+    }
   }
 
   //----------------------------------------------------------------------------
@@ -389,7 +975,7 @@ namespace UWPOpenIGTLink
     m_writePointer = buffer->m_writePointer;
     m_numberOfItems = buffer->m_numberOfItems;
     m_currentTimeStamp = buffer->m_currentTimeStamp;
-    m_localTimeOffsetSec = buffer->m_localTimeOffsetSec;
+    m_localTimeOffsetSec = buffer->m_localTimeOffsetSec.load();
     m_latestItemUid = buffer->m_latestItemUid;
     m_startTime = buffer->m_startTime;
     m_averagedItemsForFiltering = buffer->m_averagedItemsForFiltering;
@@ -397,8 +983,24 @@ namespace UWPOpenIGTLink
     m_filterContainersOldestIndex = buffer->m_filterContainersOldestIndex;
     m_filterContainerTimestampVector = buffer->m_filterContainerTimestampVector;
     m_filterContainerIndexVector = buffer->m_filterContainerIndexVector;
+    m_filterSumX = buffer->m_filterSumX;
+    m_filterSumY = buffer->m_filterSumY;
+    m_filterSumXX = buffer->m_filterSumXX;
+    m_filterSumXY = buffer->m_filterSumXY;
+    m_filterReferenceX = buffer->m_filterReferenceX;
+    m_filterReferenceY = buffer->m_filterReferenceY;
+    m_filterItemsSinceRebase = buffer->m_filterItemsSinceRebase;
+
+    // Copy the items so the two buffers do not write each other's items, the frames are shared instead of copied
+    m_bufferItemContainer.clear();
+    for (auto item : buffer->m_bufferItemContainer)
+    {
+      StreamBufferItem^ newItem = ref new StreamBufferItem();
+      newItem->ShallowCopyInternal(item, true);
+      m_bufferItemContainer.push_back(newItem);
+    }
 
-    m_bufferItemContainer = buffer->m_bufferItemContainer;
+    RebuildSlotRecords();
   }
 
   //----------------------------------------------------------------------------
@@ -421,123 +1023,79 @@ namespace UWPOpenIGTLink
     m_numberOfItems = 0;
     m_currentTimeStamp = 0;
     m_latestItemUid = 0;
+    m_pendingItem = BufferPendingItem();
+
+    RecomputeFrameStatistics();
+    PublishState(m_numberOfItems);
   }
 
   //----------------------------------------------------------------------------
   float TimestampedCircularBuffer::GetFrameRate(bool ideal, float* framePeriodStdevSec)
   {
-    // TODO: Start the frame rate computation from the latest frame UID with using a few seconds of items in the buffer
-    bool cannotComputeIdealFrameRateDueToInvalidFrameNumbers = false;
-
-    std::vector<float> framePeriods;
-    for (BufferItemUidType frame = GetLatestItemUidInBuffer(); frame > GetOldestItemUidInBuffer(); --frame)
-    {
-      float time(0);
-      try
-      {
-        time = GetTimeStamp(frame);
-      }
-      catch (const std::exception&)
-      {
-        continue;
-      }
-
-      BufferItemList::size_type framenum(0);
-      try
-      {
-        framenum = GetIndex(frame);
-      }
-      catch (const std::exception&)
-      {
-        continue;
-      }
-
-      float prevtime(0);
-      try
-      {
-        prevtime = GetTimeStamp(frame - 1);
-      }
-      catch (const std::exception&)
-      {
-        continue;
-      }
-
-      BufferItemList::size_type prevframenum(0);
-      try
-      {
-        prevframenum = GetIndex(frame - 1);
-      }
-      catch (const std::exception&)
-      {
-        continue;
-      }
-
-      float frameperiod = (time - prevtime);
-      BufferItemList::size_type frameDiff = framenum - prevframenum;
-
-      if (ideal)
-      {
-        if (frameDiff > 0)
-        {
-          frameperiod /= (1.f * frameDiff);
-        }
-        else
-        {
-          // the same frame number was set for different frame indexes; this should not happen (probably no frame number is available)
-          cannotComputeIdealFrameRateDueToInvalidFrameNumbers = true;
-        }
-      }
-
-      if (frameperiod > 0)
-      {
-        framePeriods.push_back(frameperiod);
-      }
-    }
+    BufferFrameStatistics statistics;
+    ReadFrameStatistics(statistics);
 
-    if (cannotComputeIdealFrameRateDueToInvalidFrameNumbers)
+    if (ideal && statistics.NumberOfInvalidFrameNumbers > 0)
     {
+      // the same frame number was set for different frame indexes; this should not happen (probably no frame number is available)
       OutputDebugStringA("Cannot compute ideal frame rate accurately, as frame numbers are invalid or missing");
     }
 
-    const BufferItemList::size_type numberOfFramePeriods = framePeriods.size();
-    if (numberOfFramePeriods < 1)
+    if (statistics.NumberOfPeriods < 1)
     {
       OutputDebugStringA("Failed to compute frame rate. Not enough samples.");
       return 0;
     }
 
-    float samplingPeriod(0);
-    for (BufferItemList::size_type i = 0; i < numberOfFramePeriods; i++)
-    {
-      samplingPeriod += framePeriods[i];
-    }
-    samplingPeriod /= 1.f * numberOfFramePeriods;
+    const double numberOfFramePeriods = static_cast<double>(statistics.NumberOfPeriods);
+    const double sum = ideal ? statistics.SumIdealPeriod : statistics.SumPeriod;
+    const double sumSquared = ideal ? statistics.SumIdealPeriodSquared : statistics.SumPeriodSquared;
+    const double samplingPeriod = sum / numberOfFramePeriods;
 
     float frameRate(0);
-    if (samplingPeriod != 0)
+    if (samplingPeriod > 0)
     {
-      frameRate = 1.f / samplingPeriod;
+      frameRate = static_cast<float>(1.0 / samplingPeriod);
     }
 
     if (framePeriodStdevSec != nullptr)
     {
       // Standard deviation of sampling period
-      // stdev = sqrt ( 1/N * sum[ (xi-mean)^2 ] ) = sqrt ( 1/N * sumOfXiMeanDiffSquare )
-      float sumOfXiMeanDiffSquare = 0;
-      for (BufferItemList::size_type i = 0; i < numberOfFramePeriods; i++)
-      {
-        sumOfXiMeanDiffSquare += (framePeriods[i] - samplingPeriod) * (framePeriods[i] - samplingPeriod);
-      }
-      float framePeriodStdev = sqrt(sumOfXiMeanDiffSquare / numberOfFramePeriods);
-      *framePeriodStdevSec = framePeriodStdev;
+      // stdev = sqrt ( 1/N * sum[ (xi-mean)^2 ] ) = sqrt ( 1/N * sum[ xi^2 ] - mean^2 )
+      const double variance = sumSquared / numberOfFramePeriods - samplingPeriod * samplingPeriod;
+      *framePeriodStdevSec = static_cast<float>(sqrt(variance > 0.0 ? variance : 0.0));
     }
 
     return frameRate;
   }
 
   //----------------------------------------------------------------------------
-  // for accurate timing of the frame: an exponential moving average
-  // is computed to smooth out the jitter in the times that are returned by the system clock:
+  uint64 TimestampedCircularBuffer::GetNumberOfDroppedFrames()
+  {
+    BufferFrameStatistics statistics;
+    ReadFrameStatistics(statistics);
+    return statistics.NumberOfDroppedFrames;
+  }
+
+  //----------------------------------------------------------------------------
+  float TimestampedCircularBuffer::GetMinimumFramePeriodSec()
+  {
+    BufferFrameStatistics statistics;
+    ReadFrameStatistics(statistics);
+    return statistics.MinimumPeriod;
+  }
+
+  //----------------------------------------------------------------------------
+  float TimestampedCircularBuffer::GetMaximumFramePeriodSec()
+  {
+    BufferFrameStatistics statistics;
+    ReadFrameStatistics(statistics);
+    return statistics.MaximumPeriod;
+  }
+
+  //----------------------------------------------------------------------------
+  // for accurate timing of the frame: a line is fitted to the item index and timestamp of
+  // the last m_averagedItemsForFiltering items to smooth out the jitter in the times that are returned by the system clock
   bool TimestampedCircularBuffer::CreateFilteredTimeStampForItem(uint32 itemIndex, float inUnfilteredTimestamp, float* outFilteredTimestamp, bool* filteredTimestampProbablyValid)
   {
     if (outFilteredTimestamp == nullptr || filteredTimestampProbablyValid == nullptr)
@@ -550,21 +1108,42 @@ namespace UWPOpenIGTLink
 
     if (m_filterContainerIndexVector.size() != m_averagedItemsForFiltering || m_filterContainerTimestampVector.size() != m_averagedItemsForFiltering)
     {
-      // this call set elements to null
-      m_filterContainerIndexVector.reserve(m_averagedItemsForFiltering);
-      m_filterContainerTimestampVector.reserve(m_averagedItemsForFiltering);
+      m_filterContainerIndexVector.assign(m_averagedItemsForFiltering, 0);
+      m_filterContainerTimestampVector.assign(m_averagedItemsForFiltering, 0.f);
       m_filterContainersOldestIndex = 0;
       m_filterContainersNumberOfValidElements = 0;
+      m_filterReferenceX = itemIndex;
+      m_filterReferenceY = inUnfilteredTimestamp;
+      m_filterSumX = m_filterSumY = m_filterSumXX = m_filterSumXY = 0.0;
+      m_filterItemsSinceRebase = 0;
     }
 
     // We store the last AveragedItemsForFiltering unfiltered timestamp and item indexes, because these are used for computing the filtered timestamp.
+    // The regression sums are updated incrementally: the oldest sample leaves the window, the new one enters.
     if (m_averagedItemsForFiltering > 1)
     {
+      if (m_filterContainersNumberOfValidElements == m_averagedItemsForFiltering)
+      {
+        double x = m_filterContainerIndexVector[m_filterContainersOldestIndex] - m_filterReferenceX;
+        double y = m_filterContainerTimestampVector[m_filterContainersOldestIndex] - m_filterReferenceY;
+        m_filterSumX -= x;
+        m_filterSumY -= y;
+        m_filterSumXX -= x * x;
+        m_filterSumXY -= x * y;
+      }
+
       m_filterContainerIndexVector[m_filterContainersOldestIndex] = itemIndex;
       m_filterContainerTimestampVector[m_filterContainersOldestIndex] = inUnfilteredTimestamp;
       m_filterContainersNumberOfValidElements++;
       m_filterContainersOldestIndex++;
 
+      double x = itemIndex - m_filterReferenceX;
+      double y = inUnfilteredTimestamp - m_filterReferenceY;
+      m_filterSumX += x;
+      m_filterSumY += y;
+      m_filterSumXX += x * x;
+      m_filterSumXY += x * y;
+
       if (m_filterContainersNumberOfValidElements > m_averagedItemsForFiltering)
       {
         m_filterContainersNumberOfValidElements = m_averagedItemsForFiltering;
@@ -574,6 +1153,13 @@ namespace UWPOpenIGTLink
       {
         m_filterContainersOldestIndex = 0;
       }
+
+      // Add/remove accumulates rounding errors and the reference drifts away from the window,
+      // so recompute the sums once per window length (amortized O(1))
+      if (++m_filterItemsSinceRebase >= m_averagedItemsForFiltering)
+      {
+        RebaseFilterSums();
+      }
     }
 
     // If we don't have enough unfiltered timestamps or we don't want to use filtering then just use the unfiltered timestamps
@@ -599,42 +1185,60 @@ namespace UWPOpenIGTLink
     //   a = framePeriod
     //   b = timeOffset
     //
-    // Ordinary least squares estimation:
+    // Ordinary least squares estimation from the running sums:
     //   y(i) = a * x(i) + b;
-    //   a = sum( (x(i)-xMean) * (y(i)-yMean) ) / sum( (x(i)-xMean) * (x(i)-xMean) )
-    //   b = yMean - a*xMean
+    //   a = ( n*sum(x*y) - sum(x)*sum(y) ) / ( n*sum(x*x) - sum(x)*sum(x) )
+    //   b = ( sum(y) - a*sum(x) ) / n
     //
-
-    float xMean = 1.f * VectorMean<uint32>(m_filterContainerIndexVector, 0);
-    float yMean = VectorMean<float>(m_filterContainerTimestampVector, 0.f);
-    float covarianceXY = 0;
-    float varianceX = 0;
-    for (BufferItemList::size_type i = m_filterContainerTimestampVector.size() - 1; i >= 0; i--)
+    const double n = m_filterContainersNumberOfValidElements;
+    const double varianceX = n * m_filterSumXX - m_filterSumX * m_filterSumX;
+    if (varianceX <= 0.0)
     {
-      float xiMinusXmean = m_filterContainerIndexVector[i] - xMean;
-      covarianceXY += xiMinusXmean * (m_filterContainerTimestampVector[i] - yMean);
-      varianceX += xiMinusXmean * xiMinusXmean;
+      // All items have the same index (probably no frame number is available), the line cannot be fitted
+      *outFilteredTimestamp = inUnfilteredTimestamp;
+      return true;
     }
-    float a = covarianceXY / varianceX;
-    float b = yMean - a * xMean;
+    const double a = (n * m_filterSumXY - m_filterSumX * m_filterSumY) / varianceX;
+    const double b = (m_filterSumY - a * m_filterSumX) / n;
 
-    *outFilteredTimestamp = a * itemIndex + b;
+    *outFilteredTimestamp = static_cast<float>(m_filterReferenceY + a * (itemIndex - m_filterReferenceX) + b);
 
     if (fabs(*outFilteredTimestamp - inUnfilteredTimestamp) > m_maxAllowedFilteringTimeDifference)
     {
-      // Write current timestamps and frame indexes to the log to allow investigation of the problem
-      filteredTimestampProbablyValid = false;
+      *filteredTimestampProbablyValid = false;
       std::stringstream ss;
       ss << "Difference between unfiltered timestamp is larger than the threshold. The unfiltered timestamp may be incorrect."
          << " Unfiltered timestamp: " << inUnfilteredTimestamp << ", filtered timestamp: " << *outFilteredTimestamp << ", difference: " << fabs(*outFilteredTimestamp - inUnfilteredTimestamp) << ", threshold: " << m_maxAllowedFilteringTimeDifference << "."
-         << " timestamps = [" << std::fixed << m_filterContainerTimestampVector << "];"
-         << " frame indexes = [" << std::fixed << m_filterContainerIndexVector << "];";
+         << " Item index: " << itemIndex << ", estimated frame period: " << a << ", window: " << m_filterContainersNumberOfValidElements << " items.";
       OutputDebugStringA(ss.str().c_str());
     }
 
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  void TimestampedCircularBuffer::RebaseFilterSums()
+  {
+    // the caller must have locked the buffer
+    const uint32 newestIndex = (m_filterContainersOldestIndex + m_averagedItemsForFiltering - 1) % m_averagedItemsForFiltering;
+    m_filterReferenceX = m_filterContainerIndexVector[newestIndex];
+    m_filterReferenceY = m_filterContainerTimestampVector[newestIndex];
+    m_filterSumX = m_filterSumY = m_filterSumXX = m_filterSumXY = 0.0;
+    m_filterItemsSinceRebase = 0;
+
+    // The valid elements are the newest ones, walk back from the newest
+    for (uint32 i = 0; i < m_filterContainersNumberOfValidElements; ++i)
+    {
+      const uint32 position = (newestIndex + m_averagedItemsForFiltering - i) % m_averagedItemsForFiltering;
+      double x = m_filterContainerIndexVector[position] - m_filterReferenceX;
+      double y = m_filterContainerTimestampVector[position] - m_filterReferenceY;
+      m_filterSumX += x;
+      m_filterSumY += y;
+      m_filterSumXX += x * x;
+      m_filterSumXY += x * y;
+    }
+  }
+
   //----------------------------------------------------------------------------
   BufferItemList::size_type TimestampedCircularBuffer::GetBufferSize()
   {
@@ -644,7 +1248,9 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   BufferItemList::size_type TimestampedCircularBuffer::GetNumberOfItems()
   {
-    return m_numberOfItems;
+    BufferPublishedState state;
+    ReadPublishedState(state);
+    return state.NumberOfItems;
   }
 
   //----------------------------------------------------------------------------
@@ -653,6 +1259,12 @@ namespace UWPOpenIGTLink
     return GetFilteredTimeStamp(uid);
   }
 
+  //----------------------------------------------------------------------------
+  ItemStatus TimestampedCircularBuffer::GetTimeStampInternal(BufferItemUidType uid, float& outTimestamp)
+  {
+    return GetFilteredTimeStampInternal(uid, outTimestamp);
+  }
+
   //----------------------------------------------------------------------------
   void TimestampedCircularBuffer::SetAveragedItemsForFiltering(uint32 items)
   {
@@ -29,8 +29,10 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include "StreamBufferItem.h"
 
 // STL includes
-#include <mutex>
+#include <atomic>
 #include <deque>
+#include <memory>
+#include <mutex>
 
 namespace UWPOpenIGTLink
 {
@@ -42,6 +44,82 @@ namespace UWPOpenIGTLink
     ITEM_UNKNOWN_ERROR
   };
 
+  /// Timing data of one buffer slot, readable without taking the buffer lock
+  struct BufferSlotData
+  {
+    BufferItemUidType   Uid = 0;
+    float               FilteredTimestamp = 0.f;
+    float               UnfilteredTimestamp = 0.f;
+    uint32              Index = 0;
+  };
+
+  /*!
+    Timing data of all buffer slots, stored as contiguous arrays (structure of arrays) indexed by buffer index,
+    so that the temporal search only touches the timestamp array.
+    Each slot is published through its own sequence counter (odd while the writer updates the slot).
+  */
+  struct BufferSlotIndex
+  {
+    explicit BufferSlotIndex(BufferItemList::size_type size);
+
+    BufferItemList::size_type               Size;
+    std::unique_ptr<std::atomic<uint32>[]>  Sequence;
+    std::unique_ptr<BufferItemUidType[]>    Uid;
+    std::unique_ptr<float[]>                FilteredTimestamp;
+    std::unique_ptr<float[]>                UnfilteredTimestamp;
+    std::unique_ptr<uint32[]>               Index;
+    std::unique_ptr<float[]>                Period;     // time since the previous item, 0 if it is not part of the frame statistics
+    std::unique_ptr<uint32[]>               IndexGap;   // index difference to the previous item
+  };
+
+  /// Frame period statistics of the items in the buffer, updated as items are added and overwritten
+  struct BufferFrameStatistics
+  {
+    uint64  NumberOfPeriods = 0;
+    double  SumPeriod = 0.0;
+    double  SumPeriodSquared = 0.0;
+    double  SumIdealPeriod = 0.0;
+    double  SumIdealPeriodSquared = 0.0;
+    uint64  NumberOfDroppedFrames = 0;
+    uint64  NumberOfInvalidFrameNumbers = 0;
+    float   MinimumPeriod = 0.f;
+    float   MaximumPeriod = 0.f;
+  };
+
+  /// What PrepareForNewItem changed, so that AbortNewItem can undo it
+  struct BufferPendingItem
+  {
+    bool                        Active = false;
+    BufferItemList::size_type   BufferIndex = 0;
+    BufferItemUidType           Uid = 0;
+    float                       FilteredTimestamp = 0.f;
+    float                       Period = 0.f;
+    uint32                      IndexGap = 0;
+    float                       CurrentTimeStamp = 0.f;
+    BufferItemList::size_type   NumberOfItems = 0;
+    StreamBufferItem^           PinnedItem = nullptr;   // the overwritten item, if it was pinned and the slot got a new one
+  };
+
+  /// Snapshot of the ring state as seen by lock-free readers
+  struct BufferPublishedState
+  {
+    BufferSlotIndex*            Slots = nullptr;
+    BufferItemList::size_type   BufferSize = 0;
+    BufferItemList::size_type   NumberOfItems = 0;
+    BufferItemList::size_type   WritePointer = 0;
+    BufferItemUidType           LatestItemUid = 0;
+  };
+
+  /*!
+    Circular buffer of stream items with a single writer.
+
+    Writers (AddItem in Buffer) call PrepareForNewItem, fill the returned item and then CommitNewItem,
+    or AbortNewItem if the item cannot be filled.
+    The timing data of each slot is published through a per slot sequence counter and the ring state
+    (latest uid, number of items, write pointer) through a buffer level sequence counter, so the
+    timestamp, index and temporal search accessors never take the buffer lock.
+  */
+
   public ref class TimestampedCircularBuffer sealed
   {
   public:
@@ -104,7 +182,7 @@ namespace UWPOpenIGTLink
 
     /*!
       Get the frame rate from the buffer based on the number of frames in the buffer
-      and the elapsed time.
+      and the elapsed time. The frame period statistics are maintained as items are added, so this is O(1).
       Ideal frame rate shows the mean of the frame periods in the buffer based on the frame
       number difference (a.k.a. the device frame rate, a.k.a. the frame rate that would have been achieved
       if frames were not dropped).
@@ -113,6 +191,13 @@ namespace UWPOpenIGTLink
     */
     float GetFrameRate(bool ideal, float* framePeriodStdevSecPtr);
 
+    /*! Get the number of frames dropped by the data source between the items in the buffer, based on the frame index gaps */
+    uint64 GetNumberOfDroppedFrames();
+    /*! Get the shortest frame period between the items in the buffer (in seconds) */
+    float GetMinimumFramePeriodSec();
+    /*! Get the longest frame period between the items in the buffer (in seconds) */
+    float GetMaximumFramePeriodSec();
+
     /*! Clear buffer (set the buffer pointer to the first element) */
     void Clear();
 
@@ -130,6 +215,19 @@ namespace UWPOpenIGTLink
 
     bool PrepareForNewItem(float timestamp, BufferItemUidType* outNewFrameUid, BufferItemList::size_type* bufferIndex);
 
+    /*!
+      Publish the item prepared by PrepareForNewItem to readers.
+      Must be called once for every successful PrepareForNewItem, after the item has been filled.
+    */
+    void CommitNewItem(BufferItemList::size_type bufferIndex);
+
+    /*!
+      Undo the PrepareForNewItem call of an item that could not be filled, instead of publishing it.
+      The slot gets back its previous item and timing data, and the latest timestamp, latest uid, write pointer
+      and number of items are restored.
+    */
+    void AbortNewItem(BufferItemList::size_type bufferIndex);
+
     /*!
       Create filtered and unfiltered timestamp for accurate timing of the buffer item.
       The timing may be inaccurate because the timestamp is attached to the item when Plus receives it
@@ -152,21 +250,100 @@ namespace UWPOpenIGTLink
     /*! Get recording start time */
     float GetStartTime();
 
+  internal:
+    /*!
+      Non-throwing variants of the lookups above, for the hot paths (queries at "now" often land just outside the buffer).
+      They return ITEM_OK, ITEM_NOT_AVAILABLE_YET or ITEM_NOT_AVAILABLE_ANYMORE and only write the output on ITEM_OK.
+    */
+    ItemStatus GetItemUidFromTimeInternal(float time, BufferItemUidType& outUid);
+    ItemStatus GetBufferIndexFromTimeInternal(float time, BufferItemList::size_type& outBufferIndex);
+    ItemStatus GetTimeStampInternal(BufferItemUidType uid, float& outTimestamp);
+    ItemStatus GetFilteredTimeStampInternal(BufferItemUidType uid, float& outTimestamp);
+    ItemStatus GetUnfilteredTimeStampInternal(BufferItemUidType uid, float& outTimestamp);
+    ItemStatus GetIndexInternal(BufferItemUidType uid, BufferItemList::size_type& outIndex);
+    ItemStatus GetLatestTimeStampInternal(float& outTimestamp);
+    ItemStatus GetOldestTimeStampInternal(float& outTimestamp);
+    /// Caller must hold the buffer lock
+    ItemStatus GetBufferItemFromUidInternal(BufferItemUidType uid, StreamBufferItem^& outItem);
+
+    /*!
+      Pin a published item so it can be read without holding any lock until it is unpinned (StreamBufferItem::UnpinInternal).
+      The writer never modifies a pinned item: when the write pointer reaches its slot the slot gets a new item
+      sharing the same frame storage, so readers get a stable view without copying the item.
+    */
+    ItemStatus PinItemInternal(BufferItemUidType uid, StreamBufferItem^& outItem);
+    /// Pin the published item closest to time, see PinItemInternal
+    ItemStatus PinItemFromTimeInternal(float time, StreamBufferItem^& outItem);
+
+  protected private:
+    /// Writer side: publish the current ring state to readers, caller must hold m_mutex
+    void PublishState(BufferItemList::size_type numberOfItems);
+    /// Writer side: recreate the slot records from the items after the container was restructured, caller must hold m_mutex
+    void RebuildSlotRecords();
+    /// Writer side: free the retired slot records once no reader can hold them anymore, caller must hold m_mutex and have published the current records
+    void ReclaimSlotRecords();
+
+    /// Recompute the timestamp filter running sums from the window, relative to the newest sample
+    void RebaseFilterSums();
+
+    /// Add (sign = 1) or remove (sign = -1) the frame period of a buffer slot to the frame statistics, caller must hold m_mutex
+    void AccumulateFramePeriod(BufferItemList::size_type bufferIndex, int sign);
+    /// Recompute the frame statistics from all items in the buffer, caller must hold m_mutex
+    void RecomputeFrameStatistics();
+    /// Reader side: get a consistent snapshot of the frame statistics
+    void ReadFrameStatistics(BufferFrameStatistics& outStatistics);
+
+    /// Reader side: get a consistent snapshot of the ring state
+    void ReadPublishedState(BufferPublishedState& outState);
+    /// Reader side: read the timing data of an item, returns false if the item has been overwritten in the meantime
+    bool ReadSlot(const BufferPublishedState& state, BufferItemUidType uid, BufferSlotData& outData);
+    /// Reader side: read the timing data of an item, returns ITEM_OK, ITEM_NOT_AVAILABLE_YET or ITEM_NOT_AVAILABLE_ANYMORE
+    ItemStatus ReadItemData(BufferItemUidType uid, BufferSlotData& outData);
+    /*!
+      Reader side: search the item closest to time, returns ITEM_OK, ITEM_NOT_AVAILABLE_YET or ITEM_NOT_AVAILABLE_ANYMORE
+      Starts from an interpolated guess (items usually arrive at a nearly constant rate), brackets the result
+      by galloping from the guess and finishes with a branchless binary search inside the bracket.
+    */
+    ItemStatus FindItemUidFromTime(float time, BufferPublishedState& outState, BufferItemUidType& outUid);
+
   protected private:
     std::recursive_mutex          m_mutex;
     BufferItemList::size_type     m_numberOfItems;
     BufferItemList::size_type     m_writePointer;
     float                         m_currentTimeStamp;
-    float                         m_localTimeOffsetSec;
+    std::atomic<float>            m_localTimeOffsetSec;
     BufferItemUidType             m_latestItemUid;
+    BufferPendingItem             m_pendingItem;
     BufferItemList                m_bufferItemContainer;
     std::vector<uint32>           m_filterContainerIndexVector;
     std::vector<float>            m_filterContainerTimestampVector;
     uint32                        m_filterContainersOldestIndex;
     uint32                        m_filterContainersNumberOfValidElements;
+    // Running sums of the filter window (x = item index, y = timestamp), relative to the reference sample
+    double                        m_filterSumX;
+    double                        m_filterSumY;
+    double                        m_filterSumXX;
+    double                        m_filterSumXY;
+    double                        m_filterReferenceX;
+    double                        m_filterReferenceY;
+    uint32                        m_filterItemsSinceRebase;
     uint32                        m_averagedItemsForFiltering;
     float                         m_maxAllowedFilteringTimeDifference;
     float                         m_startTime;
     float                         m_negligibleTimeDifferenceSec;
+
+    // Lock-free publication
+    std::atomic<uint32>                               m_stateSequence;
+    BufferPublishedState                              m_publishedState;
+    BufferFrameStatistics                             m_publishedFrameStatistics;
+
+    // Frame statistics (writer side), min/max are tracked with monotonic queues of (uid, period)
+    BufferFrameStatistics                             m_frameStatistics;
+    std::deque<std::pair<BufferItemUidType, float>>   m_minimumPeriodQueue;
+    std::deque<std::pair<BufferItemUidType, float>>   m_maximumPeriodQueue;
+    // The last element holds the current slot records, earlier ones are kept alive while readers may still hold an old state
+    std::vector<std::unique_ptr<BufferSlotIndex>>     m_slotRecords;
+    // Number of readers between reading a published state and their last access to its slot records
+    std::atomic<uint32>                               m_slotRecordReaders;
   };
 }
\ No newline at end of file
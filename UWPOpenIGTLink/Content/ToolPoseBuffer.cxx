@@ -0,0 +1,433 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#include "pch.h"
+#include "TimestampedCircularBuffer.h"
+#include "ToolPoseBuffer.h"
+
+// STL includes
+#include <algorithm>
+#include <sstream>
+
+using namespace Windows::Foundation::Numerics;
+
+namespace
+{
+  static const float NEGLIGIBLE_TIME_DIFFERENCE = 0.00001f; // in seconds, used for comparing between exact timestamps
+  static const uint32 DEFAULT_BUFFER_SIZE = 50;
+
+  //----------------------------------------------------------------------------
+  uint64 MakeToolKey(UWPOpenIGTLink::CoordinateFrameId from, UWPOpenIGTLink::CoordinateFrameId to)
+  {
+    return (static_cast<uint64>(from) << 32) | to;
+  }
+}
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  ToolPoseBuffer::ToolPoseBuffer()
+  {
+    this->SetBufferSize(DEFAULT_BUFFER_SIZE);
+  }
+
+  //----------------------------------------------------------------------------
+  ToolPoseBuffer::~ToolPoseBuffer()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  bool ToolPoseBuffer::SetBufferSize(uint32 numberOfSamples)
+  {
+    if (numberOfSamples < 1)
+    {
+      OutputDebugStringA("ToolPoseBuffer: Cannot set buffer size, at least one sample is required.");
+      return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_bufferSize = numberOfSamples;
+    m_numberOfSamples = 0;
+    m_writePointer = 0;
+    m_timestamps.assign(m_bufferSize, 0.f);
+    m_validity.assign(static_cast<size_t>(m_bufferSize) * m_validityWordsPerRow, 0);
+    m_poses.assign(static_cast<size_t>(m_bufferSize) * m_numberOfTools, ToolPose());
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 ToolPoseBuffer::GetBufferSize()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_bufferSize;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 ToolPoseBuffer::GetNumberOfSamples()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numberOfSamples;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 ToolPoseBuffer::AddTool(TransformName^ name)
+  {
+    if (name == nullptr || !name->IsValid())
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Invalid tool name sent to ToolPoseBuffer.");
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return AddToolInternal(name->FromId(), name->ToId());
+  }
+
+  //----------------------------------------------------------------------------
+  int ToolPoseBuffer::GetToolIndex(TransformName^ name)
+  {
+    if (name == nullptr)
+    {
+      return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto iter = m_toolIndices.find(MakeToolKey(name->FromId(), name->ToId()));
+    return (iter == m_toolIndices.end()) ? -1 : static_cast<int>(iter->second);
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 ToolPoseBuffer::GetNumberOfTools()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numberOfTools;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ToolPoseBuffer::AddSample(float timestamp, TransformListABI^ transforms)
+  {
+    if (transforms == nullptr)
+    {
+      OutputDebugStringA("ToolPoseBuffer: Cannot add sample, no transforms.");
+      return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    // Register the new tools first, so that the row has room for all of them
+    for (auto transform : transforms)
+    {
+      if (transform->Name != nullptr && transform->Name->IsValid())
+      {
+        AddToolInternal(transform->Name->FromId(), transform->Name->ToId());
+      }
+    }
+
+    uint32 row(0);
+    if (!PrepareRow(timestamp, row))
+    {
+      return false;
+    }
+
+    for (auto transform : transforms)
+    {
+      if (transform->Name == nullptr || !transform->Name->IsValid() || !transform->Valid)
+      {
+        continue;
+      }
+      uint32 tool = m_toolIndices[MakeToolKey(transform->Name->FromId(), transform->Name->ToId())];
+      ToolPose& pose = m_poses[static_cast<size_t>(row) * m_numberOfTools + tool];
+      DecomposeMatrix(transform->Matrix, pose.Scale, pose.Rotation, pose.Translation);
+      SetValid(row, tool);
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ToolPoseBuffer::AddSample(float timestamp, const Platform::Array<float4x4>^ matrices, const Platform::Array<bool>^ valid)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (matrices == nullptr || valid == nullptr || matrices->Length != m_numberOfTools || valid->Length != m_numberOfTools)
+    {
+      std::stringstream ss;
+      ss << "ToolPoseBuffer: Cannot add sample, a matrix and a validity flag is required for each of the " << m_numberOfTools << " tools.";
+      OutputDebugStringA(ss.str().c_str());
+      return false;
+    }
+
+    uint32 row(0);
+    if (!PrepareRow(timestamp, row))
+    {
+      return false;
+    }
+
+    for (uint32 tool = 0; tool < m_numberOfTools; ++tool)
+    {
+      if (!valid[tool])
+      {
+        continue;
+      }
+      ToolPose& pose = m_poses[static_cast<size_t>(row) * m_numberOfTools + tool];
+      DecomposeMatrix(matrices[tool], pose.Scale, pose.Rotation, pose.Translation);
+      SetValid(row, tool);
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // The closest sample (itemA) and the sample on the other side of the requested time (itemB) are the
+  // same for all tools, only the validity bits differ, so they are found once for all tools.
+  uint32 ToolPoseBuffer::GetInterpolatedPoses(float time, Platform::WriteOnlyArray<float4x4>^ outMatrices, Platform::WriteOnlyArray<int>^ outToolStatus)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (outMatrices == nullptr || outToolStatus == nullptr || outMatrices->Length != m_numberOfTools || outToolStatus->Length != m_numberOfTools)
+    {
+      std::stringstream ss;
+      ss << "ToolPoseBuffer: Cannot interpolate poses, the output arrays must have an element for each of the " << m_numberOfTools << " tools.";
+      OutputDebugStringA(ss.str().c_str());
+      return 0;
+    }
+
+    for (uint32 tool = 0; tool < m_numberOfTools; ++tool)
+    {
+      outMatrices[tool] = float4x4::identity();
+      outToolStatus[tool] = TOOL_MISSING;
+    }
+
+    if (m_numberOfSamples == 0)
+    {
+      return 0;
+    }
+
+    // Timestamps are stored in local time, global = local + offset
+    const float localTime = time - m_localTimeOffsetSec;
+
+    // First sample later than the requested time
+    uint32 first(0);
+    uint32 count(m_numberOfSamples);
+    while (count > 0)
+    {
+      uint32 step = count / 2;
+      if (m_timestamps[GetRow(first + step)] <= localTime)
+      {
+        first += step + 1;
+        count -= step + 1;
+      }
+      else
+      {
+        count = step;
+      }
+    }
+
+    // Sample A is the closest sample, sample B is its neighbor on the other side of the requested time
+    const bool hasBefore = first > 0;
+    const bool hasAfter = first < m_numberOfSamples;
+    const bool afterIsClosest = hasAfter && (!hasBefore || m_timestamps[GetRow(first)] - localTime < localTime - m_timestamps[GetRow(first - 1)]);
+    const uint32 rowA = GetRow(afterIsClosest ? first : first - 1);
+    const float timeA = m_timestamps[rowA];
+    const bool hasB = afterIsClosest ? hasBefore : hasAfter;
+    const uint32 rowB = hasB ? GetRow(afterIsClosest ? first - 1 : first) : rowA;
+    const float timeB = m_timestamps[rowB];
+
+    if (fabs(timeA - localTime) > m_maxAllowedTimeDifference)
+    {
+      return 0;
+    }
+    const bool useA = fabs(timeA - localTime) < NEGLIGIBLE_TIME_DIFFERENCE || fabs(timeA - timeB) < NEGLIGIBLE_TIME_DIFFERENCE;
+    const bool interpolate = !useA && hasB && fabs(timeB - localTime) <= m_maxAllowedTimeDifference;
+    const float weightB = interpolate ? (localTime - timeA) / (timeB - timeA) : 0.f;
+
+    uint32 numberOfValidTools(0);
+    for (uint32 tool = 0; tool < m_numberOfTools; ++tool)
+    {
+      if (!IsValid(rowA, tool))
+      {
+        continue;
+      }
+
+      const ToolPose& poseA = m_poses[static_cast<size_t>(rowA) * m_numberOfTools + tool];
+      if (useA)
+      {
+        outMatrices[tool] = ComposeMatrix(poseA.Scale, poseA.Rotation, poseA.Translation);
+      }
+      else if (interpolate && IsValid(rowB, tool))
+      {
+        const ToolPose& poseB = m_poses[static_cast<size_t>(rowB) * m_numberOfTools + tool];
+        ToolPose interpolatedPose;
+        outMatrices[tool] = InterpolateDecomposedMatrix(poseA.Scale, poseA.Rotation, poseA.Translation, poseB.Scale, poseB.Rotation, poseB.Translation, weightB,
+                            interpolatedPose.Scale, interpolatedPose.Rotation, interpolatedPose.Translation);
+      }
+      else
+      {
+        continue;
+      }
+
+      outToolStatus[tool] = TOOL_OK;
+      ++numberOfValidTools;
+    }
+
+    return numberOfValidTools;
+  }
+
+  //----------------------------------------------------------------------------
+  int ToolPoseBuffer::GetLatestTimeStamp(float* outLatestTimestamp)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_numberOfSamples == 0)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    *outLatestTimestamp = m_timestamps[GetRow(m_numberOfSamples - 1)] + m_localTimeOffsetSec;
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  int ToolPoseBuffer::GetOldestTimeStamp(float* outOldestTimestamp)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_numberOfSamples == 0)
+    {
+      return ITEM_NOT_AVAILABLE_YET;
+    }
+    *outOldestTimestamp = m_timestamps[GetRow(0)] + m_localTimeOffsetSec;
+    return ITEM_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  void ToolPoseBuffer::SetLocalTimeOffsetSec(float offsetSec)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_localTimeOffsetSec = offsetSec;
+  }
+
+  //----------------------------------------------------------------------------
+  float ToolPoseBuffer::GetLocalTimeOffsetSec()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_localTimeOffsetSec;
+  }
+
+  //----------------------------------------------------------------------------
+  void ToolPoseBuffer::SetMaxAllowedTimeDifference(float maxAllowedTimeDifference)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_maxAllowedTimeDifference = maxAllowedTimeDifference;
+  }
+
+  //----------------------------------------------------------------------------
+  float ToolPoseBuffer::GetMaxAllowedTimeDifference()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_maxAllowedTimeDifference;
+  }
+
+  //----------------------------------------------------------------------------
+  void ToolPoseBuffer::Clear()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_numberOfSamples = 0;
+    m_writePointer = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 ToolPoseBuffer::AddToolInternal(CoordinateFrameId from, CoordinateFrameId to)
+  {
+    auto iter = m_toolIndices.find(MakeToolKey(from, to));
+    if (iter != m_toolIndices.end())
+    {
+      return iter->second;
+    }
+
+    uint32 toolIndex = m_numberOfTools;
+    ResizeRows(m_numberOfTools + 1);
+    m_toolIndices[MakeToolKey(from, to)] = toolIndex;
+    return toolIndex;
+  }
+
+  //----------------------------------------------------------------------------
+  void ToolPoseBuffer::ResizeRows(uint32 numberOfTools)
+  {
+    const uint32 validityWordsPerRow = (numberOfTools + 63) / 64;
+    std::vector<uint64> validity(static_cast<size_t>(m_bufferSize) * validityWordsPerRow, 0);
+    std::vector<ToolPose> poses(static_cast<size_t>(m_bufferSize) * numberOfTools, ToolPose());
+
+    const uint32 copiedTools = (std::min)(numberOfTools, m_numberOfTools);
+    const uint32 copiedWords = (std::min)(validityWordsPerRow, m_validityWordsPerRow);
+    for (uint32 row = 0; row < m_bufferSize; ++row)
+    {
+      std::copy_n(m_poses.begin() + static_cast<size_t>(row) * m_numberOfTools, copiedTools, poses.begin() + static_cast<size_t>(row) * numberOfTools);
+      std::copy_n(m_validity.begin() + static_cast<size_t>(row) * m_validityWordsPerRow, copiedWords, validity.begin() + static_cast<size_t>(row) * validityWordsPerRow);
+    }
+
+    m_validity.swap(validity);
+    m_poses.swap(poses);
+    m_numberOfTools = numberOfTools;
+    m_validityWordsPerRow = validityWordsPerRow;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ToolPoseBuffer::PrepareRow(float timestamp, uint32& outRow)
+  {
+    if (m_numberOfSamples > 0 && timestamp <= m_timestamps[GetRow(m_numberOfSamples - 1)])
+    {
+      std::stringstream ss;
+      ss << "ToolPoseBuffer: Need to skip newly added sample, the timestamp is not later than the latest sample (" << std::fixed << timestamp << " <= " << m_timestamps[GetRow(m_numberOfSamples - 1)] << ")";
+      OutputDebugStringA(ss.str().c_str());
+      return false;
+    }
+
+    outRow = m_writePointer;
+    m_timestamps[outRow] = timestamp;
+    std::fill_n(m_validity.begin() + static_cast<size_t>(outRow) * m_validityWordsPerRow, m_validityWordsPerRow, 0);
+
+    m_writePointer = (m_writePointer + 1) % m_bufferSize;
+    if (m_numberOfSamples < m_bufferSize)
+    {
+      ++m_numberOfSamples;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 ToolPoseBuffer::GetRow(uint32 sampleIndex)
+  {
+    return (m_writePointer + m_bufferSize - m_numberOfSamples + sampleIndex) % m_bufferSize;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ToolPoseBuffer::IsValid(uint32 row, uint32 tool)
+  {
+    return (m_validity[static_cast<size_t>(row) * m_validityWordsPerRow + tool / 64] >> (tool % 64) & 1) != 0;
+  }
+
+  //----------------------------------------------------------------------------
+  void ToolPoseBuffer::SetValid(uint32 row, uint32 tool)
+  {
+    m_validity[static_cast<size_t>(row) * m_validityWordsPerRow + tool / 64] |= static_cast<uint64>(1) << (tool % 64);
+  }
+}
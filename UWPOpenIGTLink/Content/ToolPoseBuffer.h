@@ -0,0 +1,136 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+#include "Transform.h"
+#include "TransformName.h"
+
+// STL includes
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    Circular buffer of tracker samples, where each sample holds the poses of all tools (e.g. all elements of a TDATA message).
+    The timestamps form a single time index shared by all tools, so a temporal query costs one search for all tools.
+    Each sample is a row of decomposed poses (one per tool) with a validity bit per tool.
+    The interpolation follows the same rules as Buffer::GetStreamBufferItemFromTime with INTERPOLATED.
+  */
+  public ref class ToolPoseBuffer sealed
+  {
+  public:
+    ToolPoseBuffer();
+    virtual ~ToolPoseBuffer();
+
+    /*! Set the maximum number of samples in the buffer, removes all samples */
+    bool SetBufferSize(uint32 numberOfSamples);
+    /*! Get the maximum number of samples in the buffer */
+    uint32 GetBufferSize();
+    /*! Get the number of samples in the buffer */
+    uint32 GetNumberOfSamples();
+
+    /*!
+      Register a tool and return its index (the index of its pose in the query results).
+      Returns the existing index if the tool is already registered. Samples already in the buffer are kept, with the new tool invalid.
+    */
+    uint32 AddTool(TransformName^ name);
+    /*! Get the index of a tool, -1 if the tool is not registered */
+    int GetToolIndex(TransformName^ name);
+    /*! Get the number of registered tools */
+    uint32 GetNumberOfTools();
+
+    /*!
+      Add a sample with the transforms of a TDATA message, unknown tools are registered.
+      Tools that are not in the list or have an invalid transform are marked invalid in this sample.
+      If the timestamp is not later than the latest sample then nothing is added.
+    */
+    bool AddSample(float timestamp, TransformListABI^ transforms);
+    /*!
+      Add a sample with the matrices of all registered tools, in tool index order.
+      If the timestamp is not later than the latest sample then nothing is added.
+    */
+    bool AddSample(float timestamp, const Platform::Array<Windows::Foundation::Numerics::float4x4>^ matrices, const Platform::Array<bool>^ valid);
+
+    /*!
+      Interpolate the pose of every tool at the requested time with a single search of the shared time index.
+      The output arrays must have GetNumberOfTools() elements. Tools that cannot be interpolated get TOOL_MISSING status.
+      \return the number of tools with TOOL_OK status
+    */
+    uint32 GetInterpolatedPoses(float time,
+                                Platform::WriteOnlyArray<Windows::Foundation::Numerics::float4x4>^ outMatrices,
+                                Platform::WriteOnlyArray<int>^ outToolStatus);
+
+    /*! Get latest sample timestamp in the buffer */
+    int GetLatestTimeStamp(float* outLatestTimestamp);
+    /*! Get oldest sample timestamp in the buffer */
+    int GetOldestTimeStamp(float* outOldestTimestamp);
+
+    /*! Set the local time offset in seconds (global = local + offset) */
+    void SetLocalTimeOffsetSec(float offsetSec);
+    /*! Get the local time offset in seconds (global = local + offset) */
+    float GetLocalTimeOffsetSec();
+
+    /*! Set maximum allowed time difference in seconds between the desired and the closest valid timestamp */
+    void SetMaxAllowedTimeDifference(float maxAllowedTimeDifference);
+    /*! Get maximum allowed time difference in seconds between the desired and the closest valid timestamp */
+    float GetMaxAllowedTimeDifference();
+
+    /*! Remove all samples, the registered tools are kept */
+    void Clear();
+
+  protected private:
+    /// Register a tool by its interned coordinate frame ids, caller must hold m_mutex
+    uint32 AddToolInternal(CoordinateFrameId from, CoordinateFrameId to);
+    /// Change the number of tools per sample keeping the samples, caller must hold m_mutex
+    void ResizeRows(uint32 numberOfTools);
+    /// Claim the next row for a new sample (all tools invalid), returns false if the timestamp is not increasing, caller must hold m_mutex
+    bool PrepareRow(float timestamp, uint32& outRow);
+    /// Physical row of the i-th oldest sample
+    uint32 GetRow(uint32 sampleIndex);
+    bool IsValid(uint32 row, uint32 tool);
+    void SetValid(uint32 row, uint32 tool);
+
+  protected private:
+    std::mutex                            m_mutex;
+    uint32                                m_bufferSize = 0;
+    uint32                                m_numberOfSamples = 0;
+    uint32                                m_writePointer = 0;
+    uint32                                m_numberOfTools = 0;
+    uint32                                m_validityWordsPerRow = 0;
+    float                                 m_localTimeOffsetSec = 0.f;
+    float                                 m_maxAllowedTimeDifference = 0.5f;
+
+    std::vector<float>                    m_timestamps;     // shared time index, one entry per row
+    std::vector<uint64>                   m_validity;       // m_validityWordsPerRow words per row, bit per tool
+    std::vector<ToolPose>                 m_poses;          // m_numberOfTools poses per row
+    std::unordered_map<uint64, uint32>    m_toolIndices;    // (from id, to id) -> tool index
+  };
+}
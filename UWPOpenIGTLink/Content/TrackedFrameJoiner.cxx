@@ -0,0 +1,278 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#include "pch.h"
+#include "TrackedFrameJoiner.h"
+#include "Transform.h"
+
+// STL includes
+#include <algorithm>
+#include <sstream>
+
+using namespace Windows::Foundation::Numerics;
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  uint64 MakeToolKey(UWPOpenIGTLink::CoordinateFrameId from, UWPOpenIGTLink::CoordinateFrameId to)
+  {
+    return (static_cast<uint64>(from) << 32) | to;
+  }
+}
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  TrackedFrameJoiner::TrackedFrameJoiner(Buffer^ imageBuffer)
+    : m_imageBuffer(imageBuffer)
+  {
+    if (imageBuffer == nullptr)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Null image buffer sent to TrackedFrameJoiner.");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  TrackedFrameJoiner::~TrackedFrameJoiner()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameJoiner::SetToolBuffer(TransformName^ name, Buffer^ poseBuffer)
+  {
+    if (name == nullptr)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Null transform name sent to SetToolBuffer.");
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (poseBuffer == nullptr)
+    {
+      m_tools.erase(MakeToolKey(name->FromId(), name->ToId()));
+      return;
+    }
+
+    ToolEntry& entry = m_tools[MakeToolKey(name->FromId(), name->ToId())];
+    entry.Name = name;
+    entry.PoseBuffer = poseBuffer;
+  }
+
+  //----------------------------------------------------------------------------
+  Buffer^ TrackedFrameJoiner::GetToolBuffer(TransformName^ name)
+  {
+    if (name == nullptr)
+    {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto iter = m_tools.find(MakeToolKey(name->FromId(), name->ToId()));
+    return iter == m_tools.end() ? nullptr : iter->second.PoseBuffer;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 TrackedFrameJoiner::GetNumberOfTools()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return static_cast<uint32>(m_tools.size());
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameJoiner::SetMaximumWaitSec(float waitSec)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_maximumWaitSec = (std::max)(waitSec, 0.f);
+  }
+
+  //----------------------------------------------------------------------------
+  float TrackedFrameJoiner::GetMaximumWaitSec()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_maximumWaitSec;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 TrackedFrameJoiner::Process()
+  {
+    std::vector<TrackedFrame^> joinedFrames;
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      if (m_imageBuffer->GetNumberOfItems() == 0)
+      {
+        return 0;
+      }
+
+      const double now = GetMonotonicTimeSec();
+      const BufferItemUidType oldestUid = m_imageBuffer->GetOldestItemUidInBuffer();
+      const BufferItemUidType latestUid = m_imageBuffer->GetLatestItemUidInBuffer();
+      if (m_hasSeenImage && (latestUid < m_lastSeenUid || (m_hasJoinedImage && latestUid < m_lastJoinedUid)))
+      {
+        // The image buffer was cleared and its uids restarted, start over from its oldest image
+        m_hasJoinedImage = false;
+        m_lastJoinedUid = 0;
+        m_hasSeenImage = false;
+        m_lastSeenUid = 0;
+        m_firstSeenTimes.clear();
+      }
+      if (!m_hasSeenImage || latestUid > m_lastSeenUid)
+      {
+        m_firstSeenTimes.push_back(std::make_pair(latestUid, now));
+        m_lastSeenUid = latestUid;
+        m_hasSeenImage = true;
+      }
+
+      BufferItemUidType uid = m_hasJoinedImage ? m_lastJoinedUid + 1 : oldestUid;
+      if (uid < oldestUid)
+      {
+        m_numberOfDroppedImages += oldestUid - uid;
+        uid = oldestUid;
+      }
+
+      for (; uid <= latestUid; ++uid)
+      {
+        // Pinned, so the item cannot be overwritten while it is joined
+        StreamBufferItem^ imageItem = m_imageBuffer->PinStreamBufferItem(uid);
+        if (imageItem == nullptr)
+        {
+          m_numberOfDroppedImages++;
+          m_lastJoinedUid = uid;
+          m_hasJoinedImage = true;
+          continue;
+        }
+        const float timestamp = imageItem->GetFilteredTimestamp(m_imageBuffer->GetLocalTimeOffsetSec());
+
+        bool posesAvailable(true);
+        for (auto& pair : m_tools)
+        {
+          float latestPoseTimestamp(0.f);
+          if (pair.second.PoseBuffer->GetLatestTimeStamp(&latestPoseTimestamp) != ITEM_OK || latestPoseTimestamp < timestamp)
+          {
+            posesAvailable = false;
+            break;
+          }
+        }
+
+        bool timedOut(false);
+        if (!posesAvailable)
+        {
+          double firstSeenTime = now;
+          for (auto& entry : m_firstSeenTimes)
+          {
+            if (entry.first >= uid)
+            {
+              firstSeenTime = entry.second;
+              break;
+            }
+          }
+          timedOut = now - firstSeenTime >= m_maximumWaitSec;
+          if (!timedOut)
+          {
+            // Later images are not joined before this one
+            m_imageBuffer->UnpinStreamBufferItem(imageItem);
+            break;
+          }
+          m_numberOfLateFrames++;
+        }
+
+        joinedFrames.push_back(JoinImage(imageItem, timestamp, timedOut));
+        m_imageBuffer->UnpinStreamBufferItem(imageItem);
+        m_lastJoinedUid = uid;
+        m_hasJoinedImage = true;
+      }
+
+      while (m_hasJoinedImage && !m_firstSeenTimes.empty() && m_firstSeenTimes.front().first <= m_lastJoinedUid)
+      {
+        m_firstSeenTimes.pop_front();
+      }
+    }
+
+    for (auto frame : joinedFrames)
+    {
+      TrackedFrameJoined(this, frame);
+    }
+    return static_cast<uint32>(joinedFrames.size());
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 TrackedFrameJoiner::GetNumberOfDroppedImages()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numberOfDroppedImages;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 TrackedFrameJoiner::GetNumberOfLateFrames()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_numberOfLateFrames;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameJoiner::Reset()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_hasJoinedImage = false;
+    m_lastJoinedUid = 0;
+    m_hasSeenImage = false;
+    m_lastSeenUid = 0;
+    m_firstSeenTimes.clear();
+    m_numberOfDroppedImages = 0;
+    m_numberOfLateFrames = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  TrackedFrame^ TrackedFrameJoiner::JoinImage(StreamBufferItem^ imageItem, float timestamp, bool timedOut)
+  {
+    auto frame = ref new TrackedFrame();
+
+    // The image is shared, the buffer gives the slot a new image when it is overwritten
+    VideoFrame^ videoFrame = imageItem->GetFrame();
+    frame->Frame->ShallowCopy(videoFrame->Image, videoFrame->Orientation, videoFrame->Type);
+    frame->Timestamp = timestamp;
+
+    for (auto& pair : imageItem->GetCustomFrameFields())
+    {
+      frame->SetFrameField(pair.first, pair.second);
+    }
+
+    // Within the buffered poses EXTRAPOLATED interpolates, so it only differs for the tools that timed out
+    const int interpolation = timedOut ? EXTRAPOLATED : INTERPOLATED;
+    for (auto& pair : m_tools)
+    {
+      StreamBufferItem^ poseItem = pair.second.PoseBuffer->GetStreamBufferItemFromTime(timestamp, interpolation);
+      const bool valid = poseItem != nullptr && poseItem->GetStatus() == TOOL_OK;
+      if (!valid)
+      {
+        std::wstringstream ss;
+        ss << L"TrackedFrameJoiner: No valid pose of " << pair.first << L" at time " << std::fixed << timestamp << L", the transform is marked invalid.";
+        OutputDebugStringW(ss.str().c_str());
+      }
+      frame->SetTransform(ref new Transform(pair.second.Name, poseItem == nullptr ? float4x4::identity() : poseItem->GetMatrix(), valid, timestamp));
+    }
+
+    return frame;
+  }
+}
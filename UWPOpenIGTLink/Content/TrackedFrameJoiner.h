@@ -0,0 +1,116 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+#pragma once
+
+// Local includes
+#include "Buffer.h"
+#include "IGTCommon.h"
+#include "StreamBufferItem.h"
+#include "TrackedFrame.h"
+#include "TransformName.h"
+
+// STL includes
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  ref class TrackedFrameJoiner;
+  public delegate void TrackedFrameJoinedHandler(TrackedFrameJoiner^ sender, TrackedFrame^ frame);
+
+  /*!
+    Joins the images of a buffer with the poses of per-tool buffers into tracked frames, for servers that send IMAGE plus
+    TRANSFORM/TDATA instead of TRACKEDFRAME (e.g. the ingest buffers of IGTClient).
+    The images are joined in order. An image is joined as soon as every tool buffer has a pose at or after its timestamp
+    (the samples bracketing the image exist), with the poses interpolated to the image timestamp.
+    An image waits at most MaximumWaitSec from when it was first seen, then it is joined with the poses extrapolated from
+    the available samples (invalid transforms where that is not possible either).
+    The buffers must share the global time domain (see Buffer::SetLocalTimeOffsetSec).
+  */
+  public ref class TrackedFrameJoiner sealed
+  {
+  public:
+    TrackedFrameJoiner(Buffer^ imageBuffer);
+    virtual ~TrackedFrameJoiner();
+
+    /// Raised by Process for each joined frame, on the thread that calls Process
+    event TrackedFrameJoinedHandler^ TrackedFrameJoined;
+
+    /// Set the pose buffer of a tool, replaces the buffer of a tool with the same name (nullptr removes the tool)
+    void SetToolBuffer(TransformName^ name, Buffer^ poseBuffer);
+    Buffer^ GetToolBuffer(TransformName^ name);
+    uint32 GetNumberOfTools();
+
+    /// Set the maximum time in seconds an image waits for its poses (default 0.1)
+    void SetMaximumWaitSec(float waitSec);
+    float GetMaximumWaitSec();
+
+    /*!
+      Join the images that are ready, raising TrackedFrameJoined for each, and return the number of joined frames.
+      Call whenever new data has arrived (IGTClient does after each received message, see IGTClient::SetTrackedFrameJoiner)
+      or periodically, the wait limit is checked by this call. After the image buffer is cleared, joining restarts from its oldest image.
+    */
+    uint32 Process();
+
+    /// Number of images overwritten in the image buffer before they could be joined
+    uint64 GetNumberOfDroppedImages();
+    /// Number of frames joined after the wait limit, with extrapolated poses
+    uint64 GetNumberOfLateFrames();
+
+    /// Forget the progress and statistics, the next Process starts from the oldest image in the buffer
+    void Reset();
+
+  protected private:
+    /// Build the tracked frame of an image, caller must hold m_mutex
+    TrackedFrame^ JoinImage(StreamBufferItem^ imageItem, float timestamp, bool timedOut);
+
+  protected private:
+    struct ToolEntry
+    {
+      TransformName^  Name = nullptr;
+      Buffer^         PoseBuffer = nullptr;
+    };
+
+    std::mutex                                          m_mutex;
+    Buffer^                                             m_imageBuffer;
+    std::map<uint64, ToolEntry>                         m_tools;          // (from id, to id) -> tool
+    float                                               m_maximumWaitSec = 0.1f;
+
+    bool                                                m_hasJoinedImage = false;
+    BufferItemUidType                                   m_lastJoinedUid = 0;
+    bool                                                m_hasSeenImage = false;
+    BufferItemUidType                                   m_lastSeenUid = 0;
+    // Latest image uid and the monotonic time of each Process call that saw new images, the first seen time of an image is
+    // the time of the first entry at or after its uid
+    std::deque<std::pair<BufferItemUidType, double>>    m_firstSeenTimes;
+
+    uint64                                              m_numberOfDroppedImages = 0;
+    uint64                                              m_numberOfLateFrames = 0;
+  };
+}
@@ -31,8 +31,159 @@ OTHER DEALINGS IN THE SOFTWARE.
 // std includes
 #include <sstream>
 
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Check if the input string is capitalized, if not capitalize it
+  void Capitalize(std::wstring& aString)
+  {
+    // Change first character to uppercase
+    if (aString.length() < 1)
+    {
+      return;
+    }
+    aString[0] = toupper(aString[0]);
+  }
+
+  //----------------------------------------------------------------------------
+  // Split a combined [FrameFrom]To[FrameTo] name into its coordinate frame names, throws if invalid
+  void SplitTransformName(const std::wstring& transformNameStr, std::wstring& outFrom, std::wstring& outTo)
+  {
+    size_t posTo = std::wstring::npos;
+
+    // Check if the string has only one valid 'To' phrase
+    int numOfMatch = 0;
+    std::wstring subString = transformNameStr;
+    size_t posToTested = std::wstring::npos;
+    size_t numberOfRemovedChars = 0;
+    while (((posToTested = subString.find(L"To")) != std::wstring::npos) && (subString.length() > posToTested + 2))
+    {
+      if (toupper(subString[posToTested + 2]) == subString[posToTested + 2])
+      {
+        // there is a "To", and after that the next letter is uppercase, so it's really a match (e.g., the first To in TestToolToTracker would not be a real match)
+        numOfMatch++;
+        posTo = numberOfRemovedChars + posToTested;
+      }
+      // search in the rest of the string
+      subString = subString.substr(posToTested + 2);
+      numberOfRemovedChars += posToTested + 2;
+    }
+
+    Platform::String^ aTransformName = ref new Platform::String(transformNameStr.c_str());
+    if (numOfMatch != 1)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Unable to parse transform name, there are " + numOfMatch + L" matching 'To' phrases in the transform name '" + aTransformName + L"', while exactly one allowed.");
+    }
+
+    // Find <FrameFrom>To<FrameTo> matches
+    if (posTo == std::wstring::npos)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Failed to set transform name - unable to find 'To' in '" + aTransformName + L"'!");
+    }
+    else if (posTo == 0)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Failed to set transform name - no coordinate frame name before 'To' in '" + aTransformName + L"'!");
+    }
+    else if (posTo == transformNameStr.length() - 2)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Failed to set transform name - no coordinate frame name after 'To' in '" + aTransformName + L"'!");
+    }
+
+    // Set From coordinate frame name
+    outFrom = transformNameStr.substr(0, posTo);
+
+    // Allow handling of To coordinate frame containing "Transform"
+    std::wstring postFrom(transformNameStr.substr(posTo + 2));
+    if (postFrom.find(L"Transform") != std::wstring::npos)
+    {
+      postFrom = postFrom.substr(0, postFrom.find(L"Transform"));
+    }
+
+    outTo = postFrom;
+  }
+}
+
 namespace UWPOpenIGTLink
 {
+  //-------------------------------------------------------
+  CoordinateFrameTable& CoordinateFrameTable::Instance()
+  {
+    static CoordinateFrameTable table;
+    return table;
+  }
+
+  //-------------------------------------------------------
+  CoordinateFrameTable::CoordinateFrameTable()
+  {
+  }
+
+  //-------------------------------------------------------
+  CoordinateFrameId CoordinateFrameTable::Intern(const std::wstring& frameName)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return InternInternal(frameName);
+  }
+
+  //-------------------------------------------------------
+  CoordinateFrameId CoordinateFrameTable::InternInternal(const std::wstring& frameName)
+  {
+    // the caller must have locked the table
+    if (frameName.empty())
+    {
+      return INVALID_COORDINATE_FRAME_ID;
+    }
+
+    std::wstring capitalizedName(frameName);
+    Capitalize(capitalizedName);
+
+    auto iter = m_frameIds.find(capitalizedName);
+    if (iter != m_frameIds.end())
+    {
+      return iter->second;
+    }
+
+    m_frameNames.push_back(capitalizedName);
+    CoordinateFrameId id = static_cast<CoordinateFrameId>(m_frameNames.size());
+    m_frameIds[capitalizedName] = id;
+    return id;
+  }
+
+  //-------------------------------------------------------
+  const std::wstring& CoordinateFrameTable::GetName(CoordinateFrameId id) const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (id == INVALID_COORDINATE_FRAME_ID || id > m_frameNames.size())
+    {
+      return m_emptyName;
+    }
+    return m_frameNames[id - 1];
+  }
+
+  //-------------------------------------------------------
+  void CoordinateFrameTable::ParseTransformName(const std::wstring& transformName, CoordinateFrameId& outFrom, CoordinateFrameId& outTo)
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      auto iter = m_parsedTransformNames.find(transformName);
+      if (iter != m_parsedTransformNames.end())
+      {
+        outFrom = iter->second.first;
+        outTo = iter->second.second;
+        return;
+      }
+    }
+
+    // Parse outside of the lock, invalid names throw and are not cached
+    std::wstring fromStr;
+    std::wstring toStr;
+    SplitTransformName(transformName, fromStr, toStr);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    outFrom = InternInternal(fromStr);
+    outTo = InternInternal(toStr);
+    m_parsedTransformNames[transformName] = FramePair(outFrom, outTo);
+  }
+
   //-------------------------------------------------------
   TransformName::TransformName()
   {
@@ -56,11 +207,8 @@ namespace UWPOpenIGTLink
   //-------------------------------------------------------
   TransformName::TransformName(Platform::String^ aFrom, Platform::String^ aTo)
   {
-    m_From = std::wstring(aFrom->Data());
-    Capitalize(m_From);
-
-    m_To = std::wstring(aTo->Data());
-    Capitalize(m_To);
+    m_From = CoordinateFrameTable::Instance().Intern(std::wstring(aFrom->Data()));
+    m_To = CoordinateFrameTable::Instance().Intern(std::wstring(aTo->Data()));
   }
 
   //-------------------------------------------------------
@@ -72,11 +220,8 @@ namespace UWPOpenIGTLink
   //-------------------------------------------------------
   TransformName::TransformName(const std::wstring& aFrom, const std::wstring& aTo)
   {
-    m_From = aFrom;
-    Capitalize(m_From);
-
-    m_To = aTo;
-    Capitalize(m_To);
+    m_From = CoordinateFrameTable::Instance().Intern(aFrom);
+    m_To = CoordinateFrameTable::Instance().Intern(aTo);
   }
 
   //-------------------------------------------------------
@@ -85,15 +230,22 @@ namespace UWPOpenIGTLink
     SetTransformName(transformName);
   }
 
+  //-------------------------------------------------------
+  TransformName::TransformName(CoordinateFrameId aFrom, CoordinateFrameId aTo)
+    : m_From(aFrom)
+    , m_To(aTo)
+  {
+  }
+
   //-------------------------------------------------------
   bool TransformName::IsValid()
   {
-    if (m_From.empty())
+    if (m_From == INVALID_COORDINATE_FRAME_ID)
     {
       return false;
     }
 
-    if (m_To.empty())
+    if (m_To == INVALID_COORDINATE_FRAME_ID)
     {
       return false;
     }
@@ -104,121 +256,70 @@ namespace UWPOpenIGTLink
   //-------------------------------------------------------
   void TransformName::SetTransformName(Platform::String^ aTransformName)
   {
-    m_From.clear();
-    m_To.clear();
-
-    size_t posTo = std::wstring::npos;
-
-    // Check if the string has only one valid 'To' phrase
-    int numOfMatch = 0;
-    std::wstring transformNameStr = std::wstring(aTransformName->Data());
-    std::wstring subString = transformNameStr;
-    size_t posToTested = std::wstring::npos;
-    size_t numberOfRemovedChars = 0;
-    while (((posToTested = subString.find(L"To")) != std::wstring::npos) && (subString.length() > posToTested + 2))
-    {
-      if (toupper(subString[posToTested + 2]) == subString[posToTested + 2])
-      {
-        // there is a "To", and after that the next letter is uppercase, so it's really a match (e.g., the first To in TestToolToTracker would not be a real match)
-        numOfMatch++;
-        posTo = numberOfRemovedChars + posToTested;
-      }
-      // search in the rest of the string
-      subString = subString.substr(posToTested + 2);
-      numberOfRemovedChars += posToTested + 2;
-    }
-
-    if (numOfMatch != 1)
-    {
-      throw ref new Platform::Exception(E_INVALIDARG, L"Unable to parse transform name, there are " + numOfMatch + L" matching 'To' phrases in the transform name '" + aTransformName + L"', while exactly one allowed.");
-    }
-
-    // Find <FrameFrom>To<FrameTo> matches
-    if (posTo == std::wstring::npos)
-    {
-      throw ref new Platform::Exception(E_INVALIDARG, L"Failed to set transform name - unable to find 'To' in '" + aTransformName + L"'!");
-    }
-    else if (posTo == 0)
-    {
-      throw ref new Platform::Exception(E_INVALIDARG, L"Failed to set transform name - no coordinate frame name before 'To' in '" + aTransformName + L"'!");
-    }
-    else if (posTo == transformNameStr.length() - 2)
-    {
-      throw ref new Platform::Exception(E_INVALIDARG, L"Failed to set transform name - no coordinate frame name after 'To' in '" + aTransformName + L"'!");
-    }
-
-    // Set From coordinate frame name
-    m_From = transformNameStr.substr(0, posTo);
-
-    // Allow handling of To coordinate frame containing "Transform"
-    std::wstring postFrom(transformNameStr.substr(posTo + 2));
-    if (postFrom.find(L"Transform") != std::wstring::npos)
-    {
-      postFrom = postFrom.substr(0, postFrom.find(L"Transform"));
-    }
-
-    m_To = postFrom;
-    Capitalize(m_From);
-    Capitalize(m_To);
+    SetTransformName(std::wstring(aTransformName->Data()));
   }
 
   //----------------------------------------------------------------------------
   void TransformName::SetTransformName(const std::wstring& aTransformName)
   {
-    SetTransformName(ref new Platform::String(aTransformName.c_str()));
+    m_From = INVALID_COORDINATE_FRAME_ID;
+    m_To = INVALID_COORDINATE_FRAME_ID;
+
+    CoordinateFrameTable::Instance().ParseTransformName(aTransformName, m_From, m_To);
   }
 
   //----------------------------------------------------------------------------
   std::wstring TransformName::GetTransformNameInternal()
   {
-    return m_From + L"To" + m_To;
+    return FromInternal() + L"To" + ToInternal();
   }
 
   //----------------------------------------------------------------------------
   std::wstring TransformName::ToInternal() const
   {
-    return m_To;
+    return CoordinateFrameTable::Instance().GetName(m_To);
   }
 
   //----------------------------------------------------------------------------
   std::wstring TransformName::FromInternal() const
+  {
+    return CoordinateFrameTable::Instance().GetName(m_From);
+  }
+
+  //----------------------------------------------------------------------------
+  CoordinateFrameId TransformName::FromId() const
   {
     return m_From;
   }
 
-  //-------------------------------------------------------
-  Platform::String^ TransformName::GetTransformName()
+  //----------------------------------------------------------------------------
+  CoordinateFrameId TransformName::ToId() const
   {
-    return ref new Platform::String((m_From + std::wstring(L"To") + m_To).c_str());
+    return m_To;
   }
 
   //-------------------------------------------------------
-  Platform::String^ TransformName::From()
+  Platform::String^ TransformName::GetTransformName()
   {
-    return ref new Platform::String(m_From.c_str());
+    return ref new Platform::String(GetTransformNameInternal().c_str());
   }
 
   //-------------------------------------------------------
-  Platform::String^ TransformName::To()
+  Platform::String^ TransformName::From()
   {
-    return ref new Platform::String(m_To.c_str());
+    return ref new Platform::String(CoordinateFrameTable::Instance().GetName(m_From).c_str());
   }
 
   //-------------------------------------------------------
-  void TransformName::Capitalize(std::wstring& aString)
+  Platform::String^ TransformName::To()
   {
-    // Change first character to uppercase
-    if (aString.length() < 1)
-    {
-      return;
-    }
-    aString[0] = toupper(aString[0]);
+    return ref new Platform::String(CoordinateFrameTable::Instance().GetName(m_To).c_str());
   }
 
   //-------------------------------------------------------
   void TransformName::Clear()
   {
-    m_From = L"";
-    m_To = L"";
+    m_From = INVALID_COORDINATE_FRAME_ID;
+    m_To = INVALID_COORDINATE_FRAME_ID;
   }
-}
\ No newline at end of file
+}
@@ -27,10 +27,52 @@ OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 // std includes
+#include <deque>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace UWPOpenIGTLink
 {
+  typedef uint32 CoordinateFrameId;
+  static const CoordinateFrameId INVALID_COORDINATE_FRAME_ID = 0;
+
+  /*
+  Process-wide table of interned coordinate frame names.
+  Each unique (capitalized) coordinate frame name is assigned a compact integer id the first time it is seen.
+  Combined transform names ([From]To[To] or [From]To[To]Transform) are parsed once and the resulting id pair
+  is cached, so repeated lookups of the same name (e.g. every TDATA element) cost a single hash lookup.
+  Ids are never released, they are valid for the lifetime of the process.
+  */
+  class CoordinateFrameTable
+  {
+  public:
+    static CoordinateFrameTable& Instance();
+
+    /// Return the id of the coordinate frame name, interning it if it has not been seen before
+    CoordinateFrameId Intern(const std::wstring& frameName);
+
+    /// Return the coordinate frame name of an id, empty string if the id is unknown
+    const std::wstring& GetName(CoordinateFrameId id) const;
+
+    /// Parse a combined transform name into its interned 'From' and 'To' ids. Throws if the name is invalid.
+    void ParseTransformName(const std::wstring& transformName, CoordinateFrameId& outFrom, CoordinateFrameId& outTo);
+
+  protected:
+    CoordinateFrameTable();
+
+    CoordinateFrameId InternInternal(const std::wstring& frameName);
+
+  protected:
+    typedef std::pair<CoordinateFrameId, CoordinateFrameId> FramePair;
+
+    mutable std::mutex                                    m_mutex;
+    std::unordered_map<std::wstring, CoordinateFrameId>   m_frameIds;
+    std::deque<std::wstring>                              m_frameNames; // index is id - 1, deque keeps references stable
+    std::unordered_map<std::wstring, FramePair>           m_parsedTransformNames;
+    std::wstring                                          m_emptyName;
+  };
+
   /*
   The TransformName stores and generates the from and to coordinate frame names for transforms.
   To enable robust serialization to/from a simple string (...To...Transform), the coordinate frame names must
@@ -92,6 +134,7 @@ namespace UWPOpenIGTLink
   internal:
     TransformName(const std::wstring& aFrom, const std::wstring& aTo);
     TransformName(const std::wstring& transformName);
+    TransformName(CoordinateFrameId aFrom, CoordinateFrameId aTo);
     void SetTransformName(const std::wstring& aTransformName);
 
     std::wstring GetTransformNameInternal();
@@ -99,17 +142,16 @@ namespace UWPOpenIGTLink
     std::wstring ToInternal() const;
     std::wstring FromInternal() const;
 
-  protected private:
-    /// Check if the input string is capitalized, if not capitalize it
-    void Capitalize(std::wstring& aString);
+    /// Interned ids of the coordinate frames, cheap to compare and to use as lookup keys
+    CoordinateFrameId FromId() const;
+    CoordinateFrameId ToId() const;
 
-  internal:
     bool operator==(const TransformName^ other);
 
   protected private:
-    /// From coordinate frame name
-    std::wstring m_From;
-    /// To coordinate frame name
-    std::wstring m_To;
+    /// From coordinate frame id
+    CoordinateFrameId m_From = INVALID_COORDINATE_FRAME_ID;
+    /// To coordinate frame id
+    CoordinateFrameId m_To = INVALID_COORDINATE_FRAME_ID;
   };
 }
\ No newline at end of file
@@ -140,14 +140,17 @@ namespace UWPOpenIGTLink
   }
 
   //----------------------------------------------------------------------------
-  TransformInfo^ TransformRepository::GetOriginalTransform(TransformName^ aTransformName)
+  TransformInfo^ TransformRepository::GetOriginalTransform(CoordinateFrameId fromId, CoordinateFrameId toId)
   {
-    std::wstring fromStr = std::wstring(aTransformName->From()->Data());
-    std::wstring toStr = std::wstring(aTransformName->To()->Data());
-    CoordFrameToTransformMapType& fromCoordFrame = this->m_CoordinateFrames[fromStr];
+    auto fromCoordFrameIt = this->m_CoordinateFrames.find(fromId);
+    if (fromCoordFrameIt == this->m_CoordinateFrames.end())
+    {
+      return nullptr;
+    }
+    CoordFrameToTransformMapType& fromCoordFrame = fromCoordFrameIt->second;
 
     // Check if the transform already exist
-    CoordFrameToTransformMapType::iterator fromToTransformInfoIt = fromCoordFrame.find(toStr);
+    CoordFrameToTransformMapType::iterator fromToTransformInfoIt = fromCoordFrame.find(toId);
     if (fromToTransformInfoIt != fromCoordFrame.end())
     {
       // transform is found
@@ -202,7 +205,7 @@ namespace UWPOpenIGTLink
       return false;
     }
 
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return false;
     }
@@ -210,7 +213,7 @@ namespace UWPOpenIGTLink
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
     // Check if the transform already exist
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName->FromId(), aTransformName->ToId());
     if (fromToTransformInfo != nullptr)
     {
       // Transform already exists
@@ -227,8 +230,7 @@ namespace UWPOpenIGTLink
       fromToTransformInfo->Valid = isValid;
 
       // Set the same status for the computed inverse transform
-      TransformName^ toFromTransformName = ref new TransformName(aTransformName->To(), aTransformName->From());
-      TransformInfo^ toFromTransformInfo = GetOriginalTransform(toFromTransformName);
+      TransformInfo^ toFromTransformInfo = GetOriginalTransform(aTransformName->ToId(), aTransformName->FromId());
       if (toFromTransformInfo == nullptr)
       {
         return false;
@@ -239,7 +241,7 @@ namespace UWPOpenIGTLink
     // The transform does not exist yet, add it now
 
     TransformInfoListType transformInfoList;
-    if (FindPath(aTransformName, transformInfoList, NULL, true /*silent*/))
+    if (FindPath(aTransformName->FromId(), aTransformName->ToId(), transformInfoList, INVALID_COORDINATE_FRAME_ID, true /*silent*/))
     {
       // a path already exist between the two coordinate frames
       // adding a new transform between these would result in a circle
@@ -247,21 +249,21 @@ namespace UWPOpenIGTLink
     }
 
     // Create the from->to transform
-    std::wstring fromStr(aTransformName->From()->Data());
-    std::wstring toStr(aTransformName->To()->Data());
-    CoordFrameToTransformMapType& fromCoordFrame = this->m_CoordinateFrames[fromStr];
-    fromCoordFrame[toStr] = ref new TransformInfo();
-    fromCoordFrame[toStr]->Computed = false;
-    fromCoordFrame[toStr]->Matrix = matrix;
-    fromCoordFrame[toStr]->Valid = isValid;
+    CoordinateFrameId fromId = aTransformName->FromId();
+    CoordinateFrameId toId = aTransformName->ToId();
+    CoordFrameToTransformMapType& fromCoordFrame = this->m_CoordinateFrames[fromId];
+    fromCoordFrame[toId] = ref new TransformInfo();
+    fromCoordFrame[toId]->Computed = false;
+    fromCoordFrame[toId]->Matrix = matrix;
+    fromCoordFrame[toId]->Valid = isValid;
 
     // Create the to->from inverse transform
-    CoordFrameToTransformMapType& toCoordFrame = this->m_CoordinateFrames[toStr];
-    toCoordFrame[fromStr] = ref new TransformInfo();
-    toCoordFrame[fromStr]->Computed = true;
+    CoordFrameToTransformMapType& toCoordFrame = this->m_CoordinateFrames[toId];
+    toCoordFrame[fromId] = ref new TransformInfo();
+    toCoordFrame[fromId]->Computed = true;
     invert(matrix, &matrix);
-    toCoordFrame[fromStr]->Matrix = matrix;
-    toCoordFrame[fromStr]->Valid = isValid;
+    toCoordFrame[fromId]->Matrix = matrix;
+    toCoordFrame[fromId]->Valid = isValid;
 
     return true;
   }
@@ -274,7 +276,7 @@ namespace UWPOpenIGTLink
       return false;
     }
 
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return false;
     }
@@ -282,7 +284,7 @@ namespace UWPOpenIGTLink
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
     // Check if the transform already exist
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName->FromId(), aTransformName->ToId());
     if (fromToTransformInfo != nullptr)
     {
       fromToTransformInfo->Valid = isValid;
@@ -297,7 +299,7 @@ namespace UWPOpenIGTLink
   {
     KeyValuePair<bool, float4x4>^ result = ref new KeyValuePair<bool, float4x4>(false, float4x4::identity());
 
-    if (aTransformName == nullptr || !aTransformName->IsValid() || aTransformName->From() == aTransformName->To())
+    if (aTransformName == nullptr || !aTransformName->IsValid() || aTransformName->FromId() == aTransformName->ToId())
     {
       return result;
     }
@@ -307,7 +309,7 @@ namespace UWPOpenIGTLink
     // Check if we can find the transform by combining the input transforms
     // To improve performance the already found paths could be stored in a map of transform name -> transformInfoList
     TransformInfoListType transformInfoList;
-    if (!FindPath(aTransformName, transformInfoList))
+    if (!FindPath(aTransformName->FromId(), aTransformName->ToId(), transformInfoList))
     {
       // the transform cannot be computed, error has been already logged by FindPath
       return result;
@@ -341,12 +343,12 @@ namespace UWPOpenIGTLink
   {
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return false;
     }
 
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName->FromId(), aTransformName->ToId());
     if (fromToTransformInfo != nullptr)
     {
       fromToTransformInfo->Persistent = isPersistent;
@@ -361,12 +363,12 @@ namespace UWPOpenIGTLink
   {
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return false;
     }
 
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName->FromId(), aTransformName->ToId());
     if (fromToTransformInfo != nullptr)
     {
       return fromToTransformInfo->Persistent;
@@ -380,12 +382,12 @@ namespace UWPOpenIGTLink
   {
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return false;
     }
 
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName->FromId(), aTransformName->ToId());
     if (fromToTransformInfo != nullptr)
     {
       fromToTransformInfo->Error = aError;
@@ -398,14 +400,14 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   double TransformRepository::GetTransformError(TransformName^ aTransformName)
   {
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return 0.0;
     }
 
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName->FromId(), aTransformName->ToId());
     if (fromToTransformInfo != nullptr)
     {
       return fromToTransformInfo->Error;
@@ -417,14 +419,14 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   bool TransformRepository::SetTransformDate(TransformName^ aTransformName, Platform::String^ aDate)
   {
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return false;
     }
 
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName->FromId(), aTransformName->ToId());
     if (fromToTransformInfo != nullptr)
     {
       fromToTransformInfo->Date = aDate;
@@ -437,14 +439,14 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   Platform::String^ TransformRepository::GetTransformDate(TransformName^ aTransformName)
   {
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return nullptr;
     }
 
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName->FromId(), aTransformName->ToId());
     if (fromToTransformInfo != nullptr)
     {
       return fromToTransformInfo->Date;
@@ -454,14 +456,14 @@ namespace UWPOpenIGTLink
   }
 
   //----------------------------------------------------------------------------
-  bool TransformRepository::FindPath(TransformName^ aTransformName, TransformInfoListType& transformInfoList, const wchar_t* skipCoordFrameName /*=NULL*/, bool silent /*=false*/)
+  bool TransformRepository::FindPath(CoordinateFrameId fromId, CoordinateFrameId toId, TransformInfoListType& transformInfoList, CoordinateFrameId skipId /*=INVALID_COORDINATE_FRAME_ID*/, bool silent /*=false*/)
   {
-    if (aTransformName->FromInternal() == aTransformName->ToInternal())
+    if (fromId == toId)
     {
       return false;
     }
 
-    TransformInfo^ fromToTransformInfo = GetOriginalTransform(aTransformName);
+    TransformInfo^ fromToTransformInfo = GetOriginalTransform(fromId, toId);
     if (fromToTransformInfo != nullptr)
     {
       // found a transform
@@ -469,20 +471,23 @@ namespace UWPOpenIGTLink
       return true;
     }
     // not found, so try to find a path through all the connected coordinate frames
-    CoordFrameToTransformMapType& fromCoordFrame = this->m_CoordinateFrames[aTransformName->FromInternal()];
-    for (CoordFrameToTransformMapType::iterator transformInfoIt = fromCoordFrame.begin(); transformInfoIt != fromCoordFrame.end(); ++transformInfoIt)
+    auto fromCoordFrameIt = this->m_CoordinateFrames.find(fromId);
+    if (fromCoordFrameIt != this->m_CoordinateFrames.end())
     {
-      if (skipCoordFrameName != NULL && transformInfoIt->first.compare(std::wstring(skipCoordFrameName)) == 0)
-      {
-        // coordinate frame shall be ignored
-        // (probably it would just go back to the previous coordinate frame where we come from)
-        continue;
-      }
-      TransformName^ newTransformName = ref new TransformName(transformInfoIt->first, aTransformName->ToInternal());
-      if (FindPath(newTransformName, transformInfoList, aTransformName->FromInternal().c_str(), true /*silent*/))
+      CoordFrameToTransformMapType& fromCoordFrame = fromCoordFrameIt->second;
+      for (CoordFrameToTransformMapType::iterator transformInfoIt = fromCoordFrame.begin(); transformInfoIt != fromCoordFrame.end(); ++transformInfoIt)
       {
-        transformInfoList.push_back(transformInfoIt->second);
-        return true;
+        if (skipId != INVALID_COORDINATE_FRAME_ID && transformInfoIt->first == skipId)
+        {
+          // coordinate frame shall be ignored
+          // (probably it would just go back to the previous coordinate frame where we come from)
+          continue;
+        }
+        if (FindPath(transformInfoIt->first, toId, transformInfoList, fromId, true /*silent*/))
+        {
+          transformInfoList.push_back(transformInfoIt->second);
+          return true;
+        }
       }
     }
     if (!silent)
@@ -508,15 +513,15 @@ namespace UWPOpenIGTLink
           {
             osAvailableTransforms << ", ";
           }
-          osAvailableTransforms << coordFrame.first << L"To" << transformInfo.first << L" ("
+          osAvailableTransforms << CoordinateFrameTable::Instance().GetName(coordFrame.first) << L"To" << CoordinateFrameTable::Instance().GetName(transformInfo.first) << L" ("
                                 << (transformInfo.second->Valid ? L"valid" : L"invalid") << ", "
                                 << (transformInfo.second->Persistent ? L"persistent" : L"non-persistent") << ")";
         }
       }
       OutputDebugStringW((L"Transform path not found from "
-                          + aTransformName->From()
+                          + ref new Platform::String(CoordinateFrameTable::Instance().GetName(fromId).c_str())
                           + L" to "
-                          + aTransformName->To()
+                          + ref new Platform::String(CoordinateFrameTable::Instance().GetName(toId).c_str())
                           + L" coordinate system. Available transforms in the repository (including the inverse of these transforms): "
                           + ref new Platform::String(osAvailableTransforms.str().c_str())
                           + L"\n")->Data());
@@ -528,7 +533,7 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   bool TransformRepository::IsExistingTransform(TransformName^ aTransformName, bool aSilent/* = true*/)
   {
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return true;
     }
@@ -536,24 +541,24 @@ namespace UWPOpenIGTLink
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
     TransformInfoListType transformInfoList;
-    return FindPath(aTransformName, transformInfoList, NULL, aSilent);
+    return FindPath(aTransformName->FromId(), aTransformName->ToId(), transformInfoList, INVALID_COORDINATE_FRAME_ID, aSilent);
   }
 
   //----------------------------------------------------------------------------
   bool TransformRepository::DeleteTransform(TransformName^ aTransformName)
   {
-    if (aTransformName->From() == aTransformName->To())
+    if (aTransformName->FromId() == aTransformName->ToId())
     {
       return false;
     }
 
     std::lock_guard<std::mutex> guard(m_CriticalSection);
 
-    std::wstring fromStr(aTransformName->From()->Data());
-    std::wstring toStr(aTransformName->To()->Data());
+    CoordinateFrameId fromId = aTransformName->FromId();
+    CoordinateFrameId toId = aTransformName->ToId();
 
-    CoordFrameToTransformMapType& fromCoordFrame = this->m_CoordinateFrames[fromStr];
-    CoordFrameToTransformMapType::iterator fromToTransformInfoIt = fromCoordFrame.find(toStr);
+    CoordFrameToTransformMapType& fromCoordFrame = this->m_CoordinateFrames[fromId];
+    CoordFrameToTransformMapType::iterator fromToTransformInfoIt = fromCoordFrame.find(toId);
 
     if (fromToTransformInfoIt != fromCoordFrame.end())
     {
@@ -570,8 +575,8 @@ namespace UWPOpenIGTLink
       return false;
     }
 
-    CoordFrameToTransformMapType& toCoordFrame = this->m_CoordinateFrames[toStr];
-    CoordFrameToTransformMapType::iterator toFromTransformInfoIt = toCoordFrame.find(fromStr);
+    CoordFrameToTransformMapType& toCoordFrame = this->m_CoordinateFrames[toId];
+    CoordFrameToTransformMapType::iterator toFromTransformInfoIt = toCoordFrame.find(fromId);
     if (toFromTransformInfoIt != toCoordFrame.end())
     {
       // to->from transform is found
@@ -757,8 +762,8 @@ namespace UWPOpenIGTLink
         // if copyAllTransforms is true => copy non persistent and persistent. if false => copy only persistent
         if ((transformInfo.second->Persistent || copyAllTransforms) && !transformInfo.second->Computed)
         {
-          const std::wstring& fromCoordinateFrame = coordFrame.first;
-          const std::wstring& toCoordinateFrame = transformInfo.first;
+          const std::wstring& fromCoordinateFrame = CoordinateFrameTable::Instance().GetName(coordFrame.first);
+          const std::wstring& toCoordinateFrame = CoordinateFrameTable::Instance().GetName(transformInfo.first);
           const float4x4& transform = transformInfo.second->Matrix;
           const std::wstring& persistent = transformInfo.second->Persistent ? L"true" : L"false";
           const std::wstring& valid = transformInfo.second->Valid ? L"true" : L"false";
@@ -86,9 +86,9 @@ namespace UWPOpenIGTLink
   public ref class TransformRepository sealed
   {
   protected private:
-    typedef std::map<std::wstring, TransformInfo^>                CoordFrameToTransformMapType;
-    typedef std::map<std::wstring, CoordFrameToTransformMapType>  CoordFrameToCoordFrameToTransformMapType;
-    typedef std::list<TransformInfo^>                             TransformInfoListType;
+    typedef std::map<CoordinateFrameId, TransformInfo^>                 CoordFrameToTransformMapType;
+    typedef std::map<CoordinateFrameId, CoordFrameToTransformMapType>   CoordFrameToCoordFrameToTransformMapType;
+    typedef std::list<TransformInfo^>                                   TransformInfoListType;
 
   public:
     TransformRepository();
@@ -194,17 +194,18 @@ namespace UWPOpenIGTLink
 
   protected private:
     /*! Get a user-defined original input transform (or its inverse). Does not combine user-defined input transforms. */
-    TransformInfo^ GetOriginalTransform(TransformName^ aTransformName);
+    TransformInfo^ GetOriginalTransform(CoordinateFrameId fromId, CoordinateFrameId toId);
 
     /*!
     Find a transform path between the specified coordinate frames.
-    \param aTransformName name of the transform to find
+    \param fromId interned id of the 'From' coordinate frame
+    \param toId interned id of the 'To' coordinate frame
     \param transformInfoList Stores the list of transforms to get from the fromCoordFrameName to toCoordFrameName
-    \param skipCoordFrameName This is the name of a coordinate system that should be ignored (e.g., because it was checked previously already)
+    \param skipId This is the id of a coordinate system that should be ignored (e.g., because it was checked previously already)
     \param silent Don't log an error if path cannot be found (it's normal while searching in branches of the graph)
     \return returns PLUS_SUCCESS if a path can be found, PLUS_FAIL otherwise
     */
-    bool FindPath(TransformName^ aTransformName, TransformInfoListType& transformInfoList, const wchar_t* skipCoordFrameName = NULL, bool silent = false);
+    bool FindPath(CoordinateFrameId fromId, CoordinateFrameId toId, TransformInfoListType& transformInfoList, CoordinateFrameId skipId = INVALID_COORDINATE_FRAME_ID, bool silent = false);
 
     CoordFrameToCoordFrameToTransformMapType  m_CoordinateFrames;
     std::mutex                                m_CriticalSection;
@@ -27,13 +27,31 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "IGTCommon.h"
 
+// System includes
+#include <DirectXMath.h>
+
 // STL includes
+#include <algorithm>
 #include <limits>
 
 using namespace Windows::Foundation::Numerics;
 
 namespace
 {
+  static const float NLERP_QUATERNION_DOT_THRESHOLD = 0.9995f; // above this quaternion dot product (about 3.6 deg apart) NLERP is used instead of SLERP, the difference is negligible
+
+  //----------------------------------------------------------------------------
+  // Scale, rotate, then translate (row vectors), transposed to column vector convention
+  float4x4 ComposeMatrixFromVectors(DirectX::FXMVECTOR scale, DirectX::FXMVECTOR rotation, DirectX::FXMVECTOR translation)
+  {
+    using namespace DirectX;
+
+    float4x4 result;
+    XMStoreFloat4x4(reinterpret_cast<XMFLOAT4X4*>(&result),
+                    XMMatrixTranspose(XMMatrixScalingFromVector(scale) * XMMatrixRotationQuaternion(rotation) * XMMatrixTranslationFromVector(translation)));
+    return result;
+  }
+
   //----------------------------------------------------------------------------
   bool compare_pred(std::string::value_type a, std::string::value_type b)
   {
@@ -182,4 +200,79 @@ namespace UWPOpenIGTLink
 
     return dot(aQuat, bQuat);
   }
+
+  //----------------------------------------------------------------------------
+  void DecomposeMatrix(const float4x4& matrix, float3& outScale, quaternion& outRotation, float3& outTranslation)
+  {
+    // decompose expects row vectors
+    if (!decompose(transpose(matrix), &outScale, &outRotation, &outTranslation))
+    {
+      outScale = float3::one();
+      outRotation = quaternion::identity();
+      outTranslation = float3(matrix.m14, matrix.m24, matrix.m34);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  float4x4 ComposeMatrix(const float3& scale, const quaternion& rotation, const float3& translation)
+  {
+    using namespace DirectX;
+
+    return ComposeMatrixFromVectors(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&scale)),
+                         XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&rotation)),
+                         XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&translation)));
+  }
+
+  //----------------------------------------------------------------------------
+  float4x4 InterpolateDecomposedMatrix(const float3& aScale, const quaternion& aRotation, const float3& aTranslation,
+                                       const float3& bScale, const quaternion& bRotation, const float3& bTranslation,
+                                       float itemBweight, float3& outScale, quaternion& outRotation, float3& outTranslation)
+  {
+    using namespace DirectX;
+
+    XMVECTOR aQuat = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&aRotation));
+    XMVECTOR bQuat = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bRotation));
+    XMVECTOR cosAngle = XMVector4Dot(aQuat, bQuat);
+    XMVECTOR rotation;
+    if (fabs(XMVectorGetX(cosAngle)) > NLERP_QUATERNION_DOT_THRESHOLD)
+    {
+      // Take the shorter arc, q and -q are the same orientation
+      bQuat = XMVectorSelect(bQuat, XMVectorNegate(bQuat), XMVectorLess(cosAngle, XMVectorZero()));
+      rotation = XMQuaternionNormalize(XMVectorLerp(aQuat, bQuat, itemBweight));
+    }
+    else
+    {
+      rotation = XMQuaternionSlerp(aQuat, bQuat, itemBweight);
+    }
+    XMVECTOR translation = XMVectorLerp(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&aTranslation)), XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&bTranslation)), itemBweight);
+    XMVECTOR scale = XMVectorLerp(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&aScale)), XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&bScale)), itemBweight);
+
+    XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&outRotation), rotation);
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&outTranslation), translation);
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&outScale), scale);
+
+    return ComposeMatrixFromVectors(scale, rotation, translation);
+  }
+
+  //----------------------------------------------------------------------------
+  float GetRotationAngleDeg(const quaternion& aRotation, const quaternion& bRotation)
+  {
+    float cosHalfAngle = (std::min)(fabs(dot(aRotation, bRotation)), 1.f);
+    return 2.f * acos(cosHalfAngle) * 180.f / DirectX::XM_PI;
+  }
+
+  //----------------------------------------------------------------------------
+  double GetMonotonicTimeSec()
+  {
+    static const double secondsPerCount = []()
+    {
+      LARGE_INTEGER frequency;
+      QueryPerformanceFrequency(&frequency);
+      return 1.0 / static_cast<double>(frequency.QuadPart);
+    }();
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return static_cast<double>(counter.QuadPart) * secondsPerCount;
+  }
 }
\ No newline at end of file
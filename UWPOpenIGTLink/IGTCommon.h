@@ -138,7 +138,8 @@ namespace UWPOpenIGTLink
   {
     EXACT_TIME, /*!< only returns the item if the requested timestamp exactly matches the timestamp of an existing element */
     INTERPOLATED, /*!< returns interpolated transform (requires valid transform at the requested timestamp) */
-    CLOSEST_TIME /*!< returns the closest item  */
+    CLOSEST_TIME, /*!< returns the closest item  */
+    EXTRAPOLATED /*!< as INTERPOLATED, and beyond the latest item returns the transform predicted with constant linear and angular velocity */
   };
 
   enum FIELD_STATUS
@@ -148,6 +149,9 @@ namespace UWPOpenIGTLink
   };
 
   static const double UNDEFINED_TIMESTAMP = (std::numeric_limits<double>::max)();
+  /// UNDEFINED_TIMESTAMP as passed in a float parameter (it does not fit a float, it arrives as infinity)
+  static const float UNDEFINED_TIMESTAMP_FLOAT = std::numeric_limits<float>::infinity();
+  inline bool IsUndefinedTimestamp(float timestamp) { return timestamp >= (std::numeric_limits<float>::max)(); }
 
   ref class Transform;
   typedef Windows::Foundation::Collections::IVector<Transform^> TransformListABI;
@@ -203,6 +207,54 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   float GetOrientationDifference(const Windows::Foundation::Numerics::float4x4& aMatrix, const Windows::Foundation::Numerics::float4x4& bMatrix);
 
+  /// Decomposed pose of a tool (see DecomposeMatrix), the compact form stored by the pose buffers
+  struct ToolPose
+  {
+    Windows::Foundation::Numerics::quaternion Rotation;
+    Windows::Foundation::Numerics::float3     Translation;
+    Windows::Foundation::Numerics::float3     Scale;
+  };
+
+  /// Result of a pose buffer temporal query
+  struct PoseBufferSample
+  {
+    BufferItemUidType                         Uid = 0;
+    uint32                                    Index = 0;
+    float                                     FilteredTimestamp = 0.f;    // local time
+    float                                     UnfilteredTimestamp = 0.f;  // local time
+    ToolPose                                  Pose;
+    Windows::Foundation::Numerics::float4x4   Matrix;
+    TOOL_STATUS                               Status = TOOL_MISSING;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Split a matrix (column vector convention, translation in the last column) into scale, rotation and translation
+  void DecomposeMatrix(const Windows::Foundation::Numerics::float4x4& matrix, Windows::Foundation::Numerics::float3& outScale,
+                       Windows::Foundation::Numerics::quaternion& outRotation, Windows::Foundation::Numerics::float3& outTranslation);
+
+  //----------------------------------------------------------------------------
+  /// Inverse of DecomposeMatrix
+  Windows::Foundation::Numerics::float4x4 ComposeMatrix(const Windows::Foundation::Numerics::float3& scale, const Windows::Foundation::Numerics::quaternion& rotation,
+      const Windows::Foundation::Numerics::float3& translation);
+
+  //----------------------------------------------------------------------------
+  /*!
+    Interpolate between two decomposed matrices: the rotation with NLERP (nearby orientations) or SLERP, the translation and scale linearly.
+    The components are interpolated in SIMD registers, the interpolated components are returned as well.
+  */
+  Windows::Foundation::Numerics::float4x4 InterpolateDecomposedMatrix(const Windows::Foundation::Numerics::float3& aScale, const Windows::Foundation::Numerics::quaternion& aRotation,
+      const Windows::Foundation::Numerics::float3& aTranslation, const Windows::Foundation::Numerics::float3& bScale,
+      const Windows::Foundation::Numerics::quaternion& bRotation, const Windows::Foundation::Numerics::float3& bTranslation, float itemBweight,
+      Windows::Foundation::Numerics::float3& outScale, Windows::Foundation::Numerics::quaternion& outRotation, Windows::Foundation::Numerics::float3& outTranslation);
+
+  //----------------------------------------------------------------------------
+  /// Angle between two orientations in degrees
+  float GetRotationAngleDeg(const Windows::Foundation::Numerics::quaternion& aRotation, const Windows::Foundation::Numerics::quaternion& bRotation);
+
+  //----------------------------------------------------------------------------
+  /// Seconds of a monotonic high resolution clock (QueryPerformanceCounter), unaffected by system time changes
+  double GetMonotonicTimeSec();
+
   //--------------------------------------------------------
   template<typename T>
   float VectorMean(const std::vector<T>& vec, T initialValue)
@@ -0,0 +1,214 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+/*
+  Test of ClockOffsetEstimator, driven with simulated probe round trips (no socket).
+  The remote clock runs at a fixed offset (seconds since the epoch against seconds since boot) and drift
+  from the local one, and each round trip has random, asymmetric delays in both directions.
+*/
+
+#include "pch.h"
+#include "ClockOffsetEstimator.h"
+#include "TestCommon.h"
+
+// STL includes
+#include <cmath>
+#include <random>
+
+using namespace UWPOpenIGTLink;
+
+namespace
+{
+  static const double REMOTE_CLOCK_OFFSET_SEC = 1.7e9;
+  static const double LOCAL_START_TIME_SEC = 1000.0;
+  static const double PROBE_INTERVAL_SEC = 1.0;
+
+  /// Simulated link: each direction has a fixed minimum delay plus exponentially distributed queuing delay
+  class SimulatedLink
+  {
+  public:
+    SimulatedLink(double driftPpm, double outboundDelaySec, double returnDelaySec, double jitterSec)
+      : m_drift(driftPpm * 1e-6)
+      , m_outboundDelay(outboundDelaySec)
+      , m_returnDelay(returnDelaySec)
+      , m_jitter(1.0 / jitterSec)
+      , m_generator(42)
+    {
+    }
+
+    double RemoteTime(double localTime) const
+    {
+      return REMOTE_CLOCK_OFFSET_SEC + localTime * (1.0 + m_drift);
+    }
+
+    double TrueOffset(double localTime) const
+    {
+      return RemoteTime(localTime) - localTime;
+    }
+
+    /// Probe sent at localSendTime, extraReturnDelaySec is added to the reply (e.g. a network spike)
+    bool Probe(ClockOffsetEstimator& estimator, double localSendTime, double extraReturnDelaySec = 0.0)
+    {
+      const double outbound = m_outboundDelay + m_jitter(m_generator);
+      const double inbound = m_returnDelay + m_jitter(m_generator) + extraReturnDelaySec;
+      return estimator.AddSample(localSendTime, RemoteTime(localSendTime + outbound), localSendTime + outbound + inbound);
+    }
+
+  protected:
+    double                                  m_drift;
+    double                                  m_outboundDelay;
+    double                                  m_returnDelay;
+    std::exponential_distribution<double>   m_jitter;
+    std::mt19937                            m_generator;
+  };
+
+  //----------------------------------------------------------------------------
+  void TestSymmetricDelays()
+  {
+    // Equal constant delays both ways: the midpoint is exact
+    ClockOffsetEstimator estimator;
+    CHECK(!estimator.HasEstimate());
+    CHECK(estimator.AddSample(LOCAL_START_TIME_SEC, REMOTE_CLOCK_OFFSET_SEC + LOCAL_START_TIME_SEC + 0.002, LOCAL_START_TIME_SEC + 0.004));
+    CHECK(estimator.HasEstimate());
+    CHECK(std::abs(estimator.GetOffsetSec(LOCAL_START_TIME_SEC) - REMOTE_CLOCK_OFFSET_SEC) < 1e-6);
+    CHECK(std::abs(estimator.GetUncertaintySec() - 0.002) < 1e-6);
+    CHECK(estimator.GetDriftPpm() == 0.0);
+  }
+
+  //----------------------------------------------------------------------------
+  void TestSkewedDelays()
+  {
+    // The reply takes 3 ms longer than the request, the offset is off by up to half the round trip, never more than the uncertainty
+    SimulatedLink link(0.0, 0.001, 0.004, 0.0005);
+    ClockOffsetEstimator estimator;
+    double time = LOCAL_START_TIME_SEC;
+    for (int i = 0; i < 100; ++i, time += PROBE_INTERVAL_SEC)
+    {
+      link.Probe(estimator, time);
+    }
+    const double error = std::abs(estimator.GetOffsetSec(time) - link.TrueOffset(time));
+    CHECK(error <= estimator.GetUncertaintySec());
+    CHECK(error < 0.0025);
+    CHECK(estimator.GetUncertaintySec() < 0.005);
+    CHECK(estimator.GetNumberOfSamples() == 64);
+  }
+
+  //----------------------------------------------------------------------------
+  void TestDrift()
+  {
+    // 50 ppm: the offset changes by 3 ms over the 64 s window, much more than the jitter
+    SimulatedLink link(50.0, 0.002, 0.002, 0.0005);
+    ClockOffsetEstimator estimator;
+    double time = LOCAL_START_TIME_SEC;
+    for (int i = 0; i < 300; ++i, time += PROBE_INTERVAL_SEC)
+    {
+      link.Probe(estimator, time);
+    }
+    CHECK(std::abs(estimator.GetDriftPpm() - 50.0) < 10.0);
+    CHECK(std::abs(estimator.GetOffsetSec(time) - link.TrueOffset(time)) <= estimator.GetUncertaintySec());
+
+    // Short extrapolation keeps following the drifting clock
+    const double later = time + 5.0;
+    CHECK(std::abs(estimator.GetOffsetSec(later) - link.TrueOffset(later)) <= estimator.GetUncertaintySec());
+  }
+
+  //----------------------------------------------------------------------------
+  void TestSpikes()
+  {
+    // Every 20th reply (9 in all) is held up by 200 ms, these round trips are rejected and do not bias the offset
+    SimulatedLink link(0.0, 0.002, 0.002, 0.001);
+    ClockOffsetEstimator estimator;
+    double time = LOCAL_START_TIME_SEC;
+    uint32 rejectedSpikes(0);
+    for (int i = 0; i < 200; ++i, time += PROBE_INTERVAL_SEC)
+    {
+      const bool spike = i >= 10 && i % 20 == 0;
+      if (!link.Probe(estimator, time, spike ? 0.2 : 0.0) && spike)
+      {
+        rejectedSpikes++;
+      }
+    }
+    CHECK(rejectedSpikes == 9);
+    // The tail of the regular jitter may occasionally be rejected too
+    CHECK(estimator.GetNumberOfRejectedSamples() < 15);
+    CHECK(std::abs(estimator.GetOffsetSec(time) - link.TrueOffset(time)) < 0.002);
+  }
+
+  //----------------------------------------------------------------------------
+  void TestRouteChange()
+  {
+    // A persistent increase of the delay is a new route, not a series of spikes
+    SimulatedLink link(0.0, 0.002, 0.002, 0.0005);
+    ClockOffsetEstimator estimator;
+    double time = LOCAL_START_TIME_SEC;
+    for (int i = 0; i < 64; ++i, time += PROBE_INTERVAL_SEC)
+    {
+      link.Probe(estimator, time);
+    }
+    bool acceptedAgain(false);
+    for (int i = 0; i < 64; ++i, time += PROBE_INTERVAL_SEC)
+    {
+      acceptedAgain = link.Probe(estimator, time, 0.1) || acceptedAgain;
+    }
+    CHECK(acceptedAgain);
+    CHECK(estimator.GetUncertaintySec() > 0.05);
+    CHECK(std::abs(estimator.GetOffsetSec(time) - link.TrueOffset(time)) <= estimator.GetUncertaintySec());
+  }
+
+  //----------------------------------------------------------------------------
+  void TestInvalidAndClear()
+  {
+    ClockOffsetEstimator estimator;
+    // Received before it was sent
+    CHECK(!estimator.AddSample(LOCAL_START_TIME_SEC, REMOTE_CLOCK_OFFSET_SEC, LOCAL_START_TIME_SEC - 0.001));
+    CHECK(!estimator.HasEstimate());
+    CHECK(estimator.GetNumberOfRejectedSamples() == 1);
+
+    CHECK(estimator.AddSample(LOCAL_START_TIME_SEC, REMOTE_CLOCK_OFFSET_SEC + LOCAL_START_TIME_SEC, LOCAL_START_TIME_SEC + 0.001));
+    estimator.Clear();
+    CHECK(!estimator.HasEstimate());
+    CHECK(estimator.GetNumberOfSamples() == 0);
+    CHECK(estimator.GetNumberOfRejectedSamples() == 0);
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  //----------------------------------------------------------------------------
+  int RunClockOffsetEstimatorTests()
+  {
+    const int previousFailures = Failures;
+
+    TestSymmetricDelays();
+    TestSkewedDelays();
+    TestDrift();
+    TestSpikes();
+    TestRouteChange();
+    TestInvalidAndClear();
+
+    return Failures - previousFailures;
+  }
+}
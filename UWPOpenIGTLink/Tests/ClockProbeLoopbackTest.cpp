@@ -0,0 +1,180 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+/*
+  Test of the IGTClient clock probe and reply path against a loopback server whose clock is skewed.
+  The server only answers requests: it replies to each GET_STATUS with a STATUS of the same device name, stamped
+  with its own clock, and sends nothing else. This is the quiet link clock synchronization exists for.
+*/
+
+#include "pch.h"
+#include "TestCommon.h"
+
+// IGTL includes
+#include <igtlMessageHeader.h>
+#include <igtlStatusMessage.h>
+#include <igtl_header.h>
+
+// STL includes
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+using namespace Concurrency;
+using namespace Windows::Foundation;
+using namespace Windows::Networking;
+using namespace Windows::Networking::Sockets;
+using namespace Windows::Storage::Streams;
+
+namespace
+{
+  static const double SERVER_CLOCK_SKEW_SEC = 1234.5;     // server clock - local monotonic clock
+  static const double MAXIMUM_OFFSET_ERROR_SEC = 0.005;   // loopback round trips are well below a millisecond
+  static const double SYNCHRONIZATION_WAIT_SEC = 6.0;     // probes are sent once per second
+  static const wchar_t* LOOPBACK_PORT = L"18950";
+
+  //----------------------------------------------------------------------------
+  // Same clock as UWPOpenIGTLink::GetMonotonicTimeSec, which the client estimates the server clock against
+  double GetMonotonicTimeSec()
+  {
+    static const double secondsPerCount = []()
+    {
+      LARGE_INTEGER frequency;
+      QueryPerformanceFrequency(&frequency);
+      return 1.0 / static_cast<double>(frequency.QuadPart);
+    }();
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return static_cast<double>(counter.QuadPart) * secondsPerCount;
+  }
+
+  //----------------------------------------------------------------------------
+  void ServeClockProbes(StreamSocket^ socket, std::shared_ptr<std::atomic<uint32>> numberOfReplies)
+  {
+    auto reader = ref new DataReader(socket->InputStream);
+    auto writer = ref new DataWriter(socket->OutputStream);
+    auto headerMsg = igtl::MessageHeader::New();
+
+    try
+    {
+      while (true)
+      {
+        headerMsg->InitBuffer();
+        if (create_task(reader->LoadAsync(IGTL_HEADER_SIZE)).get() != IGTL_HEADER_SIZE)
+        {
+          // Client disconnected
+          return;
+        }
+        reader->ReadBytes(Platform::ArrayReference<byte>(static_cast<byte*>(headerMsg->GetBufferPointer()), IGTL_HEADER_SIZE));
+        headerMsg->Unpack();
+
+        const uint32 bodySize = static_cast<uint32>(headerMsg->GetBodySizeToRead());
+        if (bodySize > 0)
+        {
+          if (create_task(reader->LoadAsync(bodySize)).get() != bodySize)
+          {
+            return;
+          }
+          reader->ReadBuffer(bodySize);
+        }
+
+        if (std::string(headerMsg->GetMessageType()) != "GET_STATUS")
+        {
+          continue;
+        }
+
+        auto timestamp = igtl::TimeStamp::New();
+        timestamp->SetTime(GetMonotonicTimeSec() + SERVER_CLOCK_SKEW_SEC);
+        auto statusMsg = igtl::StatusMessage::New();
+        statusMsg->SetDeviceName(headerMsg->GetDeviceName());
+        statusMsg->SetCode(igtl::StatusMessage::STATUS_OK);
+        statusMsg->SetTimeStamp(timestamp);
+        statusMsg->Pack();
+
+        writer->WriteBytes(Platform::ArrayReference<byte>(static_cast<byte*>(statusMsg->GetBufferPointer()), static_cast<uint32>(statusMsg->GetBufferSize())));
+        create_task(writer->StoreAsync()).get();
+        (*numberOfReplies)++;
+      }
+    }
+    catch (Platform::Exception^)
+    {
+      // Connection closed
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void TestSkewedServerClock()
+  {
+    // Shared with the connection handler, which outlives this function until the client has disconnected
+    auto numberOfReplies = std::make_shared<std::atomic<uint32>>(0);
+    auto listener = ref new StreamSocketListener();
+    listener->ConnectionReceived += ref new TypedEventHandler<StreamSocketListener^, StreamSocketListenerConnectionReceivedEventArgs^>(
+                                      [numberOfReplies](StreamSocketListener^ sender, StreamSocketListenerConnectionReceivedEventArgs^ args)
+    {
+      ServeClockProbes(args->Socket, numberOfReplies);
+    });
+    create_task(listener->BindServiceNameAsync(ref new Platform::String(LOOPBACK_PORT))).get();
+
+    auto client = ref new UWPOpenIGTLink::IGTClient();
+    client->ServerHost = ref new HostName(L"127.0.0.1");
+    client->ServerPort = ref new Platform::String(LOOPBACK_PORT);
+    client->ClockSynchronization = true;
+    const bool connected = create_task(client->ConnectAsync(2.0)).get();
+    CHECK(connected);
+    if (!connected)
+    {
+      delete listener;
+      return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(SYNCHRONIZATION_WAIT_SEC * 1000)));
+
+    // The probes must go out although the receiver pump is blocked waiting for a header the whole time
+    CHECK(*numberOfReplies >= 3);
+    CHECK(client->ClockSynchronized);
+    CHECK(std::abs(client->ClockOffsetSec - SERVER_CLOCK_SKEW_SEC) < MAXIMUM_OFFSET_ERROR_SEC);
+    CHECK(client->ClockOffsetUncertaintySec < MAXIMUM_OFFSET_ERROR_SEC);
+
+    client->Disconnect();
+    delete listener;
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  //----------------------------------------------------------------------------
+  int RunClockProbeLoopbackTests()
+  {
+    const int previousFailures = Failures;
+
+    TestSkewedServerClock();
+
+    return Failures - previousFailures;
+  }
+}
@@ -0,0 +1,50 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+
+Modified by Adam Rankin, Robarts Research Institute, 2017
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+=========================================================Plus=header=end*/
+
+/*
+  Console test runner of the library, returns the number of failed checks.
+  Deploy the package, then run UWPOpenIGTLinkTests.exe from a command prompt (the package registers the alias).
+*/
+
+#include "pch.h"
+#include "TestCommon.h"
+
+namespace UWPOpenIGTLinkTests
+{
+  int Failures = 0;
+}
+
+//----------------------------------------------------------------------------
+[Platform::MTAThread]
+int main(Platform::Array<Platform::String^>^ args)
+{
+  using namespace UWPOpenIGTLinkTests;
+
+  std::cout << "ClockOffsetEstimator: " << (RunClockOffsetEstimatorTests() == 0 ? "passed" : "failed") << std::endl;
+  std::cout << "Clock probe loopback: " << (RunClockProbeLoopbackTests() == 0 ? "passed" : "failed") << std::endl;
+
+  return Failures;
+}